@@ -0,0 +1,194 @@
+// src/AsyncConsole.cpp
+// Lock-free MPSC byte ring + drain thread behind the console sink (see AsyncConsole.h).
+//
+// Ring records are [uint32 len|flags][uint32 unused][payload + '\n'], 8-byte aligned.
+// Producers reserve space with a CAS on `reserve`, copy the payload, then publish the
+// header with a release store. The drain thread consumes committed records in order,
+// zeroes the consumed bytes (so stale data never looks committed) and advances `tail`.
+
+#include "AsyncConsole.h"
+
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <vector>
+#include <cstdio>
+#include <cstring>
+
+namespace {
+
+    static constexpr uint32_t kCommit = 0x80000000u;
+    static constexpr uint32_t kPad = 0x40000000u;      // filler up to the ring end
+    static constexpr uint32_t kLenMask = 0x3FFFFFFFu;
+    static constexpr size_t kHdr = 8;
+
+    static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t), "atomic<uint32_t> must be plain-sized");
+
+    static inline size_t round8(size_t n) { return (n + 7) & ~static_cast<size_t>(7); }
+
+    static size_t pow2_at_least(size_t n) {
+        size_t p = 64u << 10;
+        while (p < n) p <<= 1;
+        return p;
+    }
+
+    struct Impl {
+        AsyncConsole::Config cfg;
+        std::unique_ptr<uint64_t[]> storage;    // 8-byte aligned, zero-initialised
+        uint8_t* ring = nullptr;
+        size_t cap = 0;
+        size_t mask = 0;
+
+        alignas(64) std::atomic<uint64_t> reserve{ 0 };   // producers
+        alignas(64) std::atomic<uint64_t> tail{ 0 };      // drain thread
+        alignas(64) std::atomic<uint64_t> drops{ 0 };
+        std::atomic<uint64_t> written{ 0 };
+
+        std::thread th;
+        std::atomic<bool> running{ false };
+        std::vector<char> out;                  // drain-side write buffer
+
+        std::atomic<uint32_t>* hdr_at(size_t pos) {
+            return reinterpret_cast<std::atomic<uint32_t>*>(ring + pos);
+        }
+    };
+
+    static void report_drops(Impl* I, uint64_t& reported) {
+        uint64_t d = I->drops.load(std::memory_order_relaxed);
+        if (d == reported) return;
+        std::fprintf(stderr, "[CONSOLE] dropped %llu lines (buffer full, +%llu)\n",
+            static_cast<unsigned long long>(d), static_cast<unsigned long long>(d - reported));
+        reported = d;
+    }
+
+    // Move committed records into `out`, release their ring space. Returns bytes gathered.
+    static size_t gather(Impl* I) {
+        uint64_t t = I->tail.load(std::memory_order_relaxed);
+        const uint64_t r = I->reserve.load(std::memory_order_acquire);
+        size_t outn = 0;
+        while (t != r) {
+            size_t pos = static_cast<size_t>(t & I->mask);
+            uint32_t h = I->hdr_at(pos)->load(std::memory_order_acquire);
+            if (!(h & kCommit)) break;          // reserved, payload not published yet
+            size_t len = h & kLenMask;
+            if (h & kPad) {
+                std::memset(I->ring + pos, 0, len);
+                t += len;
+                continue;
+            }
+            if (outn && outn + len > I->out.size()) break;
+            if (len > I->out.size()) I->out.resize(len);
+            std::memcpy(I->out.data() + outn, I->ring + pos + kHdr, len);
+            outn += len;
+            size_t rec = kHdr + round8(len);
+            std::memset(I->ring + pos, 0, rec);
+            t += rec;
+        }
+        I->tail.store(t, std::memory_order_release);
+        return outn;
+    }
+
+    static void drain_loop(Impl* I) {
+        using clock = std::chrono::steady_clock;
+        uint64_t reported = 0;
+        auto last_report = clock::now();
+        while (true) {
+            size_t n = gather(I);
+            if (n) {
+                std::fwrite(I->out.data(), 1, n, stdout);
+                std::fflush(stdout);
+                I->written.fetch_add(n, std::memory_order_relaxed);
+            }
+            auto now = clock::now();
+            if (now - last_report >= std::chrono::milliseconds(I->cfg.drop_report_ms)) {
+                report_drops(I, reported);
+                last_report = now;
+            }
+            if (n) continue;
+            if (!I->running.load(std::memory_order_acquire)) {
+                if (I->tail.load() == I->reserve.load()) break;   // fully drained
+                continue;
+            }
+            std::this_thread::sleep_for(std::chrono::microseconds(I->cfg.idle_sleep_us));
+        }
+        report_drops(I, reported);
+    }
+
+} // namespace anon
+
+AsyncConsole::AsyncConsole() {
+    impl_ = new Impl();
+}
+
+AsyncConsole::~AsyncConsole() {
+    try { stop(); }
+    catch (...) {}
+    if (impl_) { delete reinterpret_cast<Impl*>(impl_); impl_ = nullptr; }
+}
+
+void AsyncConsole::start(const Config& cfg) {
+    Impl* I = reinterpret_cast<Impl*>(impl_);
+    if (I->running.load()) return;
+    I->cfg = cfg;
+    I->cap = pow2_at_least(cfg.buffer_bytes);
+    I->mask = I->cap - 1;
+    I->storage.reset(new uint64_t[I->cap / sizeof(uint64_t)]());
+    I->ring = reinterpret_cast<uint8_t*>(I->storage.get());
+    I->reserve.store(0);
+    I->tail.store(0);
+    I->out.assign(cfg.write_chunk ? cfg.write_chunk : (256u << 10), '\0');
+    I->running.store(true);
+    I->th = std::thread([I]() { drain_loop(I); });
+}
+
+void AsyncConsole::stop() {
+    if (!impl_) return;
+    Impl* I = reinterpret_cast<Impl*>(impl_);
+    if (!I->running.load()) return;
+    I->running.store(false, std::memory_order_release);
+    if (I->th.joinable()) I->th.join();
+}
+
+bool AsyncConsole::write(std::string_view line) {
+    Impl* I = reinterpret_cast<Impl*>(impl_);
+    if (!I->ring) return false;
+
+    const size_t n = line.size() + 1;
+    const size_t need = kHdr + round8(n);
+    if (need > I->cap / 2) { I->drops.fetch_add(1, std::memory_order_relaxed); return false; }
+
+    uint64_t head = I->reserve.load(std::memory_order_relaxed);
+    size_t pos, contig;
+    for (;;) {
+        pos = static_cast<size_t>(head & I->mask);
+        contig = I->cap - pos;
+        const size_t total = (contig < need) ? contig + need : need;
+        const uint64_t tail = I->tail.load(std::memory_order_acquire);
+        if (head + total - tail > I->cap) {
+            I->drops.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        if (I->reserve.compare_exchange_weak(head, head + total,
+            std::memory_order_acq_rel, std::memory_order_relaxed)) break;
+    }
+
+    if (contig < need) {
+        I->hdr_at(pos)->store(static_cast<uint32_t>(contig) | kCommit | kPad, std::memory_order_release);
+        pos = 0;
+    }
+    std::memcpy(I->ring + pos + kHdr, line.data(), line.size());
+    I->ring[pos + kHdr + line.size()] = '\n';
+    I->hdr_at(pos)->store(static_cast<uint32_t>(n) | kCommit, std::memory_order_release);
+    return true;
+}
+
+uint64_t AsyncConsole::dropped() const {
+    Impl* I = reinterpret_cast<Impl*>(impl_);
+    return I->drops.load(std::memory_order_relaxed);
+}
+
+uint64_t AsyncConsole::written_bytes() const {
+    Impl* I = reinterpret_cast<Impl*>(impl_);
+    return I->written.load(std::memory_order_relaxed);
+}
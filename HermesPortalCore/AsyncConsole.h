@@ -0,0 +1,41 @@
+#pragma once
+// AsyncConsole: buffered asynchronous stdout writer for the console sink (--debug / console mode)
+// Decode lanes append lines into a lock-free multi-producer byte ring; one background thread
+// drains it to stdout with large writes. When the ring is full the line is dropped (never
+// blocks the decode thread) and the drop counter is reported on stderr.
+
+#include <string_view>
+#include <cstdint>
+#include <cstddef>
+
+class AsyncConsole {
+public:
+    struct Config {
+        size_t buffer_bytes = 8u << 20;         // ring capacity (rounded up to a power of two)
+        size_t write_chunk = 256u << 10;        // max bytes per stdout write
+        unsigned idle_sleep_us = 200;           // drain thread sleep when the ring is empty
+        unsigned drop_report_ms = 1000;         // min interval between drop reports
+    };
+
+    AsyncConsole();
+    ~AsyncConsole();
+
+    // allocate the ring and start the drain thread
+    void start(const Config& cfg);
+    void start() { start(Config{}); }
+
+    // drain what is queued, stop the thread and report drops
+    void stop();
+
+    // Append one line (newline added). Lock-free, never blocks; false when dropped (ring full).
+    bool write(std::string_view line);
+
+    uint64_t dropped() const;
+    uint64_t written_bytes() const;
+
+private:
+    void* impl_; // opaque pointer to implementation
+
+    AsyncConsole(const AsyncConsole&) = delete;
+    AsyncConsole& operator=(const AsyncConsole&) = delete;
+};
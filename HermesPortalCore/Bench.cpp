@@ -0,0 +1,420 @@
+// src/Bench.cpp
+// Offline output-path benchmarks (see Bench.h).
+
+#include "Bench.h"
+#include "FileWriter.h"
+#include "UringWriter.h"
+#include "TickStore.h"
+#include "SocketRelay.h"
+#include "includes/hermes_core.h"
+
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <algorithm>
+#include <cstring>
+#include <cstdio>
+
+#ifndef _WIN32
+#include <sys/un.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+#endif
+
+namespace {
+
+    struct FileBenchConfig {
+        std::string dir;
+        size_t lines = 1000000;
+        size_t tokens = 2000;
+        size_t shards = 1;
+        FileWriter::HistFormat format = FileWriter::HistFormat::Text;
+        std::vector<FileWriter::Durability> durability{ FileWriter::Durability::None };
+        unsigned sync_ms = 1000;                // Periodic
+    };
+
+    struct SocketBenchConfig {
+        size_t lines = 1000000;
+        size_t clients = 1;
+        size_t rate = 0;                        // lines/s, 0 => as fast as possible
+        std::string unix_path = "/tmp/hermes-bench.sock";
+    };
+
+    // 7208-shaped line (same width as the real handler output)
+    static std::string make_line(uint32_t token, size_t seq) {
+        std::string s = std::to_string(token);
+        s += ",7208,";
+        s += std::to_string(100 + (seq % 100));
+        s += ".00,99.99,100.00,1,100.05,6,0,0,1715513000,100.00,1,100.01,2,100.02,3,100.03,4,"
+            "100.04,5,100.05,6,100.06,7,100.07,8,100.08,9,100.09,10";
+        return s;
+    }
+
+    static const char* format_name(FileWriter::HistFormat f) {
+        return f == FileWriter::HistFormat::LzoBlocks ? "lzo" : f == FileWriter::HistFormat::Columnar ? "columnar" : "text";
+    }
+
+    static const char* durability_name(FileWriter::Durability d) {
+        switch (d) {
+        case FileWriter::Durability::Periodic: return "periodic";
+        case FileWriter::Durability::Batch: return "batch";
+        case FileWriter::Durability::DSync: return "dsync";
+        default: return "none";
+        }
+    }
+
+    // what a backtest does with the columnar output: map the day, walk every token's LTP
+    static void read_ticks(const FileBenchConfig& cfg, const std::string& base) {
+        auto t0 = std::chrono::steady_clock::now();
+        TickStore::DayReader day;
+        if (!day.open(base, TickStore::day_of(1715513000u), "7208")) {
+            std::cout << "[BENCH] columnar read: no segments\n";
+            return;
+        }
+        uint64_t rows = 0;
+        int64_t sum = 0;
+        for (size_t t = 0; t < cfg.tokens; ++t) {
+            rows += day.scan(static_cast<uint32_t>(35001 + t), 0, UINT32_MAX,
+                [&](const TickStore::Segment& s, uint32_t b, uint32_t e) {
+                    const int32_t* ltp = s.column<int32_t>("ltp");
+                    for (uint32_t r = b; r < e; ++r) sum += ltp[r];
+                });
+        }
+        double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+        std::ostringstream ss;
+        ss << std::fixed << std::setprecision(1)
+            << "[BENCH] columnar read segments=" << day.segments() << " rows=" << rows
+            << " time=" << sec * 1000.0 << "ms rate=" << (rows / sec / 1e6) << "M rows/s (ltp sum " << sum << ")\n";
+        std::cout << ss.str();
+    }
+
+    static void run_one(const FileBenchConfig& cfg, FileWriter::IoBackend io, const char* name, FileWriter::Durability dur) {
+        std::string sub = name;
+        if (dur != FileWriter::Durability::None) sub = sub + "-" + durability_name(dur);
+        std::filesystem::path dir = std::filesystem::path(cfg.dir) / sub;
+        std::error_code ec;
+        std::filesystem::remove_all(dir, ec);
+
+        // pre-format so the run measures FileWriter, not string building
+        std::vector<std::string> lines;
+        lines.reserve(cfg.tokens);
+        for (size_t t = 0; t < cfg.tokens; ++t) lines.push_back(make_line(static_cast<uint32_t>(35001 + t), t));
+
+        FileWriter fw;
+        fw.set_overflow_policy(FileWriter::Overflow::Block);    // measure throughput, never drop
+        fw.set_shards(cfg.shards);
+        fw.set_io_backend(io);
+        fw.set_hist_format(cfg.format);
+        fw.set_durability(dur, cfg.sync_ms);
+        // lzo keeps a data and an index file per token
+        fw.set_max_open_files((cfg.format == FileWriter::HistFormat::LzoBlocks ? 2 : 1) * cfg.tokens + 64);
+        fw.start(dir.string());
+
+        uint64_t bytes = 0;
+        auto t0 = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < cfg.lines; ++i) {
+            const size_t t = i % cfg.tokens;
+            RecordMeta m;
+            m.token = static_cast<uint32_t>(35001 + t);
+            m.type = 7208;
+            m.exch_time = static_cast<uint32_t>(1715513000 + i / cfg.tokens);
+            fw.enqueue(m, lines[t]);
+            bytes += lines[t].size() + 1;
+        }
+        fw.stop();
+        auto t1 = std::chrono::steady_clock::now();
+
+        double sec = std::chrono::duration<double>(t1 - t0).count();
+        uint64_t p50 = 0, p99 = 0, pmax = 0;    // worst shard
+        for (const auto& s : fw.stats()) {
+            p50 = std::max(p50, s.commit_p50_us);
+            p99 = std::max(p99, s.commit_p99_us);
+            pmax = std::max(pmax, s.commit_max_us);
+        }
+        std::ostringstream ss;
+        ss << std::fixed << std::setprecision(1)
+            << "[BENCH] file io=" << name << " lines=" << cfg.lines << " tokens=" << cfg.tokens
+            << " shards=" << cfg.shards
+            << " format=" << format_name(cfg.format) << " durability=" << durability_name(dur)
+            << " time=" << sec * 1000.0 << "ms"
+            << " rate=" << (cfg.lines / sec / 1000.0) << "k lines/s"
+            << " (" << (bytes / sec / (1024.0 * 1024.0)) << " MB/s csv in)"
+            << " commit_us p50=" << p50 << " p99=" << p99 << " max=" << pmax << "\n";
+        std::cout << ss.str();
+        fw.print_stats(std::cout);
+        if (cfg.format == FileWriter::HistFormat::Columnar) read_ticks(cfg, dir.string());
+    }
+
+    // ----------------- socket transports -----------------
+    // process CPU time (all threads: producer, relay loop, readers)
+    static double cpu_seconds() {
+#ifdef _WIN32
+        FILETIME c, e, k, u;
+        if (!GetProcessTimes(GetCurrentProcess(), &c, &e, &k, &u)) return 0;
+        auto f = [](const FILETIME& t) { return ((static_cast<uint64_t>(t.dwHighDateTime) << 32) | t.dwLowDateTime) / 1e7; };
+        return f(k) + f(u);
+#else
+        rusage ru{};
+        getrusage(RUSAGE_SELF, &ru);
+        return ru.ru_utime.tv_sec + ru.ru_stime.tv_sec + (ru.ru_utime.tv_usec + ru.ru_stime.tv_usec) / 1e6;
+#endif
+    }
+
+    static uint64_t now_ns() {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+    }
+
+    struct Reader {
+        std::thread th;
+        uint64_t lines = 0, bytes = 0;
+        uint64_t last_rx_ns = 0;
+        std::vector<uint32_t> lat_us;           // every 16th line
+        bool ok = false;
+    };
+
+    // Connect, AUTH, then count lines until the producer is done and the stream goes quiet.
+    // Lines carry the steady-clock send time in field 3 (see run_socket_one).
+    static void read_stream(SocketRelay::Transport tr, uint16_t port, const std::string& path,
+        const std::atomic<bool>& done, Reader& r) {
+#ifdef _WIN32
+        SOCKET s = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+        if (s == INVALID_SOCKET) return;
+        (void)path; (void)tr;
+        sockaddr_in a{};
+        a.sin_family = AF_INET;
+        a.sin_port = htons(port);
+        inet_pton(AF_INET, "127.0.0.1", &a.sin_addr);
+        if (connect(s, reinterpret_cast<sockaddr*>(&a), sizeof(a)) != 0) { closesocket(s); return; }
+        DWORD tmo = 200;
+        setsockopt(s, SOL_SOCKET, SO_RCVTIMEO, reinterpret_cast<const char*>(&tmo), sizeof(tmo));
+#else
+        int s;
+        if (tr == SocketRelay::Transport::Tcp) {
+            s = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+            sockaddr_in a{};
+            a.sin_family = AF_INET;
+            a.sin_port = htons(port);
+            inet_pton(AF_INET, "127.0.0.1", &a.sin_addr);
+            if (s < 0 || connect(s, reinterpret_cast<sockaddr*>(&a), sizeof(a)) != 0) { if (s >= 0) close(s); return; }
+        }
+        else {
+            s = socket(AF_UNIX, tr == SocketRelay::Transport::UnixSeqpacket ? SOCK_SEQPACKET : SOCK_STREAM, 0);
+            sockaddr_un a{};
+            a.sun_family = AF_UNIX;
+            std::strncpy(a.sun_path, path.c_str(), sizeof(a.sun_path) - 1);
+            if (s < 0 || connect(s, reinterpret_cast<sockaddr*>(&a), sizeof(a)) != 0) { if (s >= 0) close(s); return; }
+        }
+        timeval tmo{ 0, 200000 };
+        setsockopt(s, SOL_SOCKET, SO_RCVTIMEO, &tmo, sizeof(tmo));
+#endif
+        const char auth[] = "AUTH bench\n";
+        send(s, auth, static_cast<int>(sizeof(auth) - 1), 0);
+
+        std::vector<char> buf(256 * 1024);
+        std::string carry;
+        bool authed = false;
+        while (true) {
+            int n = static_cast<int>(recv(s, buf.data(), static_cast<int>(buf.size()), 0));
+            if (n <= 0) {
+                if (n < 0 && !done.load()) continue;   // timeout while the producer still runs
+                break;
+            }
+            const uint64_t rx = now_ns();
+            carry.append(buf.data(), static_cast<size_t>(n));
+            size_t pos = 0, nl;
+            while ((nl = carry.find('\n', pos)) != std::string::npos) {
+                if (!authed) {
+                    authed = carry.compare(pos, 3, "OK\n") == 0;
+                    if (!authed) break;
+                    r.ok = true;
+                }
+                else {
+                    ++r.lines;
+                    if ((r.lines & 15) == 0) {
+                        // token,7208,<send_ns>,...
+                        size_t c1 = carry.find(',', pos);
+                        size_t c2 = (c1 == std::string::npos) ? c1 : carry.find(',', c1 + 1);
+                        if (c2 != std::string::npos && c2 < nl) {
+                            uint64_t sent = std::strtoull(carry.c_str() + c2 + 1, nullptr, 10);
+                            if (sent && rx > sent) r.lat_us.push_back(static_cast<uint32_t>(std::min<uint64_t>((rx - sent) / 1000, UINT32_MAX)));
+                        }
+                    }
+                }
+                pos = nl + 1;
+            }
+            if (!authed && pos == 0 && carry.size() > 64) break;
+            carry.erase(0, pos);
+            r.bytes += static_cast<uint64_t>(n);
+            r.last_rx_ns = rx;
+        }
+#ifdef _WIN32
+        closesocket(s);
+#else
+        close(s);
+#endif
+    }
+
+    static const char* transport_name(SocketRelay::Transport t) {
+        return t == SocketRelay::Transport::UnixStream ? "unix" : t == SocketRelay::Transport::UnixSeqpacket ? "seqpacket" : "tcp";
+    }
+
+    static void run_socket_one(const SocketBenchConfig& cfg, SocketRelay::Transport tr) {
+        SocketRelay::Config rc;
+        rc.transport = tr;
+        rc.unix_path = cfg.unix_path;
+        rc.auth_token = "bench";
+        rc.max_clients = cfg.clients + 1;
+        rc.max_queue = 1 << 20;
+        rc.ring_bytes = 64u << 20;
+        rc.snapshot_slots = 0;
+        SocketRelay relay(rc);
+        try { relay.start(); }
+        catch (const std::exception& e) {
+            std::cout << "[BENCH] socket transport=" << transport_name(tr) << ": " << e.what() << "\n";
+            return;
+        }
+
+        std::atomic<bool> done{ false };
+        std::vector<Reader> readers(cfg.clients);
+        for (auto& r : readers) r.th = std::thread(read_stream, tr, relay.listening_port(), cfg.unix_path, std::cref(done), std::ref(r));
+        auto wait_until = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        while (relay.clients() < cfg.clients && std::chrono::steady_clock::now() < wait_until) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+        static const char* tail = "99.99,100.00,1,100.05,6,0,0,1715513000,100.00,1,100.01,2,100.02,3,100.03,4,"
+            "100.04,5,100.05,6,100.06,7,100.07,8,100.08,9,100.09,10";
+        char line[256];
+        const double cpu0 = cpu_seconds();
+        const uint64_t t0 = now_ns();
+        for (size_t i = 0; i < cfg.lines; ++i) {
+            if (cfg.rate && (i % 256) == 0) {
+                const uint64_t due = t0 + static_cast<uint64_t>(i * 1e9 / cfg.rate);
+                const uint64_t now = now_ns();     // sleep, not spin: cpu= should show the relay, not the pacing
+                if (now < due) std::this_thread::sleep_for(std::chrono::nanoseconds(due - now));
+            }
+            RecordMeta m;
+            m.token = static_cast<uint32_t>(35001 + i % 2000);
+            m.type = 7208;
+            int n = std::snprintf(line, sizeof(line), "%u,7208,%llu,%s", m.token, static_cast<unsigned long long>(now_ns()), tail);
+            relay.notify(m, std::string_view(line, static_cast<size_t>(n)));
+        }
+        done.store(true);
+        for (auto& r : readers) r.th.join();
+        const double cpu = cpu_seconds() - cpu0;
+        uint64_t dropped = 0;
+        for (const auto& c : relay.stats()) dropped += c.dropped;
+        relay.stop();
+
+        uint64_t lines = 0, bytes = 0, t1 = t0;
+        std::vector<uint32_t> lat;
+        for (const auto& r : readers) {
+            lines += r.lines;
+            bytes += r.bytes;
+            t1 = std::max(t1, r.last_rx_ns);
+            lat.insert(lat.end(), r.lat_us.begin(), r.lat_us.end());
+        }
+        std::sort(lat.begin(), lat.end());
+        auto pct = [&](double q) { return lat.empty() ? 0u : lat[std::min(lat.size() - 1, static_cast<size_t>(q * lat.size()))]; };
+        const double sec = std::max(1e-9, (t1 - t0) / 1e9);
+        std::ostringstream ss;
+        ss << std::fixed << std::setprecision(1)
+            << "[BENCH] socket transport=" << transport_name(tr) << " clients=" << cfg.clients << " lines=" << cfg.lines
+            << " pace=" << (cfg.rate ? std::to_string(cfg.rate) + "/s" : std::string("max"))
+            << " received=" << lines << " dropped=" << dropped
+            << " time=" << sec * 1000.0 << "ms rate=" << (lines / sec / 1000.0) << "k lines/s"
+            << " (" << (bytes / sec / (1024.0 * 1024.0)) << " MB/s)"
+            << " latency_us p50=" << pct(0.50) << " p99=" << pct(0.99) << " max=" << (lat.empty() ? 0u : lat.back())
+            << " cpu=" << cpu * 1000.0 << "ms (" << (lines ? cpu * 1e9 / lines : 0.0) << "ns/line)\n";
+        std::cout << ss.str();
+    }
+
+    static int run_socket_bench(const SocketBenchConfig& cfg) {
+        if (!cfg.lines || !cfg.clients) {
+            std::cerr << "[FATAL] --bench-socket needs lines and clients > 0\n";
+            return 1;
+        }
+        run_socket_one(cfg, SocketRelay::Transport::Tcp);
+#ifndef _WIN32
+        run_socket_one(cfg, SocketRelay::Transport::UnixStream);
+        run_socket_one(cfg, SocketRelay::Transport::UnixSeqpacket);
+#else
+        std::cout << "[BENCH] Unix transports are POSIX only; skipped\n";
+#endif
+        return 0;
+    }
+
+    static int run_file_bench(const FileBenchConfig& cfg) {
+        if (cfg.dir.empty() || !cfg.lines || !cfg.tokens) {
+            std::cerr << "[FATAL] --bench-file needs a directory, and lines/tokens > 0\n";
+            return 1;
+        }
+        if (cfg.format == FileWriter::HistFormat::LzoBlocks && !Lzo::Init()) {
+            std::cerr << "[FATAL] LZO init failed\n";
+            return 1;
+        }
+        const bool uring = UringWriter::supported();
+        if (!uring) std::cout << "[BENCH] io_uring not available on this system; skipped\n";
+        for (FileWriter::Durability d : cfg.durability) {
+            run_one(cfg, FileWriter::IoBackend::Blocking, "blocking", d);
+            if (uring) run_one(cfg, FileWriter::IoBackend::IoUring, "uring", d);
+        }
+        return 0;
+    }
+
+} // namespace anon
+
+int RunBench(int argc, char* argv[]) {
+    FileBenchConfig fcfg;
+    SocketBenchConfig scfg;
+    bool file = false, sock = false;
+    for (int i = 1; i < argc; ++i) {
+        std::string key = argv[i];
+        std::string val;
+        auto eq = key.find('=');
+        if (eq != std::string::npos) { val = key.substr(eq + 1); key = key.substr(0, eq); }
+        auto next = [&]() { if (val.empty() && i + 1 < argc) val = argv[++i]; return val; };
+        try {
+            if (key == "--bench-file") { file = true; fcfg.dir = next(); }
+            else if (key == "--bench-socket") sock = true;
+            else if (key == "--bench-lines") fcfg.lines = scfg.lines = static_cast<size_t>(std::stoull(next()));
+            else if (key == "--bench-clients") scfg.clients = static_cast<size_t>(std::stoull(next()));
+            else if (key == "--bench-rate") scfg.rate = static_cast<size_t>(std::stoull(next()));
+            else if (key == "--bench-unix-path") scfg.unix_path = next();
+            else if (key == "--bench-tokens") fcfg.tokens = static_cast<size_t>(std::stoull(next()));
+            else if (key == "--file-shards") fcfg.shards = static_cast<size_t>(std::stoull(next()));
+            else if (key == "--file-format") {
+                std::string f = next();
+                if (f == "lzo") fcfg.format = FileWriter::HistFormat::LzoBlocks;
+                else if (f == "columnar") fcfg.format = FileWriter::HistFormat::Columnar;
+                else if (f == "text") fcfg.format = FileWriter::HistFormat::Text;
+                else { std::cerr << "[FATAL] invalid value for --file-format: " << f << " (text|lzo|columnar)\n"; return 1; }
+            }
+            else if (key == "--file-durability") {
+                std::string d = next();
+                if (d == "none") fcfg.durability = { FileWriter::Durability::None };
+                else if (d == "periodic") fcfg.durability = { FileWriter::Durability::Periodic };
+                else if (d == "batch") fcfg.durability = { FileWriter::Durability::Batch };
+                else if (d == "dsync") fcfg.durability = { FileWriter::Durability::DSync };
+                else if (d == "all") fcfg.durability = { FileWriter::Durability::None, FileWriter::Durability::Periodic,
+                    FileWriter::Durability::Batch, FileWriter::Durability::DSync };
+                else { std::cerr << "[FATAL] invalid value for --file-durability: " << d << " (none|periodic|batch|dsync|all)\n"; return 1; }
+            }
+            else if (key == "--file-sync-ms") fcfg.sync_ms = static_cast<unsigned>(std::stoul(next()));
+            else { std::cerr << "[FATAL] unknown bench option " << key << "\n"; return 1; }
+        }
+        catch (...) {
+            std::cerr << "[FATAL] invalid value for " << key << "\n";
+            return 1;
+        }
+    }
+    if (file) return run_file_bench(fcfg);
+    if (sock) return run_socket_bench(scfg);
+    std::cerr << "[FATAL] no benchmark selected (--bench-file <dir> | --bench-socket)\n";
+    return 1;
+}
@@ -0,0 +1,18 @@
+#pragma once
+// Bench: offline throughput benchmarks for the output paths (no multicast feed needed)
+//   HermesPortal --bench-file <dir> [--bench-lines <n>] [--bench-tokens <n>] [--file-shards <n>]
+//                [--file-format text|lzo|columnar] [--file-durability none|periodic|batch|dsync|all]
+//                [--file-sync-ms <ms>]
+//     writes synthetic 7208 lines through FileWriter once per historical I/O backend
+//     (blocking writev, then io_uring when available) and durability mode, and prints lines/s,
+//     MB/s and batch commit time percentiles for each; columnar also times a full read of the
+//     day it wrote.
+//   HermesPortal --bench-socket [--bench-lines <n>] [--bench-clients <n>] [--bench-rate <lines/s>]
+//                [--bench-unix-path <path>]
+//     streams synthetic 7208 lines through SocketRelay to in-process readers over TCP loopback,
+//     then AF_UNIX stream and seqpacket (POSIX), and prints received lines/s, MB/s, send-to-
+//     receive latency percentiles and process CPU per line for each. Pace with --bench-rate
+//     to compare latency below saturation.
+
+// Returns the process exit code.
+int RunBench(int argc, char* argv[]);
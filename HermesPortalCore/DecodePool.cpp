@@ -0,0 +1,326 @@
+// src/DecodePool.cpp
+// Token-sharded decode workers (see DecodePool.h).
+// Each worker has a single-producer/single-consumer byte ring fed by the receive thread.
+
+#include "DecodePool.h"
+#include "includes/hermes_core.h"
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <iostream>
+#include <iomanip>
+#include <cstring>
+#include <stdexcept>
+
+namespace {
+
+    static inline uint32_t read_be32(const char* p) {
+        uint32_t v = 0; std::memcpy(&v, p, 4); return ntohl(v);
+    }
+
+    // Fibonacci hash so consecutive strike tokens spread evenly across workers.
+    static inline size_t shard_of(uint32_t token, size_t n) {
+        return static_cast<size_t>((static_cast<uint64_t>(token * 2654435761u) * n) >> 32);
+    }
+
+    static inline uint64_t steady_nanos() {
+        using namespace std::chrono;
+        return static_cast<uint64_t>(duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count());
+    }
+
+    // Job framing inside the ring: header + payload, padded to 16 bytes.
+    struct JobHdr {
+        uint32_t len;                           // payload bytes; kWrap => skip to ring start
+        uint32_t records;
+        IMessageHandler* h;
+    };
+    static constexpr uint32_t kWrap = 0xFFFFFFFFu;
+    static constexpr size_t kAlign = 16;
+    static_assert(sizeof(JobHdr) <= kAlign, "JobHdr must fit one alignment unit");
+
+    static inline size_t padded(size_t n) { return (n + kAlign - 1) & ~(kAlign - 1); }
+
+    struct Worker {
+        // ring (producer: receive thread, consumer: worker thread)
+        std::unique_ptr<uint8_t[]> ring;
+        size_t cap = 0;
+        alignas(64) std::atomic<uint64_t> head{ 0 };   // written by producer
+        alignas(64) std::atomic<uint64_t> tail{ 0 };   // written by consumer
+
+        // wakeup
+        std::mutex mtx;
+        std::condition_variable cv;
+        std::atomic<bool> sleeping{ false };
+
+        // stats (relaxed; read by stats printer)
+        alignas(64) std::atomic<uint64_t> jobs{ 0 };
+        std::atomic<uint64_t> records{ 0 };
+        std::atomic<uint64_t> bytes{ 0 };
+        std::atomic<uint64_t> busy_ns{ 0 };
+        alignas(64) std::atomic<uint64_t> drops{ 0 };  // producer-side
+        std::atomic<uint64_t> queue_hwm{ 0 };
+
+        std::thread th;
+        std::unique_ptr<ConsoleSink> sink;
+        std::vector<char> staging;              // producer-side FO split buffer
+        uint32_t staged = 0;
+    };
+
+    struct Impl {
+        DecodePool::Config cfg;
+        InstrumentDirectory* instDir;
+        const StrikeList& strikes;
+
+        std::vector<std::unique_ptr<Worker>> workers;
+        std::atomic<bool> running{ false };
+
+        std::thread stats_thread;
+        std::mutex stats_mtx;
+        std::condition_variable stats_cv;
+
+        Impl(const DecodePool::Config& c, InstrumentDirectory* i, const StrikeList& s)
+            : cfg(c), instDir(i), strikes(s) {
+        }
+    };
+
+    // Producer: append one job. Returns false (and counts a drop) when the ring is full.
+    static bool push_job(Worker& w, IMessageHandler* h, uint32_t records, const char* data, size_t len) {
+        const size_t need = kAlign + padded(len);
+        if (need + kAlign > w.cap) { w.drops.fetch_add(1, std::memory_order_relaxed); return false; }
+
+        uint64_t head = w.head.load(std::memory_order_relaxed);
+        uint64_t tail = w.tail.load(std::memory_order_acquire);
+        size_t pos = static_cast<size_t>(head % w.cap);
+        size_t contiguous = w.cap - pos;
+        size_t total = (contiguous < need) ? contiguous + need : need;   // wrap marker consumes the remainder
+
+        if (w.cap - (head - tail) < total) {
+            w.drops.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+
+        if (contiguous < need) {
+            JobHdr wrap{ kWrap, 0, nullptr };
+            std::memcpy(&w.ring[pos], &wrap, sizeof(wrap));
+            head += contiguous;
+            pos = 0;
+        }
+        JobHdr hdr{ static_cast<uint32_t>(len), records, h };
+        std::memcpy(&w.ring[pos], &hdr, sizeof(hdr));
+        std::memcpy(&w.ring[pos + kAlign], data, len);
+        head += need;
+        w.head.store(head, std::memory_order_seq_cst);
+
+        uint64_t depth = head - tail;
+        if (depth > w.queue_hwm.load(std::memory_order_relaxed)) w.queue_hwm.store(depth, std::memory_order_relaxed);
+
+        if (w.sleeping.load(std::memory_order_seq_cst)) {
+            std::lock_guard<std::mutex> lk(w.mtx);
+            w.cv.notify_one();
+        }
+        return true;
+    }
+
+    static void worker_loop(Impl* I, Worker* w) {
+        unsigned idle = 0;
+        while (true) {
+            uint64_t tail = w->tail.load(std::memory_order_relaxed);
+            uint64_t head = w->head.load(std::memory_order_acquire);
+            if (tail == head) {
+                if (!I->running.load(std::memory_order_acquire)) {
+                    if (w->head.load(std::memory_order_acquire) == tail) break;   // drained
+                    continue;
+                }
+                if (++idle < 256) { std::this_thread::yield(); continue; }
+                std::unique_lock<std::mutex> lk(w->mtx);
+                w->sleeping.store(true, std::memory_order_seq_cst);
+                if (w->head.load(std::memory_order_seq_cst) == tail && I->running.load()) {
+                    w->cv.wait_for(lk, std::chrono::milliseconds(1));
+                }
+                w->sleeping.store(false, std::memory_order_relaxed);
+                idle = 0;
+                continue;
+            }
+            idle = 0;
+
+            size_t pos = static_cast<size_t>(tail % w->cap);
+            JobHdr hdr;
+            std::memcpy(&hdr, &w->ring[pos], sizeof(hdr));
+            if (hdr.len == kWrap) {
+                w->tail.store(tail + (w->cap - pos), std::memory_order_release);
+                continue;
+            }
+
+            const uint64_t t0 = steady_nanos();
+            MessageView mv{ reinterpret_cast<const char*>(&w->ring[pos + kAlign]), static_cast<int>(hdr.len) };
+            hdr.h->handle(mv, *w->sink, I->instDir, I->strikes);
+            w->busy_ns.fetch_add(steady_nanos() - t0, std::memory_order_relaxed);
+            w->jobs.fetch_add(1, std::memory_order_relaxed);
+            w->records.fetch_add(hdr.records, std::memory_order_relaxed);
+            w->bytes.fetch_add(hdr.len, std::memory_order_relaxed);
+
+            w->tail.store(tail + kAlign + padded(hdr.len), std::memory_order_release);
+        }
+    }
+
+    static void stats_loop(Impl* I, DecodePool* self) {
+        std::unique_lock<std::mutex> lk(I->stats_mtx);
+        while (I->running.load()) {
+            I->stats_cv.wait_for(lk, std::chrono::milliseconds(I->cfg.stats_interval_ms));
+            if (!I->running.load()) break;
+            self->print_stats(std::cerr);
+        }
+    }
+
+} // namespace anon
+
+// Public DecodePool methods
+
+DecodePool::DecodePool(const Config& cfg, InstrumentDirectory* instDir, const StrikeList& strikes) {
+    Config c = cfg;
+    if (c.workers == 0) c.workers = 1;
+    if (c.queue_bytes < (64u << 10)) c.queue_bytes = (64u << 10);
+    c.queue_bytes &= ~(kAlign - 1);
+    impl_ = new Impl(c, instDir, strikes);
+}
+
+DecodePool::~DecodePool() {
+    try { stop(); }
+    catch (...) {}
+    if (impl_) { delete reinterpret_cast<Impl*>(impl_); impl_ = nullptr; }
+}
+
+void DecodePool::start() {
+    Impl* I = reinterpret_cast<Impl*>(impl_);
+    if (I->running.load()) return;
+
+    I->workers.clear();
+    for (size_t i = 0; i < I->cfg.workers; ++i) {
+        auto w = std::make_unique<Worker>();
+        w->cap = I->cfg.queue_bytes;
+        w->ring.reset(new uint8_t[w->cap]);
+        w->sink.reset(new ConsoleSink(static_cast<unsigned>(i + 1)));
+        w->staging.reserve(64 * 1024);
+        I->workers.emplace_back(std::move(w));
+    }
+
+    // several lanes now share the sink writer
+    ConsoleSink::setSerialized(I->cfg.workers > 1);
+
+    I->running.store(true);
+    for (auto& w : I->workers) {
+        Worker* wp = w.get();
+        w->th = std::thread([I, wp]() { worker_loop(I, wp); });
+    }
+    if (I->cfg.stats_interval_ms) {
+        I->stats_thread = std::thread([I, this]() { stats_loop(I, this); });
+    }
+}
+
+void DecodePool::stop() {
+    if (!impl_) return;
+    Impl* I = reinterpret_cast<Impl*>(impl_);
+    if (!I->running.load()) return;
+
+    {
+        std::lock_guard<std::mutex> lk(I->stats_mtx);
+        I->running.store(false);
+    }
+    I->stats_cv.notify_all();
+    for (auto& w : I->workers) {
+        { std::lock_guard<std::mutex> lk(w->mtx); }
+        w->cv.notify_one();
+    }
+    for (auto& w : I->workers) if (w->th.joinable()) w->th.join();
+    if (I->stats_thread.joinable()) I->stats_thread.join();
+
+    print_stats(std::cerr);
+}
+
+void DecodePool::submitFO(IMessageHandler* h, int base, const char* buf, int len) {
+    Impl* I = reinterpret_cast<Impl*>(impl_);
+    if (!h || base < 0) return;
+
+    const size_t nw = I->workers.size();
+    const int rb = h->recordBytes();
+    const int rec0 = base + 42;
+    if (rb <= 0 || len < rec0) {
+        // not splittable: keep the whole sub-packet together on worker 0
+        push_job(*I->workers[0], h, 1, buf, static_cast<size_t>(len));
+        return;
+    }
+
+    uint16_t n = 0; std::memcpy(&n, buf + base + 40, 2); n = ntohs(n);
+
+    for (auto& w : I->workers) {
+        w->staging.assign(buf, buf + rec0);
+        w->staged = 0;
+    }
+    for (uint16_t i = 0; i < n; ++i) {
+        const int rec = rec0 + i * rb;
+        if (rec + rb > len) break;
+        const uint32_t token = read_be32(buf + rec);
+        if (!I->strikes.contains(static_cast<long>(token))) continue;
+        Worker& w = *I->workers[shard_of(token, nw)];
+        w.staging.insert(w.staging.end(), buf + rec, buf + rec + rb);
+        w.staged++;
+    }
+    for (auto& w : I->workers) {
+        if (!w->staged) continue;
+        uint16_t cnt = htons(static_cast<uint16_t>(w->staged));
+        std::memcpy(w->staging.data() + base + 40, &cnt, 2);
+        push_job(*w, h, w->staged, w->staging.data(), w->staging.size());
+    }
+}
+
+void DecodePool::submitCM(IMessageHandler* h, const char* rec, int len) {
+    Impl* I = reinterpret_cast<Impl*>(impl_);
+    if (!h || len <= 0) return;
+    // route by the instrument token that follows the 8-byte ST_INFO_HEADER
+    const uint32_t token = (len >= 12) ? read_be32(rec + 8) : 0;
+    push_job(*I->workers[shard_of(token, I->workers.size())], h, 1, rec, static_cast<size_t>(len));
+}
+
+size_t DecodePool::workers() const {
+    Impl* I = reinterpret_cast<Impl*>(impl_);
+    return I->cfg.workers;
+}
+
+std::vector<DecodePool::WorkerStats> DecodePool::stats() const {
+    Impl* I = reinterpret_cast<Impl*>(impl_);
+    std::vector<WorkerStats> out;
+    out.reserve(I->workers.size());
+    for (auto& w : I->workers) {
+        WorkerStats s;
+        s.jobs = w->jobs.load(std::memory_order_relaxed);
+        s.records = w->records.load(std::memory_order_relaxed);
+        s.bytes = w->bytes.load(std::memory_order_relaxed);
+        s.drops = w->drops.load(std::memory_order_relaxed);
+        s.busy_ns = w->busy_ns.load(std::memory_order_relaxed);
+        s.queue_hwm = w->queue_hwm.load(std::memory_order_relaxed);
+        out.push_back(s);
+    }
+    return out;
+}
+
+void DecodePool::print_stats(std::ostream& os) const {
+    auto st = stats();
+    uint64_t total = 0;
+    for (auto& s : st) total += s.records;
+    std::ostringstream ss;
+    for (size_t i = 0; i < st.size(); ++i) {
+        const auto& s = st[i];
+        double share = total ? (100.0 * s.records / total) : 0.0;
+        ss << "[DECODE] worker " << i
+            << " jobs=" << s.jobs
+            << " records=" << s.records << " (" << std::fixed << std::setprecision(1) << share << "%)"
+            << " busy_ms=" << (s.busy_ns / 1000000)
+            << " drops=" << s.drops
+            << " queue_hwm=" << s.queue_hwm << "\n";
+    }
+    os << ss.str();
+}
@@ -0,0 +1,61 @@
+#pragma once
+// DecodePool: token-sharded decode workers for HermesPortal
+// The receive thread keeps recvfrom + LZO; each decompressed FO sub-packet (split per record)
+// or CM record is routed to worker hash(token) % N, so per-instrument ordering is kept while
+// handler work (CSV formatting + sink fan-out) spreads across cores.
+// Every worker owns its own ConsoleSink lane; shared writers are serialized by ConsoleSink.
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <ostream>
+
+class StrikeList;
+class IMessageHandler;
+struct InstrumentDirectory;
+
+class DecodePool {
+public:
+    struct Config {
+        size_t workers = 2;                     // decode worker threads
+        size_t queue_bytes = 4u << 20;          // per-worker job ring (drop-newest when full)
+        unsigned stats_interval_ms = 0;         // 0 => stats only printed on stop()
+    };
+
+    struct WorkerStats {
+        uint64_t jobs = 0;                      // sub-packets / records handled
+        uint64_t records = 0;                   // FO records (CM: one per job)
+        uint64_t bytes = 0;                     // payload bytes routed to this worker
+        uint64_t drops = 0;                     // jobs dropped because the ring was full
+        uint64_t busy_ns = 0;                   // time spent inside handlers
+        uint64_t queue_hwm = 0;                 // ring high-water mark (bytes)
+    };
+
+    DecodePool(const Config& cfg, InstrumentDirectory* instDir, const StrikeList& strikes);
+    ~DecodePool();
+
+    // start worker threads (and the stats printer when stats_interval_ms > 0)
+    void start();
+
+    // drain queued jobs, join workers and print final stats
+    void stop();
+
+    // Route one decompressed FO sub-packet whose header starts at `base`.
+    // Multi-record messages are split per token; records outside the strike list are skipped.
+    // Called from the receive thread only (single producer).
+    void submitFO(IMessageHandler* h, int base, const char* buf, int len);
+
+    // Route one CM record (ST_INFO_HEADER + payload). Receive thread only.
+    void submitCM(IMessageHandler* h, const char* rec, int len);
+
+    size_t workers() const;
+    std::vector<WorkerStats> stats() const;
+    void print_stats(std::ostream& os) const;
+
+private:
+    void* impl_; // opaque pointer to implementation
+
+    DecodePool(const DecodePool&) = delete;
+    DecodePool& operator=(const DecodePool&) = delete;
+};
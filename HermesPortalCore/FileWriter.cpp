@@ -3,38 +3,52 @@
 // Replace existing src/FileWriter.cpp with this file.
 
 #include "FileWriter.h"
+#include "LiveSnapshot.h"
+#include "UringWriter.h"
+#include "HistBlocks.h"
+#include "TickStore.h"
 
 #include <thread>
 #include <mutex>
 #include <condition_variable>
-#include <queue>
 #include <filesystem>
 #include <fstream>
 #include <atomic>
 #include <chrono>
+#include <ctime>
 #include <sstream>
 #include <vector>
 #include <cstdlib>
 #include <iostream>
 #include <iomanip>
 #include <unordered_map>
+#include <unordered_set>
+#include <list>
+#include <memory>
+#include <algorithm>
+#include <cstring>
 
 #ifdef _WIN32
 #include <windows.h>
 #include <shlwapi.h>
+#include <io.h>
+#include <fcntl.h>
+#include <sys/stat.h>
 #pragma comment(lib, "Shlwapi.lib")
 #else
 #include <unistd.h> // readlink
+#include <fcntl.h>
+#include <sys/uio.h>
+#include <sys/stat.h>
+#include <cerrno>
 #endif
 
 // ----------------- internal helpers & types -----------------
 namespace {
 
     struct Task {
-        uint16_t type{ 0 };
-        uint32_t token{ 0 };
+        RecordMeta meta;
         std::string csv;
-        std::string market; // optional market folder
     };
 
     // return directory of the running executable (no trailing slash)
@@ -61,25 +75,27 @@ namespace {
 #endif
     }
 
-    // simple CSV split/join (no quoting support; matches Hermes CSV)
-    static std::vector<std::string> split_csv(const std::string& s) {
-        std::vector<std::string> out;
-        size_t i = 0;
-        while (true) {
-            size_t j = s.find(',', i);
-            if (j == std::string::npos) { out.emplace_back(s.substr(i)); break; }
-            out.emplace_back(s.substr(i, j - i));
-            i = j + 1;
+    // replace CSV field idx in place (no quoting support; matches Hermes CSV)
+    static bool replace_csv_field(std::string& line, size_t idx, const std::string& value) {
+        size_t b = 0;
+        for (size_t i = 0; i < idx; ++i) {
+            size_t c = line.find(',', b);
+            if (c == std::string::npos) return false;
+            b = c + 1;
         }
-        return out;
+        size_t e = line.find(',', b);
+        line.replace(b, (e == std::string::npos ? line.size() : e) - b, value);
+        return true;
     }
-    static std::string join_csv(const std::vector<std::string>& v) {
-        std::string o;
-        for (size_t i = 0; i < v.size(); ++i) {
-            if (i) o.push_back(',');
-            o += v[i];
-        }
-        return o;
+
+    // market subfolder from handler metadata:
+    // 7202 -> market type ("2"), 7208 -> "7208", CM iCodes -> their two letters ("CT", "PN")
+    static std::string market_folder_for(const RecordMeta& m) {
+        if (m.type == 7202) return std::to_string(m.market);
+        if (m.type == 7208) return "7208";
+        char a = static_cast<char>(m.type >> 8), b = static_cast<char>(m.type & 0xFF);
+        if (a >= 'A' && a <= 'Z' && b >= 'A' && b <= 'Z') return std::string{ a, b };
+        return std::to_string(m.type);
     }
 
     static std::string unix_to_local(uint64_t unixsec) {
@@ -126,170 +142,1228 @@ namespace {
         return out;
     }
 
-    // ----------------- Impl (hidden) -----------------
-    // Not nested in FileWriter; kept in anon namespace to avoid leaking symbols.
-    class Impl {
+    // ----------------- historical append files -----------------
+    // Append-mode fds for historical/<market>/<token>.txt, kept open in an LRU bounded by
+    // the fd budget so a tick costs no open/close. Worker-thread only (no locking).
+    // dsync: every write returns only once its data is on stable storage (O_DSYNC)
+    static int open_append(const std::string& path, bool dsync) {
+#ifdef _WIN32
+        if (dsync) {
+            HANDLE h = CreateFileA(path.c_str(), FILE_APPEND_DATA, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                nullptr, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_WRITE_THROUGH, nullptr);
+            if (h == INVALID_HANDLE_VALUE) return -1;
+            int fd = _open_osfhandle(reinterpret_cast<intptr_t>(h), _O_APPEND | _O_BINARY);
+            if (fd < 0) CloseHandle(h);
+            return fd;
+        }
+        int fd = -1;
+        if (_sopen_s(&fd, path.c_str(), _O_WRONLY | _O_CREAT | _O_APPEND | _O_BINARY, _SH_DENYNO, _S_IREAD | _S_IWRITE) != 0) return -1;
+        return fd;
+#else
+        return ::open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC | (dsync ? O_DSYNC : 0), 0644);
+#endif
+    }
+
+    // flush a file's data (not necessarily its metadata) to stable storage
+    static bool datasync(int fd) {
+#ifdef _WIN32
+        return _commit(fd) == 0;
+#elif defined(__APPLE__)
+        return ::fsync(fd) == 0;
+#else
+        int rc;
+        do { rc = ::fdatasync(fd); } while (rc != 0 && errno == EINTR);
+        return rc == 0;
+#endif
+    }
+
+    // Reserve disk for an append file up to bytes without changing its size (readers and
+    // O_APPEND keep seeing the real end), so a day of appends lands in few extents.
+    static void preallocate(int fd, uint64_t bytes) {
+#ifdef _WIN32
+        HANDLE h = reinterpret_cast<HANDLE>(_get_osfhandle(fd));
+        LARGE_INTEGER cur{};
+        if (h == INVALID_HANDLE_VALUE || !GetFileSizeEx(h, &cur) || static_cast<uint64_t>(cur.QuadPart) >= bytes) return;
+        FILE_ALLOCATION_INFO ai{};
+        ai.AllocationSize.QuadPart = static_cast<LONGLONG>(bytes);
+        SetFileInformationByHandle(h, FileAllocationInfo, &ai, sizeof(ai));
+#elif defined(__linux__)
+        (void)::fallocate(fd, FALLOC_FL_KEEP_SIZE, 0, static_cast<off_t>(bytes));
+#else
+        (void)fd; (void)bytes;
+#endif
+    }
+
+    // Before closing an append file: give back preallocated space past its end (trim) and
+    // drop its pages from the page cache (the writer never reads them back).
+    static void finish_file(int fd, bool trim, bool drop_cache) {
+#ifdef _WIN32
+        (void)drop_cache;                       // no equivalent for a plain fd
+        if (!trim) return;
+        HANDLE h = reinterpret_cast<HANDLE>(_get_osfhandle(fd));
+        LARGE_INTEGER cur{};
+        if (h == INVALID_HANDLE_VALUE || !GetFileSizeEx(h, &cur)) return;
+        FILE_ALLOCATION_INFO ai{};
+        ai.AllocationSize = cur;
+        SetFileInformationByHandle(h, FileAllocationInfo, &ai, sizeof(ai));
+#elif defined(__linux__)
+        struct stat st {};
+        if (trim && ::fstat(fd, &st) == 0) (void)::ftruncate(fd, st.st_size);
+        if (drop_cache) (void)::posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+#else
+        (void)fd; (void)trim; (void)drop_cache;
+#endif
+    }
+
+    static void close_fd(int fd) {
+#ifdef _WIN32
+        _close(fd);
+#else
+        ::close(fd);
+#endif
+    }
+
+    // write every buffer in order; false on a hard error
+    static bool write_all(int fd, const std::vector<std::string_view>& parts) {
+#ifdef _WIN32
+        std::string joined;
+        size_t total = 0;
+        for (const auto& p : parts) total += p.size();
+        joined.reserve(total);
+        for (const auto& p : parts) joined.append(p.data(), p.size());
+        const char* d = joined.data();
+        size_t left = joined.size();
+        while (left) {
+            int n = _write(fd, d, static_cast<unsigned>(std::min<size_t>(left, 1u << 30)));
+            if (n <= 0) return false;
+            d += n; left -= static_cast<size_t>(n);
+        }
+        return true;
+#else
+        static constexpr size_t kMaxIov = 512;
+        iovec iov[kMaxIov];
+        size_t i = 0;
+        while (i < parts.size()) {
+            size_t cnt = 0;
+            for (; cnt < kMaxIov && i + cnt < parts.size(); ++cnt) {
+                iov[cnt].iov_base = const_cast<char*>(parts[i + cnt].data());
+                iov[cnt].iov_len = parts[i + cnt].size();
+            }
+            iovec* v = iov;
+            size_t vc = cnt;
+            while (vc) {
+                ssize_t n = ::writev(fd, v, static_cast<int>(vc));
+                if (n < 0) {
+                    if (errno == EINTR) continue;
+                    return false;
+                }
+                // advance past what was written (partial writes are rare on regular files)
+                size_t w = static_cast<size_t>(n);
+                while (vc && w >= v->iov_len) { w -= v->iov_len; ++v; --vc; }
+                if (vc && w) { v->iov_base = static_cast<char*>(v->iov_base) + w; v->iov_len -= w; }
+            }
+            i += cnt;
+        }
+        return true;
+#endif
+    }
+
+    class HistFileCache {
     public:
-        Impl()
-            : max_queue_(10000), stop_flag_(false) {
+        explicit HistFileCache(size_t budget) : budget_(budget ? budget : 1) {}
+        ~HistFileCache() { close_all(); }
+
+        // called with each fd right before it is closed (io_uring drops its fixed-file slot);
+        // finish: the file is about to be trimmed / dropped from the cache (see retire)
+        void set_close_hook(void (*fn)(void*, int, bool), void* ctx) { hook_ = fn; hook_ctx_ = ctx; }
+
+        // Preallocate a segment to bytes (0 = off) the first time it is opened in this run, and
+        // trim it / drop its cache (drop_cache) only when it is retired: an LRU eviction and
+        // reopen of a live segment touches neither.
+        void set_prealloc(uint64_t bytes, bool drop_cache) { prealloc_ = bytes; drop_cache_ = drop_cache; }
+
+        // track_dirty: remember which fds were written (sync_dirty; a dirty fd is synced before
+        // it is closed). dsync: open files with O_DSYNC.
+        void set_sync(bool track_dirty, bool dsync) { track_dirty_ = track_dirty; dsync_ = dsync; }
+
+        void set_budget(size_t b) {
+            budget_ = b ? b : 1;
+            while (map_.size() > budget_) evict_one();
         }
 
-        ~Impl() { stop(); }
+        // fd open for append (opened and cached on miss), or -1. The caller is about to write it.
+        int get(const std::string& path) {
+            auto it = map_.find(path);
+            if (it != map_.end()) {
+                lru_.splice(lru_.begin(), lru_, it->second.pos);
+                it->second.dirty = track_dirty_;
+                return it->second.fd;
+            }
+            while (map_.size() >= budget_) evict_one();
+            int fd = open_append(path, dsync_);
+            if (fd < 0) return -1;
+            if ((prealloc_ || drop_cache_) && segments_.insert(path).second && prealloc_) preallocate(fd, prealloc_);
+            lru_.push_front(path);
+            map_.emplace(path, Entry{ fd, lru_.begin(), track_dirty_ });
+            ++opens_;
+            return fd;
+        }
 
-        void start(const std::string& baseDir) {
-            std::lock_guard<std::mutex> lk(mutex_);
-            if (worker_.joinable()) return;
+        // fdatasync every fd written since its last sync
+        void sync_dirty() {
+            for (auto& kv : map_) {
+                if (!kv.second.dirty) continue;
+                sync(kv.second.fd);
+                kv.second.dirty = false;
+            }
+        }
 
-            if (baseDir.empty()) {
-                std::string ed = exe_dir();
-                base_dir_ = (std::filesystem::path(ed) / "data").string();
+        // close a cached fd after a write error (the next batch reopens it)
+        void close(const std::string& path) {
+            auto it = map_.find(path);
+            if (it == map_.end()) return;
+            release(it->second, false);
+            lru_.erase(it->second.pos);
+            map_.erase(it);
+        }
+
+        // a segment is done (rotated out): close it if cached, trim its preallocation and drop
+        // its cache. An evicted segment is reopened once for that.
+        void retire(const std::string& path) {
+            auto it = map_.find(path);
+            if (it != map_.end()) {
+                release(it->second, true);
+                lru_.erase(it->second.pos);
+                map_.erase(it);
             }
-            else {
-                base_dir_ = baseDir;
+            else if (segments_.count(path)) {
+                int fd = open_append(path, false);
+                if (fd >= 0) { finish_file(fd, prealloc_ != 0, drop_cache_); close_fd(fd); }
             }
+            segments_.erase(path);
+        }
 
-            std::error_code ec;
-            std::filesystem::create_directories(base_dir_, ec);
-            stop_flag_ = false;
-            worker_ = std::thread(&Impl::thread_main, this);
+        // at stop: retire every segment opened in this run
+        void retire_all() {
+            std::vector<std::string> paths(segments_.begin(), segments_.end());
+            for (const std::string& p : paths) retire(p);
+        }
+
+        void close_all() {
+            for (auto& kv : map_) release(kv.second, false);
+            map_.clear();
+            lru_.clear();
+        }
+
+        uint64_t opens() const { return opens_; }
+        uint64_t evictions() const { return evictions_; }
+        uint64_t syncs() const { return syncs_; }
+        uint64_t sync_errors() const { return sync_errors_; }
+
+    private:
+        struct Entry { int fd; std::list<std::string>::iterator pos; bool dirty; };
+        size_t budget_;
+        std::unordered_map<std::string, Entry> map_;
+        std::list<std::string> lru_;            // front = most recently used
+        uint64_t opens_ = 0;
+        uint64_t evictions_ = 0;
+        void (*hook_)(void*, int, bool) = nullptr;
+        void* hook_ctx_ = nullptr;
+        uint64_t prealloc_ = 0;
+        bool drop_cache_ = false;
+        std::unordered_set<std::string> segments_;  // opened this run, not yet retired
+        bool track_dirty_ = false;
+        bool dsync_ = false;
+        uint64_t syncs_ = 0;
+        uint64_t sync_errors_ = 0;
+
+        void sync(int fd) {
+            ++syncs_;
+            if (!datasync(fd)) ++sync_errors_;
+        }
+
+        void release(const Entry& e, bool finish) {
+            finish = finish && (prealloc_ || drop_cache_);
+            if (hook_) hook_(hook_ctx_, e.fd, finish);
+            if (e.dirty) sync(e.fd);
+            if (finish) finish_file(e.fd, prealloc_ != 0, drop_cache_);
+            close_fd(e.fd);
+        }
+
+        void evict_one() {
+            if (lru_.empty()) return;
+            auto it = map_.find(lru_.back());
+            if (it != map_.end()) { release(it->second, false); map_.erase(it); }
+            lru_.pop_back();
+            ++evictions_;
+        }
+    };
+
+    // ----------------- shard queue -----------------
+    // Bounded MPSC byte ring, one buffer per shard allocated at start (same record layout as
+    // AsyncConsole): [uint32 len|flags][uint32 csv length][RecordMeta][csv], 8-byte aligned.
+    // Producers reserve with a CAS on reserve_, copy the record and publish its header with a
+    // release store, so enqueue never allocates or locks. The shard thread copies records out,
+    // zeroes them (stale bytes never look committed) and advances tail_. The ring size is the
+    // shard's queue memory budget.
+    class ByteRing {
+    public:
+        void init(size_t bytes) {
+            cap_ = 64u << 10;
+            while (cap_ < bytes) cap_ <<= 1;
+            mask_ = cap_ - 1;
+            storage_.reset(new uint64_t[cap_ / 8]());
+            ring_ = reinterpret_cast<uint8_t*>(storage_.get());
+            reserve_.store(0);
+            tail_.store(0);
+        }
+
+        size_t capacity() const { return cap_; }
+        uint64_t used() const {
+            return reserve_.load(std::memory_order_relaxed) - tail_.load(std::memory_order_relaxed);
+        }
+
+        // a record larger than half the ring could never be placed next to a wrap
+        bool fits(size_t csv_len) const { return record_bytes(csv_len) <= cap_ / 2; }
+
+        // producer: false when the record does not fit in the free space. used_after is the
+        // ring fill (bytes) right after this reservation.
+        bool push(const RecordMeta& meta, std::string_view csv, uint64_t& used_after) {
+            const size_t need = record_bytes(csv.size());
+            if (!ring_ || need > cap_ / 2) return false;
+            uint64_t head = reserve_.load(std::memory_order_relaxed);
+            size_t pos, contig, total;
+            for (;;) {
+                pos = static_cast<size_t>(head & mask_);
+                contig = cap_ - pos;
+                total = (contig < need) ? contig + need : need;
+                const uint64_t tail = tail_.load(std::memory_order_acquire);
+                if (head + total - tail > cap_) return false;
+                if (reserve_.compare_exchange_weak(head, head + total,
+                    std::memory_order_acq_rel, std::memory_order_relaxed)) {
+                    used_after = head + total - tail;
+                    break;
+                }
+            }
+            if (contig < need) {
+                hdr_at(pos)->store(static_cast<uint32_t>(contig) | kCommit | kPad, std::memory_order_release);
+                pos = 0;
+            }
+            const uint32_t n = static_cast<uint32_t>(csv.size());
+            std::memcpy(ring_ + pos + 4, &n, sizeof(n));
+            std::memcpy(ring_ + pos + kHdr, &meta, sizeof(RecordMeta));
+            std::memcpy(ring_ + pos + kHdr + sizeof(RecordMeta), csv.data(), csv.size());
+            hdr_at(pos)->store(static_cast<uint32_t>(need) | kCommit, std::memory_order_release);
+            return true;
+        }
+
+        // consumer: copy the oldest record into t; false when the ring is empty or that record
+        // is reserved but not yet published. pop() releases it.
+        bool front(Task& t) {
+            uint64_t tail = tail_.load(std::memory_order_relaxed);
+            for (;;) {
+                if (tail == reserve_.load(std::memory_order_acquire)) return false;
+                const size_t pos = static_cast<size_t>(tail & mask_);
+                const uint32_t h = hdr_at(pos)->load(std::memory_order_acquire);
+                if (!(h & kCommit)) return false;
+                if (!(h & kPad)) break;
+                const size_t len = h & kLenMask;
+                std::memset(ring_ + pos, 0, len);
+                tail += len;
+                tail_.store(tail, std::memory_order_release);
+            }
+            const size_t pos = static_cast<size_t>(tail & mask_);
+            uint32_t n = 0;
+            std::memcpy(&n, ring_ + pos + 4, sizeof(n));
+            std::memcpy(&t.meta, ring_ + pos + kHdr, sizeof(RecordMeta));
+            t.csv.assign(reinterpret_cast<const char*>(ring_ + pos + kHdr + sizeof(RecordMeta)), n);
+            return true;
+        }
+
+        void pop() {
+            const uint64_t tail = tail_.load(std::memory_order_relaxed);
+            const size_t pos = static_cast<size_t>(tail & mask_);
+            const size_t len = hdr_at(pos)->load(std::memory_order_relaxed) & kLenMask;
+            std::memset(ring_ + pos, 0, len);
+            tail_.store(tail + len, std::memory_order_release);
+        }
+
+    private:
+        static constexpr uint32_t kCommit = 0x80000000u;
+        static constexpr uint32_t kPad = 0x40000000u;   // filler up to the ring end
+        static constexpr uint32_t kLenMask = 0x3FFFFFFFu;
+        static constexpr size_t kHdr = 8;
+
+        static size_t record_bytes(size_t csv_len) {
+            return (kHdr + sizeof(RecordMeta) + csv_len + 7) & ~static_cast<size_t>(7);
+        }
+        std::atomic<uint32_t>* hdr_at(size_t pos) {
+            return reinterpret_cast<std::atomic<uint32_t>*>(ring_ + pos);
+        }
+
+        std::unique_ptr<uint64_t[]> storage_;   // 8-byte aligned, zero-initialised
+        uint8_t* ring_ = nullptr;
+        size_t cap_ = 0;
+        size_t mask_ = 0;
+        alignas(64) std::atomic<uint64_t> reserve_{ 0 };  // producers
+        alignas(64) std::atomic<uint64_t> tail_{ 0 };     // shard thread
+    };
+
+    // ----------------- shared writer state -----------------
+    // Configuration (fixed while running) plus the per-market snapshot registry.
+    struct Shared {
+        std::string base_dir;
+        size_t queue_bytes = 4u << 20;          // ring budget per shard
+        FileWriter::Overflow overflow = FileWriter::Overflow::DropOldest;
+        size_t max_open_files = 512;            // split across shards
+        size_t max_batch = 4096;                // lines per group commit
+        unsigned flush_interval_us = 0;         // 0 => write as soon as the shard wakes
+        FileWriter::LiveMode live_mode = FileWriter::LiveMode::Snapshot;
+        FileWriter::IoBackend io = FileWriter::IoBackend::Blocking;
+        FileWriter::HistFormat hist_format = FileWriter::HistFormat::Text;
+        size_t block_bytes = 64 * 1024;         // LzoBlocks: raw bytes per block
+        unsigned block_age_ms = 1000;           // LzoBlocks: max age of a block's first line
+        size_t tick_rows = 256 * 1024;          // Columnar: rows per segment
+        unsigned tick_secs = 300;               // Columnar: max age of a segment's first row
+        bool rotate_daily = false;              // Text: <token>-<YYYYMMDD>.txt per local day
+        uint64_t rotate_bytes = 0;              // Text: next .<n> part past this size (0 = off)
+        uint64_t prealloc_bytes = 0;            // Text: reserve per segment on open (0 = off)
+        bool drop_cache = false;                // Text: POSIX_FADV_DONTNEED on close
+        FileWriter::Durability durability = FileWriter::Durability::None;
+        unsigned sync_interval_ms = 1000;       // Durability::Periodic
+        uint32_t live_slots = 16384;
+        uint32_t live_slot_bytes = 512;
+
+        std::mutex snap_mtx;
+        std::unordered_map<std::string, std::unique_ptr<LiveSnapshot>> snaps;  // null = open failed
+
+        // live/<market>.snap, opened on first use; nullptr when it cannot be mapped
+        LiveSnapshot* snapshot_for(const std::string& market_folder) {
+            std::lock_guard<std::mutex> lk(snap_mtx);
+            auto it = snaps.find(market_folder);
+            if (it != snaps.end()) return it->second.get();
+            std::unique_ptr<LiveSnapshot> s(new LiveSnapshot());
+            std::filesystem::path p = std::filesystem::path(base_dir) / "live" / (market_folder + ".snap");
+            if (!s->open(p.string(), live_slots, live_slot_bytes)) {
+                std::cerr << "[FILE] cannot map " << p.string() << "; using live text files for this market\n";
+                s.reset();
+            }
+            LiveSnapshot* raw = s.get();
+            snaps.emplace(market_folder, std::move(s));
+            return raw;
+        }
+    };
+
+    // ----------------- Shard -----------------
+    // One writer thread with its own queue, fd cache and folder set. Tokens are assigned to
+    // shards by hash, so every file (live slot or historical) has exactly one writer and
+    // per-file line order is preserved.
+    class Shard {
+    public:
+        Shard(Shared& sh, size_t id) : sh_(sh), id_(id), hist_files_(1) {}
+        ~Shard() { stop(); }
+
+        // false when io_uring was requested but is unavailable (shard runs blocking)
+        bool start(size_t fd_budget) {
+            hist_files_.set_budget(fd_budget);
+            ring_.init(sh_.queue_bytes);
+            if (sh_.hist_format == FileWriter::HistFormat::Text) {
+                uint64_t pre = sh_.prealloc_bytes;
+                if (sh_.rotate_bytes) pre = std::min(pre, sh_.rotate_bytes);
+                hist_files_.set_prealloc(pre, sh_.drop_cache);
+            }
+            hist_files_.set_sync(sh_.durability == FileWriter::Durability::Periodic ||
+                sh_.durability == FileWriter::Durability::Batch, sh_.durability == FileWriter::Durability::DSync);
+            bool io_ok = true;
+            if (sh_.io == FileWriter::IoBackend::IoUring) {
+                UringWriter::Config ucfg;
+                ucfg.max_files = static_cast<unsigned>(fd_budget);
+                io_ok = uring_.open(ucfg);
+                if (io_ok) hist_files_.set_close_hook(&Shard::on_fd_close, this);
+                uring_on_.store(io_ok, std::memory_order_relaxed);
+            }
+            stop_.store(false);
+            running_.store(true, std::memory_order_release);
+            worker_ = std::thread(&Shard::thread_main, this);
+            return io_ok;
         }
 
         void stop() {
+            if (!worker_.joinable()) return;
+            running_.store(false, std::memory_order_release);
             {
-                std::lock_guard<std::mutex> lk(mutex_);
-                if (!worker_.joinable()) return;
-                stop_flag_ = true;
-                cv_.notify_all();
+                std::lock_guard<std::mutex> lk(wake_mtx_);
+                stop_.store(true);
             }
-            if (worker_.joinable()) worker_.join();
+            wake_cv_.notify_all();
+            {
+                std::lock_guard<std::mutex> lk(space_mtx_);
+            }
+            space_cv_.notify_all();
+            worker_.join();
         }
 
-        // Enqueue: always push; no dedupe
-        void enqueue(uint16_t type, uint32_t token, const std::string& csv, const std::string& market) {
-            Task t; t.type = type; t.token = token; t.csv = csv; t.market = market;
-            {
-                std::unique_lock<std::mutex> lk(mutex_);
-                q_.push(std::move(t));
-                if (q_.size() > max_queue_) {
-                    // drop oldest to bound memory
-                    q_.pop();
+        // Enqueue: lock-free except for Block waits; a full ring is handled per overflow policy
+        bool enqueue(const RecordMeta& meta, std::string_view csv) {
+            if (!running_.load(std::memory_order_acquire)) return false;
+            uint64_t used = 0;
+            if (!ring_.push(meta, csv, used)) {
+                if (sh_.overflow != FileWriter::Overflow::Block || !ring_.fits(csv.size())) {
+                    // Producers never free ring space, so the line that found it full is
+                    // dropped; with DropOldest the shard thread also sheds the stale backlog.
+                    if (sh_.overflow == FileWriter::Overflow::DropOldest)
+                        shed_.store(true, std::memory_order_relaxed);
+                    dropped_.fetch_add(1, std::memory_order_relaxed);
+                    return false;
                 }
+                std::unique_lock<std::mutex> lk(space_mtx_);
+                blocked_.fetch_add(1);
+                bool ok = false;
+                while (running_.load() && !(ok = ring_.push(meta, csv, used)))
+                    space_cv_.wait_for(lk, std::chrono::milliseconds(10));
+                blocked_.fetch_sub(1);
+                if (!ok) return false;
             }
-            cv_.notify_one();
+            uint64_t hwm = bytes_hwm_.load(std::memory_order_relaxed);
+            while (used > hwm && !bytes_hwm_.compare_exchange_weak(hwm, used, std::memory_order_relaxed)) {}
+            uint64_t d = depth_.fetch_add(1) + 1;
+            hwm = depth_hwm_.load(std::memory_order_relaxed);
+            while (d > hwm && !depth_hwm_.compare_exchange_weak(hwm, d, std::memory_order_relaxed)) {}
+            enqueued_.fetch_add(1, std::memory_order_relaxed);
+
+            // while lingering, only a full batch is worth a wake-up
+            if (sleeping_.load() && (!lingering_.load() || d >= sh_.max_batch)) {
+                std::lock_guard<std::mutex> lk(wake_mtx_);
+                wake_cv_.notify_one();
+            }
+            return true;
         }
 
-        void set_max_queue(size_t m) { max_queue_ = m; }
+        FileWriter::ShardStats stats() const {
+            FileWriter::ShardStats s;
+            s.enqueued = enqueued_.load(std::memory_order_relaxed);
+            s.lines = lines_.load(std::memory_order_relaxed);
+            s.bytes = bytes_.load(std::memory_order_relaxed);
+            s.raw_bytes = raw_bytes_.load(std::memory_order_relaxed);
+            s.blocks = blocks_.load(std::memory_order_relaxed);
+            s.segments = segments_.load(std::memory_order_relaxed);
+            s.rotations = rotations_.load(std::memory_order_relaxed);
+            s.snap_full = snap_full_.load(std::memory_order_relaxed);
+            s.batches = batches_.load(std::memory_order_relaxed);
+            s.dropped = dropped_.load(std::memory_order_relaxed);
+            s.depth = depth_.load(std::memory_order_relaxed);
+            s.depth_hwm = depth_hwm_.load(std::memory_order_relaxed);
+            s.shed = shed_lines_.load(std::memory_order_relaxed);
+            s.queue_bytes = ring_.used();
+            s.queue_bytes_hwm = bytes_hwm_.load(std::memory_order_relaxed);
+            s.queue_budget = ring_.capacity();
+            s.busy_ns = busy_ns_.load(std::memory_order_relaxed);
+            s.max_batch = max_batch_seen_.load(std::memory_order_relaxed);
+            s.io_uring = uring_on_.load(std::memory_order_relaxed);
+            s.io_enters = io_enters_.load(std::memory_order_relaxed);
+            s.syncs = syncs_.load(std::memory_order_relaxed);
+            s.sync_errors = sync_errors_.load(std::memory_order_relaxed);
+            // commit time percentiles from the histogram (bucket upper bounds)
+            uint64_t total = 0;
+            for (const auto& b : commit_hist_) total += b.load(std::memory_order_relaxed);
+            uint64_t seen = 0;
+            for (size_t i = 0; i < kLatBuckets && total; ++i) {
+                const uint64_t c = commit_hist_[i].load(std::memory_order_relaxed);
+                if (!c) continue;
+                if (!s.commit_p50_us && (seen + c) * 2 >= total) s.commit_p50_us = bucket_high(i);
+                if (!s.commit_p99_us && (seen + c) * 100 >= total * 99) s.commit_p99_us = bucket_high(i);
+                seen += c;
+            }
+            s.commit_max_us = commit_max_us_.load(std::memory_order_relaxed);
+            s.commit_p50_us = std::min(s.commit_p50_us, s.commit_max_us);
+            s.commit_p99_us = std::min(s.commit_p99_us, s.commit_max_us);
+            return s;
+        }
+
+        uint64_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
 
     private:
-        std::string base_dir_;
+        Shared& sh_;
+        const size_t id_;
         std::thread worker_;
-        std::mutex mutex_;
-        std::condition_variable cv_;
-        std::queue<Task> q_;
-        size_t max_queue_;
-        bool stop_flag_;
+        ByteRing ring_;
+        std::atomic<bool> running_{ false };    // accepting lines
+        std::atomic<bool> stop_{ false };       // drain and exit
 
-        void thread_main() {
-            while (true) {
-                Task t;
+        // wake-up: producers only take wake_mtx_ when the shard thread is asleep
+        std::mutex wake_mtx_;
+        std::condition_variable wake_cv_;
+        std::atomic<bool> sleeping_{ false };
+        std::atomic<bool> lingering_{ false };  // waiting for the batch to fill (flush interval)
+
+        // Block policy: producers wait for room
+        std::mutex space_mtx_;
+        std::condition_variable space_cv_;
+        std::atomic<uint32_t> blocked_{ 0 };
+
+        std::atomic<uint64_t> depth_{ 0 };      // lines in the ring
+        std::atomic<bool> shed_{ false };       // DropOldest: a producer found the ring full
+
+        // stats
+        std::atomic<uint64_t> enqueued_{ 0 }, lines_{ 0 }, bytes_{ 0 }, batches_{ 0 };
+        std::atomic<uint64_t> dropped_{ 0 }, depth_hwm_{ 0 }, busy_ns_{ 0 };
+        std::atomic<uint64_t> shed_lines_{ 0 }, bytes_hwm_{ 0 };
+        std::atomic<uint64_t> io_enters_{ 0 };
+        std::atomic<uint64_t> syncs_{ 0 }, sync_errors_{ 0 };
+
+        // batch commit time (format + write + sync), 4 buckets per power of two microseconds
+        static constexpr size_t kLatBuckets = 128;
+        std::atomic<uint64_t> commit_hist_[kLatBuckets] = {};
+        std::atomic<uint64_t> commit_max_us_{ 0 };
+
+        static size_t bucket_of(uint64_t us) {
+            if (us < 4) return static_cast<size_t>(us);
+            unsigned msb = 2;
+            while (msb < 63 && (us >> (msb + 1))) ++msb;
+            const size_t b = (msb - 1) * 4 + static_cast<size_t>((us >> (msb - 2)) & 3);
+            return b < kLatBuckets ? b : kLatBuckets - 1;
+        }
+        static uint64_t bucket_high(size_t b) {
+            if (b < 4) return b;
+            const unsigned msb = static_cast<unsigned>(b / 4 + 1);
+            return ((4 + (b & 3)) << (msb - 2)) + (1ull << (msb - 2)) - 1;
+        }
+        std::atomic<uint64_t> max_batch_seen_{ 0 };
+        std::atomic<uint64_t> raw_bytes_{ 0 }, blocks_{ 0 }, segments_{ 0 }, rotations_{ 0 }, snap_full_{ 0 };
+        std::atomic<bool> uring_on_{ false };
+
+        // shard-thread state
+        UringWriter uring_;                     // open only with IoBackend::IoUring
+        HistFileCache hist_files_;
+        std::unordered_set<std::string> dirs_made_;     // create_directories once per folder
+        std::unordered_map<std::string, LiveSnapshot*> snaps_;  // local view of sh_.snaps
+
+        // one output destination (market folder + token), resolved once and reused
+        struct Dest {
+            uint32_t token = 0;
+            std::string hist_path;              // Text: the segment being appended
+
+            // Text rotation: hist_path = <hist_stem>[-<seg_day>][.<seg_part>].txt
+            std::string hist_stem;              // historical/<market>/<token>
+            uint32_t seg_day = 0;
+            uint32_t seg_part = 0;
+            uint64_t seg_bytes = 0;             // bytes in hist_path (valid when seg_sized)
+            bool seg_sized = false;
+            std::filesystem::path live_text;    // legacy view (text_view; also when the snapshot is full)
+            LiveSnapshot* snap = nullptr;
+            bool text_view = false;
+            std::vector<std::string_view> hist; // this batch's lines (point into Task::csv)
+            const std::string* latest = nullptr;// this batch's last line
+
+            // LzoBlocks: <token>.hlz / .hlx and the block being filled
+            std::string blk_path, idx_path;
+            uint64_t blk_size = 0;              // bytes in the .hlz file (valid when blk_sized)
+            bool blk_sized = false;
+            bool blk_listed = false;            // in open_blocks_
+            HistBlocks::Pending blk;
+        };
+        std::unordered_map<uint64_t, Dest> dests_;
+        std::vector<Dest*> touched_;            // destinations with lines in this batch
+
+        // LzoBlocks state
+        static constexpr size_t kBlockBudget = 32u << 20;   // buffered raw bytes per shard
+        HistBlocks::Encoder encoder_;
+        const std::string file_hdr_ = HistBlocks::Encoder::file_header();
+        std::vector<Dest*> open_blocks_;        // destinations with a partial block
+        size_t block_buffered_ = 0;
+        uint64_t next_age_check_ms_ = 0;
+        std::string block_buf_, index_buf_;     // encoded block / index entry (writers copy them)
+        uint32_t batch_sec_ = 0;                // wall clock for lines without an exchange time
+        uint64_t next_sync_ms_ = 0;             // Durability::Periodic
+
+        // Columnar state: one segment builder per message type, day of the rows cached by range
+        std::unordered_map<uint16_t, std::unique_ptr<TickStore::SegmentBuilder>> ticks_;
+        uint32_t day_ = 0, day_lo_ = 1, day_hi_ = 0;    // [day_lo_, day_hi_] unix seconds of day_
+
+        // timestamp text reused within a batch
+        std::string batch_now_;
+        uint32_t exch_sec_ = 0;
+        std::string exch_str_;
+
+        static void on_fd_close(void* self, int fd, bool finish) {
+            Shard* s = static_cast<Shard*>(self);
+            // trimming the preallocation or syncing under in-flight appends would miss them
+            if (finish || s->sh_.durability == FileWriter::Durability::Periodic ||
+                s->sh_.durability == FileWriter::Durability::Batch) s->uring_.flush();
+            s->uring_.forget_fd(fd);
+        }
+
+        void ensure_dir(const std::filesystem::path& dir) {
+            std::string key = dir.string();
+            if (dirs_made_.count(key)) return;
+            std::error_code ec;
+            std::filesystem::create_directories(dir, ec);
+            dirs_made_.insert(std::move(key));
+        }
+
+        LiveSnapshot* snapshot_for(const std::string& market_folder) {
+            auto it = snaps_.find(market_folder);
+            if (it != snaps_.end()) return it->second;
+            LiveSnapshot* s = sh_.snapshot_for(market_folder);
+            snaps_.emplace(market_folder, s);
+            return s;
+        }
+
+        void write_live_text(const std::filesystem::path& live_path, const std::string& line) {
+            try {
+                std::string tmp = live_path.string() + ".tmp";
                 {
-                    std::unique_lock<std::mutex> lk(mutex_);
-                    cv_.wait(lk, [&] { return stop_flag_ || !q_.empty(); });
-                    if (stop_flag_ && q_.empty()) break;
-                    t = std::move(q_.front());
-                    q_.pop();
+                    std::ofstream ofs(tmp, std::ios::binary | std::ios::trunc);
+                    if (ofs) {
+                        ofs << line;
+                        ofs.flush();
+                        ofs.close();
+                    }
+                }
+                std::error_code rc;
+#ifdef _WIN32
+                std::filesystem::remove(live_path, rc);
+                std::filesystem::rename(tmp, live_path, rc);
+                if (rc) {
+                    std::remove(tmp.c_str());
+                }
+#else
+                std::filesystem::rename(tmp, live_path, rc);
+                if (rc) {
+                    std::filesystem::remove(live_path, rc);
+                    std::filesystem::rename(tmp, live_path, rc);
                 }
+#endif
+            }
+            catch (...) {
+                // ignore single-write failures
+            }
+        }
 
-                // determine market folder:
-                // If caller provided a market string (non-empty), use that (sanitized).
-                // Otherwise fall back to "7208" or "7202" based on type.
-                std::string market_folder;
-                if (!t.market.empty()) market_folder = sanitize_component(t.market);
-                else market_folder = (t.type == 7208) ? "7208" : "7202";
+        // append every queued line for one historical file with a single writev
+        bool flush_historical(const std::string& path, const std::vector<std::string_view>& parts) {
+            int fd = hist_files_.get(path);
+            if (fd < 0) {
+                // folder removed underneath us: recreate it once and retry
+                std::filesystem::path dir = std::filesystem::path(path).parent_path();
+                dirs_made_.erase(dir.string());
+                ensure_dir(dir);
+                fd = hist_files_.get(path);
+                if (fd < 0) return false;
+            }
+            if (uring_.is_open() && uring_.append(fd, parts)) {
+                // queued: completes in the batch-end flush
+            }
+            else if (!write_all(fd, parts)) { hist_files_.close(path); return false; }
+            size_t b = 0;
+            for (const auto& p : parts) b += p.size();
+            bytes_.fetch_add(b, std::memory_order_relaxed);
+            return true;
+        }
 
-                std::filesystem::path pbase(base_dir_);
-                std::filesystem::path live_dir = pbase / "live" / market_folder;
-                std::filesystem::path hist_dir = pbase / "historical" / market_folder;
+        // LzoBlocks: compress d's pending lines and append the block, then its index entry.
+        // May run several times per batch for one dest: e.offset counts on the appends of a file
+        // landing in the order queued, which UringWriter keeps per fd (one write in flight).
+        void seal_block(Dest& d) {
+            if (d.blk.empty()) return;
+            if (!d.blk_sized) {
                 std::error_code ec;
-                std::filesystem::create_directories(live_dir, ec);
-                std::filesystem::create_directories(hist_dir, ec);
-
-                std::string token_str = std::to_string(t.token);
-                std::filesystem::path live_path = live_dir / (token_str + ".txt");
-                std::filesystem::path hist_path = hist_dir / (token_str + ".txt");
-
-                // normalize line
-                std::string line = t.csv;
-                while (!line.empty() && (line.back() == '\n' || line.back() == '\r')) line.pop_back();
-
-                // For 7208: convert Time field (index 10) if numeric unix seconds -> human
-                if (t.type == 7208) {
-                    auto parts = split_csv(line);
-                    if (parts.size() > 10) {
-                        try {
-                            uint64_t tm = std::stoull(parts[10]);
-                            parts[10] = unix_to_local(tm);
-                            line = join_csv(parts);
-                        }
-                        catch (...) { /* ignore parse errors */ }
-                    }
-                }
+                uint64_t sz = std::filesystem::file_size(d.blk_path, ec);
+                d.blk_size = ec ? 0 : sz;
+                d.blk_sized = true;
+            }
+            block_buffered_ -= std::min(block_buffered_, d.blk.raw_bytes());
+            raw_bytes_.fetch_add(d.blk.text.size(), std::memory_order_relaxed);
 
-                // For 7202: append current human-readable timestamp as an extra column,
-                // because 7202 CSV schema has no time field. This affects only file outputs,
-                // not the console/SHM original CSV.
-                if (t.type == 7202) {
-                    std::string ts = now_local_string();
-                    // Append as new CSV column
-                    line += ",";
-                    line += ts;
+            std::string& block = block_buf_;
+            HistBlocks::IndexEntry e{};
+            encoder_.seal(d.blk, block, e);
+
+            std::vector<std::string_view> parts;
+            if (d.blk_size == 0) parts.push_back(file_hdr_);
+            parts.push_back(block);
+            e.offset = d.blk_size + (d.blk_size == 0 ? file_hdr_.size() : 0);
+            if (!flush_historical(d.blk_path, parts)) { d.blk_sized = false; return; }
+            d.blk_size = e.offset + block.size();
+
+            index_buf_.assign(reinterpret_cast<const char*>(&e), sizeof(e));
+            flush_historical(d.idx_path, { index_buf_ });   // a missing entry is recovered by the reader's scan
+            blocks_.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        // Text: move d to its next segment when the day changed (daily) or this batch's add
+        // bytes would take it past rotate_bytes. A restart resumes the last part with room.
+        void rotate_text(Dest& d, uint64_t add) {
+            const std::string old = d.hist_path;
+            if (sh_.rotate_daily) {
+                const uint32_t day = day_for(batch_sec_);
+                if (day != d.seg_day) { d.seg_day = day; d.seg_part = 0; d.seg_sized = false; }
+            }
+            for (;;) {
+                std::string p = d.hist_stem;
+                if (sh_.rotate_daily) p += "-" + std::to_string(d.seg_day);
+                if (d.seg_part) p += "." + std::to_string(d.seg_part);
+                p += ".txt";
+                d.hist_path = std::move(p);
+                if (!sh_.rotate_bytes) break;
+                if (!d.seg_sized) {
+                    std::error_code ec;
+                    uint64_t sz = std::filesystem::file_size(d.hist_path, ec);
+                    d.seg_bytes = ec ? 0 : sz;
+                    d.seg_sized = true;
                 }
+                if (d.seg_bytes == 0 || d.seg_bytes + add <= sh_.rotate_bytes) break;
+                ++d.seg_part;
+                d.seg_sized = false;
+            }
+            if (!old.empty() && old != d.hist_path) {
+                hist_files_.retire(old);        // trims its preallocation, drops its cache
+                rotations_.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
 
-                // write latest atomically
-                try {
-                    std::string tmp = live_path.string() + ".tmp";
-                    {
-                        std::ofstream ofs(tmp, std::ios::binary | std::ios::trunc);
-                        if (ofs) {
-                            ofs << line << "\n";
-                            ofs.flush();
-                            ofs.close();
-                        }
-                    }
-                    std::error_code rc;
+        // local day of a unix time (days change rarely; keep the current one's range)
+        uint32_t day_for(uint32_t ts) {
+            if (ts >= day_lo_ && ts <= day_hi_) return day_;
+            day_ = TickStore::day_of(ts);
+            std::time_t tt = static_cast<std::time_t>(ts);
+            std::tm tm{};
 #ifdef _WIN32
-                    std::filesystem::remove(live_path, rc);
-                    std::filesystem::rename(tmp, live_path, rc);
-                    if (rc) {
-                        std::remove(tmp.c_str());
-                    }
+            localtime_s(&tm, &tt);
 #else
-                    std::filesystem::rename(tmp, live_path, rc);
-                    if (rc) {
-                        std::filesystem::remove(live_path, rc);
-                        std::filesystem::rename(tmp, live_path, rc);
-                    }
+            localtime_r(&tt, &tm);
 #endif
+            tm.tm_hour = 0; tm.tm_min = 0; tm.tm_sec = 0; tm.tm_isdst = -1;
+            const std::time_t midnight = std::mktime(&tm);
+            tm.tm_mday += 1; tm.tm_isdst = -1;
+            const std::time_t next = std::mktime(&tm);
+            day_lo_ = static_cast<uint32_t>(midnight);
+            day_hi_ = static_cast<uint32_t>(next - 1);
+            if (ts < day_lo_ || ts > day_hi_) { day_lo_ = 1; day_hi_ = 0; }    // odd clock: no caching
+            return day_;
+        }
+
+        // Columnar: ticks/<day>/<type>/<create_ns>-s<shard>.col
+        void write_segment(uint16_t type, TickStore::SegmentBuilder& b) {
+            std::filesystem::path dir = std::filesystem::path(sh_.base_dir) / "ticks" /
+                std::to_string(b.day()) / TickStore::type_name(type);
+            ensure_dir(dir);
+            const uint64_t ns = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::system_clock::now().time_since_epoch()).count());
+            char name[48];
+            std::snprintf(name, sizeof(name), "%020llu-s%02u", static_cast<unsigned long long>(ns), static_cast<unsigned>(id_));
+            const uint64_t n = b.write(dir.string(), name);
+            if (!n) {
+                std::cerr << "[FILE] cannot write tick segment under " << dir.string() << "\n";
+                return;
+            }
+            bytes_.fetch_add(n, std::memory_order_relaxed);
+            segments_.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        // Columnar: add the handler's line (before the file-only column edits) to its type's segment
+        void add_tick(const RecordMeta& m, const std::string& line) {
+            auto it = ticks_.find(m.type);
+            if (it == ticks_.end()) {
+                if (TickStore::type_name(m.type).empty()) return;     // no schema for this type
+                it = ticks_.emplace(m.type, std::unique_ptr<TickStore::SegmentBuilder>(new TickStore::SegmentBuilder(m.type))).first;
+            }
+            TickStore::SegmentBuilder& b = *it->second;
+            const uint32_t ts = m.exch_time ? m.exch_time : batch_sec_;
+            const uint32_t day = day_for(ts);
+            if (b.rows() && b.day() != day) write_segment(m.type, b);
+            b.set_day(day);
+            if (b.add(ts, line)) raw_bytes_.fetch_add(line.size() + 1, std::memory_order_relaxed);
+            if (b.rows() >= sh_.tick_rows) write_segment(m.type, b);
+        }
+
+        // LzoBlocks / Columnar: write blocks and segments whose first line is older than their
+        // age limit (everything when force)
+        void seal_aged(bool force) {
+            if (open_blocks_.empty() && ticks_.empty()) return;
+            const uint64_t now = steady_ms();
+            if (!force && now < next_age_check_ms_) return;
+            const uint64_t tick_ms = static_cast<uint64_t>(sh_.tick_secs) * 1000;
+            next_age_check_ms_ = now + std::max<uint64_t>(10, std::min<uint64_t>(sh_.block_age_ms, tick_ms) / 4);
+            size_t keep = 0;
+            for (Dest* d : open_blocks_) {
+                if (!d->blk.empty() && (force || now - d->blk.opened_ms >= sh_.block_age_ms)) seal_block(*d);
+                if (d->blk.empty()) d->blk_listed = false;
+                else open_blocks_[keep++] = d;
+            }
+            open_blocks_.resize(keep);
+            for (auto& kv : ticks_) {
+                TickStore::SegmentBuilder& b = *kv.second;
+                if (b.rows() && (force || now - b.opened_ms() >= tick_ms)) write_segment(kv.first, b);
+            }
+        }
+
+        // wait for queued io_uring writes (the batch is on disk, or at least in the page cache)
+        void complete_io() {
+            if (uring_.is_open()) {
+                uring_.flush();
+                io_enters_.store(uring_.stats().enters, std::memory_order_relaxed);
+            }
+        }
+
+        // Periodic / Batch durability: fdatasync the files written since their last sync
+        void sync_files() {
+            if (sh_.durability == FileWriter::Durability::Periodic) {
+                const uint64_t now = steady_ms();
+                if (now < next_sync_ms_) return;
+                next_sync_ms_ = now + sh_.sync_interval_ms;
+            }
+            else if (sh_.durability != FileWriter::Durability::Batch) return;
+            hist_files_.sync_dirty();
+            syncs_.store(hist_files_.syncs(), std::memory_order_relaxed);
+            sync_errors_.store(hist_files_.sync_errors(), std::memory_order_relaxed);
+        }
+
+        static uint64_t steady_ms() {
+            return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count());
+        }
+
+        // sleep until a producer signals (or a short timeout) while the queue is empty
+        void wait_for_work() {
+            std::unique_lock<std::mutex> lk(wake_mtx_);
+            sleeping_.store(true);
+            if (depth_.load() == 0 && !stop_.load())
+                wake_cv_.wait_for(lk, std::chrono::milliseconds(50));
+            sleeping_.store(false, std::memory_order_relaxed);
+        }
+
+        // group commit: give producers up to the flush interval to fill the batch
+        void linger(std::chrono::steady_clock::time_point deadline) {
+            std::unique_lock<std::mutex> lk(wake_mtx_);
+            lingering_.store(true);
+            sleeping_.store(true);
+            wake_cv_.wait_until(lk, deadline, [&] { return depth_.load() >= sh_.max_batch || stop_.load(); });
+            sleeping_.store(false, std::memory_order_relaxed);
+            lingering_.store(false, std::memory_order_relaxed);
+        }
+
+        void thread_main() {
+            std::vector<Task> tasks;
+            tasks.reserve(sh_.max_batch);
+            while (true) {
+                uint64_t avail = depth_.load();
+                if (avail == 0) {
+                    if (stop_.load()) break;
+                    seal_aged(false);
+                    complete_io();
+                    sync_files();
+                    wait_for_work();
+                    continue;
                 }
-                catch (...) {
-                    // ignore single-write failures
+                if (sh_.flush_interval_us && avail < sh_.max_batch && !stop_.load()) {
+                    linger(std::chrono::steady_clock::now() + std::chrono::microseconds(sh_.flush_interval_us));
+                    avail = depth_.load();
                 }
+                if (avail > sh_.max_batch) avail = sh_.max_batch;
 
-                // append historical
-                try {
-                    std::ofstream ofs(hist_path.string(), std::ios::binary | std::ios::app);
-                    if (ofs) {
-                        ofs << line << "\n";
-                        ofs.flush();
+                // DropOldest: discard the oldest lines until the ring is back to half its budget.
+                // Bounded by depth: a published record whose producer has not counted it yet
+                // must not drive depth_ below zero.
+                if (shed_.exchange(false, std::memory_order_relaxed)) {
+                    uint64_t shed = 0;
+                    const uint64_t counted = depth_.load();
+                    Task t;
+                    while (shed < counted && ring_.used() > ring_.capacity() / 2 && ring_.front(t)) { ring_.pop(); ++shed; }
+                    depth_.fetch_sub(shed);
+                    dropped_.fetch_add(shed, std::memory_order_relaxed);
+                    shed_lines_.fetch_add(shed, std::memory_order_relaxed);
+                    avail = std::min<uint64_t>(depth_.load(), sh_.max_batch);
+                    if (avail == 0) continue;
+                }
+
+                // copy up to max_batch lines out of the ring into reused Task buffers
+                size_t n = 0;
+                while (n < avail) {
+                    if (n == tasks.size()) tasks.emplace_back();
+                    if (!ring_.front(tasks[n])) {
+                        if (ring_.used() == 0) break;       // nothing reserved: depth ran ahead
+                        std::this_thread::yield();          // producer mid-copy
+                        continue;
                     }
+                    ring_.pop();
+                    ++n;
                 }
-                catch (...) {
-                    // ignore
+                depth_.fetch_sub(n);
+                if (blocked_.load()) {
+                    std::lock_guard<std::mutex> lk(space_mtx_);
+                    space_cv_.notify_all();
                 }
+
+                auto t0 = std::chrono::steady_clock::now();
+                write_batch(tasks, n);
+                auto t1 = std::chrono::steady_clock::now();
+
+                lines_.fetch_add(n, std::memory_order_relaxed);
+                batches_.fetch_add(1, std::memory_order_relaxed);
+                if (n > max_batch_seen_.load(std::memory_order_relaxed))
+                    max_batch_seen_.store(n, std::memory_order_relaxed);
+                const uint64_t ns = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count());
+                busy_ns_.fetch_add(ns, std::memory_order_relaxed);
+                const uint64_t us = ns / 1000;
+                commit_hist_[bucket_of(us)].fetch_add(1, std::memory_order_relaxed);
+                if (us > commit_max_us_.load(std::memory_order_relaxed)) commit_max_us_.store(us, std::memory_order_relaxed);
             } // while
+            seal_aged(true);
+            complete_io();
+            hist_files_.retire_all();           // trim / drop cache of live segments
+            hist_files_.close_all();            // syncs what is still dirty
+            syncs_.store(hist_files_.syncs(), std::memory_order_relaxed);
+            sync_errors_.store(hist_files_.sync_errors(), std::memory_order_relaxed);
+            uring_.close();
+        }
+
+        // One batch: format every line, then touch each destination once
+        // (latest value from its last line, historical append of all its lines).
+        void write_batch(std::vector<Task>& tasks, size_t n) {
+            batch_now_ = now_local_string();    // 7202 time column, once per batch
+            batch_sec_ = static_cast<uint32_t>(std::time(nullptr));
+            const bool text = (sh_.hist_format == FileWriter::HistFormat::Text);
+            for (size_t i = 0; i < n; ++i) {
+                process(tasks[i]);
+            }
+            for (Dest* d : touched_) {
+                // d->latest ends with '\n'; the snapshot slot stores the bare line
+                if (d->snap && !d->snap->update(d->token, std::string_view(*d->latest).substr(0, d->latest->size() - 1))) {
+                    // table full (slots outlive tokens across restarts): keep this token's
+                    // latest value as a text view instead of losing it
+                    d->snap = nullptr;
+                    if (!d->text_view) { ensure_dir(d->live_text.parent_path()); d->text_view = true; }
+                    snap_full_.fetch_add(1, std::memory_order_relaxed);
+                }
+                if (d->text_view) write_live_text(d->live_text, *d->latest);
+                if (text) {
+                    uint64_t add = 0;
+                    if (sh_.rotate_daily || sh_.rotate_bytes) {
+                        for (const auto& p : d->hist) add += p.size();
+                        rotate_text(*d, add);
+                    }
+                    if (flush_historical(d->hist_path, d->hist)) d->seg_bytes += add;
+                    else d->seg_sized = false;
+                }
+                d->hist.clear();
+                d->latest = nullptr;
+            }
+            touched_.clear();
+            if (!text) seal_aged(block_buffered_ > kBlockBudget);
+            complete_io();
+            sync_files();
+            if (dests_.size() > 4 * sh_.max_open_files + 4096) {
+                // keep the path map bounded (partial blocks go out first: they live in the map)
+                seal_aged(true);
+                complete_io();
+                dests_.clear();
+            }
+        }
+
+        // resolve (once) where a (market, token) pair is written
+        Dest& dest_for(const RecordMeta& m) {
+            const uint64_t key = (static_cast<uint64_t>(m.type) << 48) | (static_cast<uint64_t>(m.market) << 32) | m.token;
+            auto it = dests_.find(key);
+            if (it != dests_.end()) return it->second;
+
+            Dest& d = dests_[key];
+            // determine market folder from the handler's metadata (no CSV re-parse)
+            const std::string market_folder = sanitize_component(market_folder_for(m));
+            const std::string token_str = std::to_string(m.token);
+            std::filesystem::path pbase(sh_.base_dir);
+            std::filesystem::path hist_dir = pbase / "historical" / market_folder;
+            ensure_dir(pbase / "live");
+            if (sh_.hist_format != FileWriter::HistFormat::Columnar) ensure_dir(hist_dir);
+            d.token = m.token;
+            if (sh_.hist_format == FileWriter::HistFormat::LzoBlocks) {
+                d.blk_path = (hist_dir / (token_str + ".hlz")).string();
+                d.idx_path = HistBlocks::index_path(d.blk_path);
+            }
+            else if (sh_.hist_format == FileWriter::HistFormat::Text) {
+                d.hist_stem = (hist_dir / token_str).string();
+                if (!sh_.rotate_daily && !sh_.rotate_bytes) d.hist_path = d.hist_stem + ".txt";  // else rotate_text
+            }
+
+            d.text_view = (sh_.live_mode != FileWriter::LiveMode::Snapshot);
+            if (sh_.live_mode != FileWriter::LiveMode::Text) {
+                d.snap = snapshot_for(market_folder);
+                if (!d.snap) d.text_view = true;
+            }
+            // path kept for the snapshot-full fallback; the directory is made when first used
+            d.live_text = pbase / "live" / market_folder / (token_str + ".txt");
+            if (d.text_view) ensure_dir(d.live_text.parent_path());
+            return d;
+        }
+
+        // 7208 exchange seconds -> local time text; consecutive records mostly share a second
+        const std::string& exch_time_text(uint32_t unixsec) {
+            if (unixsec != exch_sec_ || exch_str_.empty()) {
+                exch_sec_ = unixsec;
+                exch_str_ = unix_to_local(unixsec);
+            }
+            return exch_str_;
+        }
+
+        void process(Task& t) {
+            Dest& d = dest_for(t.meta);
+
+            // normalize line (in place: the batch keeps pointing into t.csv)
+            std::string& line = t.csv;
+            while (!line.empty() && (line.back() == '\n' || line.back() == '\r')) line.pop_back();
+            if (sh_.hist_format == FileWriter::HistFormat::Columnar) add_tick(t.meta, line);
+
+            // For 7208: Time field (index 10) is unix seconds; the handler passed it in meta
+            if (t.meta.type == 7208 && t.meta.exch_time) {
+                replace_csv_field(line, 10, exch_time_text(t.meta.exch_time));
+            }
+
+            // For 7202: append current human-readable timestamp as an extra column,
+            // because 7202 CSV schema has no time field. This affects only file outputs,
+            // not the console/SHM original CSV.
+            if (t.meta.type == 7202) {
+                line += ",";
+                line += batch_now_;
+            }
+
+            line += '\n';
+
+            if (!d.latest) touched_.push_back(&d);
+            d.latest = &line;
+            if (sh_.hist_format == FileWriter::HistFormat::LzoBlocks) {
+                if (d.blk.empty()) d.blk.opened_ms = steady_ms();
+                if (!d.blk_listed) { open_blocks_.push_back(&d); d.blk_listed = true; }
+                d.blk.add(t.meta.exch_time ? t.meta.exch_time : batch_sec_, line);
+                block_buffered_ += sizeof(uint32_t) + line.size();
+                if (d.blk.raw_bytes() >= sh_.block_bytes) seal_block(d);
+            }
+            else if (sh_.hist_format == FileWriter::HistFormat::Text) {
+                d.hist.push_back(line);
+            }
         }
     };
 
+    // ----------------- Impl (hidden) -----------------
+    // Not nested in FileWriter; kept in anon namespace to avoid leaking symbols.
+    class Impl {
+    public:
+        Impl() = default;
+        ~Impl() { stop(); }
+
+        void start(const std::string& baseDir) {
+            std::lock_guard<std::mutex> lk(mutex_);
+            if (running_) return;
+            shards_.clear();                    // previous run (stopped)
+
+            if (baseDir.empty()) {
+                std::string ed = exe_dir();
+                sh_.base_dir = (std::filesystem::path(ed) / "data").string();
+            }
+            else {
+                sh_.base_dir = baseDir;
+            }
+
+            std::error_code ec;
+            std::filesystem::create_directories(sh_.base_dir, ec);
+
+            const size_t fd_budget = std::max<size_t>(1, sh_.max_open_files / shard_count_);
+            for (size_t i = 0; i < shard_count_; ++i) shards_.emplace_back(new Shard(sh_, i));
+            size_t io_fallbacks = 0;
+            for (auto& s : shards_) if (!s->start(fd_budget)) ++io_fallbacks;
+            if (io_fallbacks) std::cerr << "[FILE] io_uring unavailable; " << io_fallbacks << " shard(s) use blocking writes\n";
+            running_ = true;
+        }
+
+        // Shards stay allocated after stop (enqueue then returns false; stats stay readable)
+        void stop() {
+            std::lock_guard<std::mutex> lk(mutex_);
+            if (!running_) return;
+            for (auto& s : shards_) s->stop();
+            sh_.snaps.clear();
+            running_ = false;
+        }
+
+        // Route by token so each file keeps a single writer (and its line order)
+        bool enqueue(const RecordMeta& meta, std::string_view csv) {
+            const size_t n = shards_.size();
+            if (!n) return false;
+            size_t idx = n == 1 ? 0 : static_cast<size_t>(
+                (static_cast<uint64_t>(meta.token) * 0x9E3779B97F4A7C15ull) >> 32) % n;
+            return shards_[idx]->enqueue(meta, csv);
+        }
+
+        // configuration is fixed while the shards run
+        void set_queue_bytes(size_t b) { std::lock_guard<std::mutex> lk(mutex_); if (!running_ && b) sh_.queue_bytes = std::min<size_t>(b, 1u << 30); }
+        void set_overflow(FileWriter::Overflow p) { std::lock_guard<std::mutex> lk(mutex_); if (!running_) sh_.overflow = p; }
+        void set_max_open_files(size_t n) { std::lock_guard<std::mutex> lk(mutex_); if (!running_) sh_.max_open_files = n ? n : 1; }
+        void set_live_mode(FileWriter::LiveMode m) { std::lock_guard<std::mutex> lk(mutex_); if (!running_) sh_.live_mode = m; }
+        void set_io_backend(FileWriter::IoBackend b) { std::lock_guard<std::mutex> lk(mutex_); if (!running_) sh_.io = b; }
+        void set_hist_format(FileWriter::HistFormat f, size_t block_bytes, unsigned block_age_ms) {
+            std::lock_guard<std::mutex> lk(mutex_);
+            if (running_) return;
+            sh_.hist_format = f;
+            if (block_bytes) sh_.block_bytes = block_bytes;
+            sh_.block_age_ms = block_age_ms;
+        }
+        void set_hist_rotation(bool daily, uint64_t max_bytes) {
+            std::lock_guard<std::mutex> lk(mutex_);
+            if (running_) return;
+            sh_.rotate_daily = daily;
+            sh_.rotate_bytes = max_bytes;
+        }
+        void set_durability(FileWriter::Durability d, unsigned interval_ms) {
+            std::lock_guard<std::mutex> lk(mutex_);
+            if (running_) return;
+            sh_.durability = d;
+            if (interval_ms) sh_.sync_interval_ms = interval_ms;
+        }
+        void set_hist_prealloc(uint64_t bytes, bool drop_cache) {
+            std::lock_guard<std::mutex> lk(mutex_);
+            if (running_) return;
+            sh_.prealloc_bytes = bytes;
+            sh_.drop_cache = drop_cache;
+        }
+        void set_tick_segments(size_t rows, unsigned secs) {
+            std::lock_guard<std::mutex> lk(mutex_);
+            if (running_) return;
+            if (rows) sh_.tick_rows = rows;
+            if (secs) sh_.tick_secs = secs;
+        }
+        void set_live_slots(uint32_t count, uint32_t bytes) {
+            std::lock_guard<std::mutex> lk(mutex_);
+            if (running_) return;
+            if (count) sh_.live_slots = count;
+            if (bytes) sh_.live_slot_bytes = bytes;
+        }
+        void set_shards(size_t n) { std::lock_guard<std::mutex> lk(mutex_); if (!running_) shard_count_ = n ? n : 1; }
+        void set_batching(size_t max_batch, unsigned flush_interval_us) {
+            std::lock_guard<std::mutex> lk(mutex_);
+            if (running_) return;
+            sh_.max_batch = max_batch ? max_batch : 1;
+            sh_.flush_interval_us = flush_interval_us;
+        }
+        size_t shards() const { return shard_count_; }
+
+        uint64_t dropped() const {
+            uint64_t d = 0;
+            for (const auto& s : shards_) d += s->dropped();
+            return d;
+        }
+
+        std::vector<FileWriter::ShardStats> stats() const {
+            std::vector<FileWriter::ShardStats> v;
+            for (const auto& s : shards_) v.push_back(s->stats());
+            return v;
+        }
+
+    private:
+        std::mutex mutex_;                      // start/stop/config only (not the enqueue path)
+        Shared sh_;
+        size_t shard_count_ = 1;
+        bool running_ = false;
+        std::vector<std::unique_ptr<Shard>> shards_;
+    };
+
     // single global impl instance (hidden)
     static Impl* g_impl = nullptr;
 
@@ -312,9 +1386,83 @@ void FileWriter::start(const std::string& baseDir) {
 void FileWriter::stop() {
     if (g_impl) g_impl->stop();
 }
-void FileWriter::enqueue(uint16_t type, uint32_t token, const std::string& csvLine, const std::string& market) {
-    if (g_impl) g_impl->enqueue(type, token, csvLine, market);
+bool FileWriter::enqueue(const RecordMeta& meta, std::string_view csvLine) {
+    return g_impl ? g_impl->enqueue(meta, csvLine) : false;
 }
-void FileWriter::set_max_queue_size(size_t maxq) {
-    if (g_impl) g_impl->set_max_queue(maxq);
+void FileWriter::set_queue_bytes(size_t bytes) {
+    if (g_impl) g_impl->set_queue_bytes(bytes);
+}
+void FileWriter::set_overflow_policy(Overflow p) {
+    if (g_impl) g_impl->set_overflow(p);
+}
+void FileWriter::set_live_mode(LiveMode m) {
+    if (g_impl) g_impl->set_live_mode(m);
+}
+void FileWriter::set_live_slots(uint32_t slot_count, uint32_t slot_bytes) {
+    if (g_impl) g_impl->set_live_slots(slot_count, slot_bytes);
+}
+void FileWriter::set_max_open_files(size_t n) {
+    if (g_impl) g_impl->set_max_open_files(n);
+}
+uint64_t FileWriter::dropped() const {
+    return g_impl ? g_impl->dropped() : 0;
+}
+void FileWriter::set_io_backend(IoBackend b) {
+    if (g_impl) g_impl->set_io_backend(b);
+}
+void FileWriter::set_hist_format(HistFormat f, size_t block_bytes, unsigned block_age_ms) {
+    if (g_impl) g_impl->set_hist_format(f, block_bytes, block_age_ms);
+}
+void FileWriter::set_hist_rotation(bool daily, uint64_t max_bytes) {
+    if (g_impl) g_impl->set_hist_rotation(daily, max_bytes);
+}
+void FileWriter::set_durability(Durability d, unsigned interval_ms) {
+    if (g_impl) g_impl->set_durability(d, interval_ms);
+}
+void FileWriter::set_hist_prealloc(uint64_t bytes, bool drop_cache) {
+    if (g_impl) g_impl->set_hist_prealloc(bytes, drop_cache);
+}
+void FileWriter::set_tick_segments(size_t rows, unsigned secs) {
+    if (g_impl) g_impl->set_tick_segments(rows, secs);
+}
+void FileWriter::set_batching(size_t max_batch, unsigned flush_interval_us) {
+    if (g_impl) g_impl->set_batching(max_batch, flush_interval_us);
+}
+void FileWriter::set_shards(size_t n) {
+    if (g_impl) g_impl->set_shards(n);
+}
+size_t FileWriter::shards() const {
+    return g_impl ? g_impl->shards() : 0;
+}
+std::vector<FileWriter::ShardStats> FileWriter::stats() const {
+    return g_impl ? g_impl->stats() : std::vector<ShardStats>{};
+}
+void FileWriter::print_stats(std::ostream& os) const {
+    std::vector<ShardStats> v = stats();
+    std::ostringstream ss;
+    for (size_t i = 0; i < v.size(); ++i) {
+        const ShardStats& s = v[i];
+        ss << "[FILE] shard " << i << " lines=" << s.lines << " bytes=" << s.bytes
+            << " batches=" << s.batches << " lines/batch=" << (s.batches ? s.lines / s.batches : 0)
+            << " max_batch=" << s.max_batch << " dropped=" << s.dropped << " shed=" << s.shed
+            << " depth=" << s.depth << " depth_hwm=" << s.depth_hwm
+            << " queue_kb=" << (s.queue_bytes >> 10) << "/" << (s.queue_budget >> 10)
+            << " queue_hwm_kb=" << (s.queue_bytes_hwm >> 10)
+            << " busy_ms=" << (s.busy_ns / 1000000)
+            << " io=" << (s.io_uring ? "uring" : "blocking");
+        if (s.io_uring) ss << " enters=" << s.io_enters;
+        if (s.blocks) ss << " blocks=" << s.blocks;
+        if (s.segments) ss << " segments=" << s.segments;
+        if (s.rotations) ss << " rotations=" << s.rotations;
+        if (s.snap_full) ss << " snap_full=" << s.snap_full;
+        if (s.syncs) ss << " syncs=" << s.syncs;
+        if (s.sync_errors) ss << " sync_errors=" << s.sync_errors;
+        ss << " commit_us p50=" << s.commit_p50_us << " p99=" << s.commit_p99_us << " max=" << s.commit_max_us;
+        if (s.blocks || s.segments) {
+            ss << " raw_bytes=" << s.raw_bytes << " ratio="
+                << std::fixed << std::setprecision(2) << (s.bytes ? static_cast<double>(s.raw_bytes) / s.bytes : 0.0);
+        }
+        ss << "\n";
+    }
+    os << ss.str();
 }
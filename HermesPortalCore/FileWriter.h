@@ -1,31 +1,155 @@
 #pragma once
 // FileWriter: non-blocking file writer for HermesPortal
-// Writes latest (overwrite) and historical (append) CSV lines per token.
+// Writes latest (memory-mapped snapshot and/or overwrite) and historical (append) CSV lines per token.
 // Default base directory is the executable directory + "/data" (unless start() is given another base).
 
 #include <string>
+#include <string_view>
+#include <vector>
+#include <ostream>
 #include <cstdint>
 #include <cstddef>
 
+#include "includes/record_meta.h"
+
 class FileWriter {
 public:
+    // What enqueue() does when a shard's queue ring is full:
+    //   DropOldest: the line is dropped and the shard thread sheds its oldest queued lines
+    //               until the ring is half empty (counted in dropped and shed)
+    //   DropNewest: the line is dropped
+    //   Block:      the caller waits for room
+    enum class Overflow { DropOldest, DropNewest, Block };
+
+    // Where the latest line per token goes:
+    //   Snapshot: live/<market>.snap, one seqlock slot per token (see LiveSnapshot.h)
+    //             a token that finds the table full falls back to its text file (snap_full)
+    //   Text:     live/<market>/<token>.txt rewritten via tmp+rename (legacy view)
+    //   Both:     snapshot plus the legacy text files
+    enum class LiveMode { Snapshot, Text, Both };
+
+    // Historical append path: blocking writev, or io_uring (Linux; registered buffers and
+    // fixed files, many appends in flight). IoUring falls back to Blocking when unavailable.
+    enum class IoBackend { Blocking, IoUring };
+
+    // Historical file format:
+    //   Text:      CSV lines appended to historical/<market>/<token>.txt
+    //   LzoBlocks: each token's lines are buffered into blocks, LZO1X-compressed and appended to
+    //              <token>.hlz with a timestamp index in <token>.hlx (see HistBlocks.h; read back
+    //              with --hist-dump). Trades CPU for a fraction of the disk bandwidth.
+    //   Columnar:  no per-token files; each shard writes ticks/<YYYYMMDD>/<type>/*.col segments
+    //              of fixed-width columns with a token index (see TickStore.h; --tick-query).
+    enum class HistFormat { Text, LzoBlocks, Columnar };
+
+    // When historical appends (Text, LzoBlocks) reach stable storage:
+    //   None:     left to the OS page cache
+    //   Periodic: fdatasync of the files written, at most every interval_ms
+    //   Batch:    fdatasync of the files written, after every batch (group commit)
+    //   DSync:    files opened O_DSYNC (write-through on Windows); each append waits for the disk
+    // Live snapshots and columnar segments are not covered.
+    enum class Durability { None, Periodic, Batch, DSync };
+
+    // Per writer-shard counters (see set_shards).
+    struct ShardStats {
+        uint64_t enqueued = 0;                  // lines accepted
+        uint64_t lines = 0;                     // lines written
+        uint64_t bytes = 0;                     // historical bytes appended
+        uint64_t raw_bytes = 0;                 // LzoBlocks/Columnar: CSV bytes in
+        uint64_t blocks = 0;                    // LzoBlocks: blocks written
+        uint64_t segments = 0;                  // Columnar: segments written
+        uint64_t rotations = 0;                 // Text: historical segments rotated out
+        uint64_t snap_full = 0;                 // tokens moved to a live text view: snapshot table full
+        uint64_t batches = 0;                   // group commits (lines/batch = lines / batches)
+        uint64_t max_batch = 0;                 // largest batch written
+        uint64_t dropped = 0;                   // lines discarded by the overflow policy
+        uint64_t shed = 0;                      // DropOldest: queued lines discarded (part of dropped)
+        uint64_t depth = 0;                     // current queue depth (lines)
+        uint64_t depth_hwm = 0;                 // queue high-water mark (lines)
+        uint64_t queue_bytes = 0;               // ring bytes in use
+        uint64_t queue_bytes_hwm = 0;           // ring high-water mark (bytes)
+        uint64_t queue_budget = 0;              // ring size (bytes)
+        uint64_t busy_ns = 0;                   // time spent writing
+        bool io_uring = false;                  // shard runs the io_uring backend
+        uint64_t io_enters = 0;                 // io_uring_enter calls
+        uint64_t syncs = 0;                     // fdatasync calls (Periodic / Batch)
+        uint64_t sync_errors = 0;               // failed fdatasync calls
+        uint64_t commit_p50_us = 0;             // batch commit time (format + write + sync)
+        uint64_t commit_p99_us = 0;
+        uint64_t commit_max_us = 0;
+    };
+
     FileWriter();
     ~FileWriter();
 
-    // Start worker thread; baseDir empty => executable-dir + "/data"
+    // Start writer shard threads; baseDir empty => executable-dir + "/data"
     void start(const std::string& baseDir = "");
 
-    // Stop worker thread and flush queue
+    // Stop writer threads after flushing their queues
     void stop();
 
-    // Enqueue a CSV line. type should be 7208 or 7202. csv may include trailing newline.
-    // market: optional string used to choose subfolder (if empty, FileWriter falls back to defaults:
-    //         for 7208 -> "7208"; for 7202 -> "7202").
-    // This function is thread-safe and returns immediately.
-    void enqueue(uint16_t type, uint32_t token, const std::string& csvLine, const std::string& market = "");
+    // Enqueue a CSV line with the handler's metadata. csv may include trailing newline.
+    // Subfolder: 7202 -> meta.market (e.g. "2"), 7208 -> "7208", CM -> "CT"/"PN".
+    // 7208 uses meta.exch_time for the human-readable Time column (no CSV re-parse).
+    // Lines are routed to shard hash(token) % shards, so each file has one writer and keeps
+    // its line order. Thread-safe, lock-free and allocation-free (the line is copied into the
+    // shard's preallocated ring); returns immediately unless the policy is Block.
+    // Returns false when the line was rejected (full ring and a Drop policy, or not started).
+    bool enqueue(const RecordMeta& meta, std::string_view csvLine);
+
+    // Queue memory budget per shard in bytes (optional, before start); rounded up to a power
+    // of two, at most 1 GiB. A line takes its length + 20 bytes rounded up to 8. Default 4 MiB.
+    void set_queue_bytes(size_t bytes);
+
+    // Configure overflow policy (optional). Default DropOldest.
+    void set_overflow_policy(Overflow p);
+
+    // Configure the live view (optional). Default Snapshot, 16384 slots x 512 bytes per market.
+    void set_live_mode(LiveMode m);
+    void set_live_slots(uint32_t slot_count, uint32_t slot_bytes);
+
+    // Max historical files kept open, split across shards (LRU; least recently written is closed). Default 512.
+    void set_max_open_files(size_t n);
+
+    // Historical I/O backend (optional, before start). Default Blocking.
+    void set_io_backend(IoBackend b);
+
+    // Historical format (optional, before start). Default Text. With LzoBlocks a block is
+    // written when it holds block_bytes of lines or its oldest line is block_age_ms old.
+    void set_hist_format(HistFormat f, size_t block_bytes = 64 * 1024, unsigned block_age_ms = 1000);
+
+    // Durability policy (optional, before start). Default None; Periodic syncs every
+    // interval_ms (default 1000).
+    void set_durability(Durability d, unsigned interval_ms = 0);
+
+    // Text historical rotation (optional, before start). daily: one file per local day,
+    // <token>-<YYYYMMDD>.txt; max_bytes > 0: a file that would grow past it continues in
+    // <token>[-<YYYYMMDD>].<n>.txt. Default off (one <token>.txt forever).
+    void set_hist_rotation(bool daily, uint64_t max_bytes);
+
+    // Text historical files (optional, before start): reserve bytes of disk when a segment is
+    // first opened (fallocate KEEP_SIZE; capped at the rotation size) and give back the unused
+    // rest when it rotates out or at stop(); drop_cache also evicts those segments from the page
+    // cache (posix_fadvise DONTNEED). fd cache evictions do neither. Default 0 / false.
+    void set_hist_prealloc(uint64_t bytes, bool drop_cache);
+
+    // Columnar segments (optional, before start): a segment is written per type when it holds
+    // rows rows, its first row is secs old, the day changes, or at stop. Default 262144 / 300.
+    void set_tick_segments(size_t rows, unsigned secs);
+
+    // Group commit (optional, before start): each shard writes up to max_batch lines at once,
+    // touching every destination file once per batch. With flush_interval_us > 0 a shard that
+    // wakes to a partial batch waits up to that long for more lines. Default 4096 / 0.
+    void set_batching(size_t max_batch, unsigned flush_interval_us);
+
+    // Number of writer shards (optional, before start). Default 1.
+    void set_shards(size_t n);
+    size_t shards() const;
+
+    // Lines discarded by the overflow policy since start.
+    uint64_t dropped() const;
 
-    // Configure queue size (optional). Default 10000.
-    void set_max_queue_size(size_t maxq);
+    std::vector<ShardStats> stats() const;
+    void print_stats(std::ostream& os) const;
 
 private:
     // non-copyable
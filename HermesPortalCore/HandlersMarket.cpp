@@ -52,7 +52,7 @@ void Handler7208::handle(const MessageView& mv, ConsoleSink& out,
     uint16_t n = 0; std::memcpy(&n, d + BASE + 40, 2); n = ntohs(n);
     if (n == 0) return;
 
-    static constexpr int REC_BYTES = 214;
+    static constexpr int REC_BYTES = kRecordBytes;
     const int REC0 = BASE + 42;
 
     static constexpr int OFF_TOKEN = 0;
@@ -111,22 +111,26 @@ void Handler7208::handle(const MessageView& mv, ConsoleSink& out,
         const float ltpR = ltp / 100.0f;
         const float atpR = atp / 100.0f;
 
-        std::ostringstream os;
-        os << token << ",7208,"
-            << floatToString(ltpR) << ','
-            << floatToString(atpR) << ','
-            << floatToString(bdpR) << ','
-            << bdq << ','
-            << floatToString(aspR) << ','
-            << asq << ','
-            << (long long)(buyQ + 0.5) << ','
-            << (long long)(sellQ + 0.5) << ','
-            << unixTime;
-
-        for (int l = 0; l < 5; ++l) os << ',' << floatToString(bidP[l]) << ',' << bidQ[l];
-        for (int l = 0; l < 5; ++l) os << ',' << floatToString(askP[l]) << ',' << askQ[l];
-
-        out.sendLine(os.str());
+        LineBuilder os;
+        os.u64(token).str(",7208,")
+            .fixed(ltpR).ch(',')
+            .fixed(atpR).ch(',')
+            .fixed(bdpR).ch(',')
+            .i64(bdq).ch(',')
+            .fixed(aspR).ch(',')
+            .i64(asq).ch(',')
+            .i64((long long)(buyQ + 0.5)).ch(',')
+            .i64((long long)(sellQ + 0.5)).ch(',')
+            .u64(unixTime);
+
+        for (int l = 0; l < 5; ++l) os.ch(',').fixed(bidP[l]).ch(',').i64(bidQ[l]);
+        for (int l = 0; l < 5; ++l) os.ch(',').fixed(askP[l]).ch(',').i64(askQ[l]);
+
+        RecordMeta meta;
+        meta.token = token;
+        meta.type = 7208;
+        meta.exch_time = unixTime;
+        out.sendLine(os.view(), meta);
     }
 }
 
@@ -140,7 +144,7 @@ void Handler7202::handle(const MessageView& mv, ConsoleSink& out,
     uint16_t n = 0; std::memcpy(&n, d + BASE + 40, 2); n = ntohs(n);
     if (n == 0) return;
 
-    static constexpr int REC_BYTES = 26;
+    static constexpr int REC_BYTES = kRecordBytes;
     const int REC0 = BASE + 42;
 
     for (uint16_t i = 0; i < n; ++i) {
@@ -160,9 +164,14 @@ void Handler7202::handle(const MessageView& mv, ConsoleSink& out,
         mkt = ntohs(mkt);
         oi = ntohl(oi);
 
-        std::ostringstream os;
-        os << token << ",7202," << mkt << "," << oi;
-        out.sendLine(os.str());
+        LineBuilder os;
+        os.u64(token).str(",7202,").u64(mkt).ch(',').u64(oi);
+
+        RecordMeta meta;
+        meta.token = token;
+        meta.type = 7202;
+        meta.market = mkt;
+        out.sendLine(os.view(), meta);
     }
 }
 
@@ -223,20 +232,23 @@ void HandlerCM_CT::handle(const MessageView& mv, ConsoleSink& out,
     }
 
     // Print CSV: token,CT,ltp,atp,bid1, bid1_q, ask1, ask1_q, tot_buy, tot_sell, lttime, volume, open, high, low, close
-    std::ostringstream os;
-    os << token << ",CT,"
-        << floatToString(ltp) << ','
-        << floatToString(atp) << ','
-        << floatToString(bid1) << ',' << bid1_q << ','
-        << floatToString(ask1) << ',' << ask1_q << ','
-        << tot_buy << ',' << tot_sell << ','
-        << lt_time << ',' << vtr << ','
-        << floatToString(open_raw / PRICE_SCALE) << ','
-        << floatToString(high_raw / PRICE_SCALE) << ','
-        << floatToString(low_raw / PRICE_SCALE) << ','
-        << floatToString(close_raw / PRICE_SCALE);
-
-    out.sendLine(os.str());
+    LineBuilder os;
+    os.u64(token).str(",CT,")
+        .fixed(ltp).ch(',')
+        .fixed(atp).ch(',')
+        .fixed(bid1).ch(',').u64(bid1_q).ch(',')
+        .fixed(ask1).ch(',').u64(ask1_q).ch(',')
+        .u64(tot_buy).ch(',').u64(tot_sell).ch(',')
+        .u64(lt_time).ch(',').u64(vtr).ch(',')
+        .fixed(open_raw / PRICE_SCALE).ch(',')
+        .fixed(high_raw / PRICE_SCALE).ch(',')
+        .fixed(low_raw / PRICE_SCALE).ch(',')
+        .fixed(close_raw / PRICE_SCALE);
+
+    RecordMeta meta;
+    meta.token = token;
+    meta.type = ICODE_CT;
+    out.sendLine(os.view(), meta);
 
     // Print schema when debug (once)
     if (ConsoleSink::getConsoleMirror()) {
@@ -286,12 +298,15 @@ void HandlerCM_PN::handle(const MessageView& mv, ConsoleSink& out,
     }
 
     // Form CSV: token,PN,ltp,bid1,bid1_q,...bid5,bid5_q,ask1,ask1_q...ask5,ask5_q
-    std::ostringstream os;
-    os << token << ",PN," << floatToString(ltp);
-    for (int i = 0; i < 5; ++i) os << ',' << floatToString(bidP[i]) << ',' << bidQ[i];
-    for (int i = 0; i < 5; ++i) os << ',' << floatToString(askP[i]) << ',' << askQ[i];
-
-    out.sendLine(os.str());
+    LineBuilder os;
+    os.u64(token).str(",PN,").fixed(ltp);
+    for (int i = 0; i < 5; ++i) os.ch(',').fixed(bidP[i]).ch(',').u64(bidQ[i]);
+    for (int i = 0; i < 5; ++i) os.ch(',').fixed(askP[i]).ch(',').u64(askQ[i]);
+
+    RecordMeta meta;
+    meta.token = token;
+    meta.type = ICODE_PN;
+    out.sendLine(os.view(), meta);
 
     if (ConsoleSink::getConsoleMirror()) {
         std::cerr << "[SCHEMA CM PN] cols: token,PN,ltp, (bid1,qty1)...(bid5,qty5),(ask1,qty1)...(ask5,qty5)\n";
@@ -10,6 +10,14 @@ HermesPortal v1.4.1 (core, 7202 + 7208 + SHM via XMemoryRing v2 + Socket single-
 #include "XMemoryRing.hpp"
 #include "FileWriter.h"
 #include "SocketRelay.h"
+#include "SocketFrames.h"
+#include "McastPublisher.h"
+#include "DecodePool.h"
+#include "AsyncConsole.h"
+#include "Bench.h"
+#include "HistBlocks.h"
+#include "LiveSnapshot.h"
+#include "TickStore.h"
 
 #include <thread>
 #include <chrono>
@@ -25,6 +33,7 @@ HermesPortal v1.4.1 (core, 7202 + 7208 + SHM via XMemoryRing v2 + Socket single-
 #include <csignal>
 #include <fstream>
 #include <cstring>
+#include <cerrno>
 
 #ifdef _WIN32
 #define WIN32_LEAN_AND_MEAN
@@ -49,18 +58,6 @@ static std::set<int> parseEnabled(const std::string& s) {
     return out;
 }
 
-// Lightweight CSV splitter used for extracting token & type from emitted CSV lines.
-static inline void split_csv_fields_simple(const std::string& line, std::vector<std::string>& out) {
-    out.clear();
-    size_t i = 0;
-    while (true) {
-        size_t j = line.find(',', i);
-        if (j == std::string::npos) { out.emplace_back(line.substr(i)); break; }
-        out.emplace_back(line.substr(i, j - i));
-        i = j + 1;
-    }
-}
-
 // ---------------- graceful shutdown ----------------
 static std::atomic<bool> g_running{ true };
 
@@ -98,9 +95,24 @@ static void print_usage_and_exit(const char* prog) {
     std::cerr
         << "Usage: " << (prog ? prog : "HermesPortal") << " <tokens_csv>\n"
         << "  [--enable 7202,7208] [--market all]\n"
-        << "  [--out console|shm|file|socket] [--ring-name <name>] [--token <auth>] [--ring-cap <bytes>]\n"
-        << "  [--socket-port <port>] [--socket-token <token>] [--socket-maxq <n>] [--socket-batch-bytes <bytes>]\n"
-        << "  [--file-base <path>] [--debug] [--debug-schema]\n"
+        << "  [--out console|shm|file|socket|mcast[,...]] [--ring-name <name>] [--token <auth>] [--ring-cap <bytes>]\n"
+        << "  [--shm-policy|--socket-policy drop-newest|drop-oldest] [--file-policy drop-newest|drop-oldest|block]\n"
+        << "  [--socket-port <port>] [--socket-token <token>] [--socket-maxq <n>] [--socket-batch-bytes <bytes>] [--socket-ring-bytes <bytes>]\n"
+        << "  [--socket-max-clients <n>] [--socket-stats <ms>] [--socket-sndbuf <bytes>] [--socket-nodelay 0|1]\n"
+        << "  [--socket-zerocopy <bytes>] [--socket-evict-bytes <bytes>] [--socket-evict-ms <ms>]\n"
+        << "  [--socket-snapshot-slots <n>] [--socket-snapshot-bytes <bytes>] [--socket-retain-bytes <bytes>]\n"
+        << "  [--socket-lzo-bytes <bytes>] [--socket-lzo-linger <ms>]\n"
+        << "  [--mcast-out <group|ip>:<port>] [--mcast-out-iface <ip>] [--mcast-out-ttl <n>] [--mcast-out-format csv|binary]\n"
+        << "  [--mcast-out-mtu <bytes>] [--mcast-out-flush-us <us>] [--mcast-out-rate <Mbit/s>] [--mcast-out-queue <bytes>]\n"
+        << "  [--socket-unix <path>] [--socket-seqpacket] [--socket-allow-uid <uid|self>]\n"
+        << "  [--file-base <path>] [--file-max-fds <n>] [--file-shards <n>] [--file-io blocking|uring]\n"
+        << "  [--file-live snap|text|both] [--live-slots <n>] [--live-slot-bytes <n>] [--file-batch <n>] [--file-flush-us <us>]\n"
+        << "  [--file-format text|lzo|columnar] [--file-block-bytes <bytes>] [--file-block-ms <ms>] [--file-queue-bytes <bytes>]\n"
+        << "  [--file-durability none|periodic|batch|dsync] [--file-sync-ms <ms>]\n"
+        << "  [--file-rotate-daily] [--file-rotate-bytes <bytes>] [--file-prealloc <bytes>] [--file-dontneed]\n"
+        << "  [--tick-rows <n>] [--tick-secs <s>]\n"
+        << "  [--debug] [--debug-schema] [--console-buf <bytes>]\n"
+        << "  [--decode-workers <n>] [--decode-queue-bytes <bytes>] [--decode-stats <ms>]\n"
         << "\nAdditional multicast flags:\n"
         << "  --inst <cm|fo>          Choose instrument type (cm -> port 34074, fo -> port 34330). Default = fo\n"
         << "  --mcast-ip <ip>         Override multicast IP (default 233.1.2.5)\n"
@@ -108,6 +120,24 @@ static void print_usage_and_exit(const char* prog) {
         << "  --dump-pkt <path>       Dump first received UDP packet to <path> and exit\n"
         << "  --dump-hex              Print hex preview of first received UDP packet and exit\n"
         << "  -h, --help              Show this help\n"
+        << "\nBenchmarks (no feed):\n"
+        << "  " << (prog ? prog : "HermesPortal") << " --bench-file <dir> [--bench-lines <n>] [--bench-tokens <n>] [--file-shards <n>] [--file-format text|lzo|columnar]\n"
+        << "      [--file-durability none|periodic|batch|dsync|all] [--file-sync-ms <ms>]\n"
+        << "  " << (prog ? prog : "HermesPortal") << " --bench-socket [--bench-lines <n>] [--bench-clients <n>] [--bench-rate <lines/s>] [--bench-unix-path <path>]\n"
+        << "\nHistorical block files (--file-format lzo):\n"
+        << "  " << (prog ? prog : "HermesPortal") << " --hist-dump <token.hlz> [--from <time>] [--to <time>] [--index]\n"
+        << "      <time> is unix seconds or local \"YYYY-MM-DD HH:MM:SS\"\n"
+        << "\nColumnar tick store (--file-format columnar):\n"
+        << "  " << (prog ? prog : "HermesPortal") << " --tick-query <base> --day <YYYYMMDD> --type <7208|7202|CT|PN> [--token <n>]\n"
+        << "      [--from <time>] [--to <time>] [--csv]    <time> is unix seconds or HH:MM:SS on that day\n"
+        << "\nSocket client (reference decoder for FORMAT lzo):\n"
+        << "  " << (prog ? prog : "HermesPortal") << " --socket-read <host:port|unix:path> [--socket-token <token>] [--lzo] [--cmd \"<line>\"]... [--secs <n>] [--quiet]\n"
+        << "\nShared-memory ring reader (--out shm):\n"
+        << "  " << (prog ? prog : "HermesPortal") << " --shm-read <ring-name> --token <auth> [--secs <n>] [--quiet]\n"
+        << "\nLive snapshot reader (--file-live snap|both):\n"
+        << "  " << (prog ? prog : "HermesPortal") << " --live-read <live/market.snap> [--token <n>] [--secs <n>] [--poll-ms <ms>]\n"
+        << "\nMulticast receiver (--out mcast):\n"
+        << "  " << (prog ? prog : "HermesPortal") << " --mcast-read <group|ip>:<port> [--iface <ip>] [--secs <n>] [--quiet]\n"
         ;
     std::exit(1);
 }
@@ -135,6 +165,69 @@ int main(int argc, char* argv[]) {
         print_usage_and_exit(argc ? argv[0] : nullptr);
     }
 
+    // offline benchmarks (no feed, no sinks)
+    if (std::strncmp(argv[1], "--bench", 7) == 0) {
+        int rc = RunBench(argc, argv);
+#ifdef _WIN32
+        WSACleanup();
+#endif
+        return rc;
+    }
+
+    // historical block file decoder
+    if (std::strcmp(argv[1], "--hist-dump") == 0) {
+        int rc = RunHistDump(argc, argv);
+#ifdef _WIN32
+        WSACleanup();
+#endif
+        return rc;
+    }
+
+    // reference socket client (text or LZO frames)
+    if (std::strcmp(argv[1], "--socket-read") == 0) {
+        int rc = RunSocketRead(argc, argv);
+#ifdef _WIN32
+        WSACleanup();
+#endif
+        return rc;
+    }
+
+    // reference shm ring reader (another process attached to --out shm)
+    if (std::strcmp(argv[1], "--shm-read") == 0) {
+        int rc = RunShmRead(argc, argv);
+#ifdef _WIN32
+        WSACleanup();
+#endif
+        return rc;
+    }
+
+    // live snapshot dump / watch (another process reading live/<market>.snap)
+    if (std::strcmp(argv[1], "--live-read") == 0) {
+        int rc = RunLiveRead(argc, argv);
+#ifdef _WIN32
+        WSACleanup();
+#endif
+        return rc;
+    }
+
+    // reference multicast receiver (--out mcast datagrams)
+    if (std::strcmp(argv[1], "--mcast-read") == 0) {
+        int rc = RunMcastRead(argc, argv);
+#ifdef _WIN32
+        WSACleanup();
+#endif
+        return rc;
+    }
+
+    // columnar tick store query
+    if (std::strcmp(argv[1], "--tick-query") == 0) {
+        int rc = RunTickQuery(argc, argv);
+#ifdef _WIN32
+        WSACleanup();
+#endif
+        return rc;
+    }
+
     // CLI parse
     std::string tokensCsv = argv[1];
     std::set<int> enabledCodes;
@@ -146,12 +239,61 @@ int main(int argc, char* argv[]) {
     std::string ringName, ringToken; // ring naming for shm (existing flags)
     uint64_t ringCap = (4ull << 20);
     std::string fileBase;
+    size_t fileMaxFds = 512;
+    size_t fileShards = 1;
+    size_t fileBatch = 4096;
+    size_t fileQueueBytes = 4u << 20;
+    bool fileRotateDaily = false;
+    uint64_t fileRotateBytes = 0;
+    uint64_t filePrealloc = 0;
+    bool fileDontNeed = false;
+    unsigned fileFlushUs = 0;
+    FileWriter::IoBackend fileIo = FileWriter::IoBackend::Blocking;
+    FileWriter::Durability fileDurability = FileWriter::Durability::None;
+    unsigned fileSyncMs = 1000;
+    FileWriter::LiveMode fileLive = FileWriter::LiveMode::Snapshot;
+    FileWriter::HistFormat fileFormat = FileWriter::HistFormat::Text;
+    size_t fileBlockBytes = 64 * 1024;
+    unsigned fileBlockMs = 1000;
+    size_t tickRows = 0;                            // 0 => FileWriter defaults
+    unsigned tickSecs = 0;
+    uint32_t liveSlots = 0, liveSlotBytes = 0;     // 0 => FileWriter defaults
 
     // socket options
     uint16_t socket_port = 0;
     std::string socket_auth_token;
     size_t socket_maxq = 4096;
     size_t socket_batch_bytes = 16 * 1024;
+    size_t socket_ring_bytes = 4 << 20;
+    size_t socket_max_clients = 16;
+    int socket_sndbuf = 0;
+    bool socket_nodelay = true;
+    size_t socket_zerocopy = 0;
+    size_t socket_evict_bytes = 0;
+    unsigned socket_evict_ms = 0;
+    size_t socket_snapshot_slots = 16384;
+    std::string socket_unix_path;
+    bool socket_seqpacket = false;
+    long socket_allow_uid = -1;
+    size_t socket_snapshot_bytes = 512;
+    size_t socket_retain_bytes = 0;
+    size_t socket_lzo_bytes = 64 * 1024;
+    unsigned socket_lzo_linger_ms = 10;
+    unsigned socket_stats_ms = 0;
+    McastPublisher::Config mcastOut;
+    double mcast_out_mbit = 0;
+
+    // per-sink back-pressure (block is honoured by file only)
+    BackPressure shmPolicy = BackPressure::DropOldest;
+    BackPressure filePolicy = BackPressure::DropOldest;
+    BackPressure socketPolicy = BackPressure::DropOldest;
+
+    // console sink buffer (drained to stdout by its own thread)
+    AsyncConsole::Config consoleCfg;
+
+    // decode workers (0/1 => decode inline on the receive thread)
+    DecodePool::Config decodeCfg;
+    decodeCfg.workers = 0;
 
     // selected feed (default FO)
     FeedType selectedFeed = FeedType::FO;
@@ -180,6 +322,67 @@ int main(int argc, char* argv[]) {
             if (val.empty() && i + 1 < argc) val = argv[++i];
             outMode = val;
         }
+        else if (key == "--mcast-out") {
+            if (val.empty() && i + 1 < argc) val = argv[++i];
+            const size_t colon = val.rfind(':');
+            if (colon != std::string::npos) {
+                mcastOut.group = val.substr(0, colon);
+                try { mcastOut.port = static_cast<uint16_t>(std::stoi(val.substr(colon + 1))); }
+                catch (...) {}
+            }
+        }
+        else if (key == "--mcast-out-iface") {
+            if (val.empty() && i + 1 < argc) val = argv[++i];
+            mcastOut.iface = val;
+        }
+        else if (key == "--mcast-out-ttl") {
+            if (val.empty() && i + 1 < argc) val = argv[++i];
+            try { mcastOut.ttl = std::stoi(val); }
+            catch (...) {}
+        }
+        else if (key == "--mcast-out-format") {
+            if (val.empty() && i + 1 < argc) val = argv[++i];
+            mcastOut.format = (to_lowercopy(val) == "binary") ? McastPublisher::Format::Binary : McastPublisher::Format::Csv;
+        }
+        else if (key == "--mcast-out-mtu") {
+            if (val.empty() && i + 1 < argc) val = argv[++i];
+            try { mcastOut.datagram_bytes = static_cast<size_t>(std::stoull(val)); }
+            catch (...) {}
+        }
+        else if (key == "--mcast-out-flush-us") {
+            if (val.empty() && i + 1 < argc) val = argv[++i];
+            try { mcastOut.flush_us = static_cast<unsigned>(std::stoul(val)); }
+            catch (...) {}
+        }
+        else if (key == "--mcast-out-rate") {
+            if (val.empty() && i + 1 < argc) val = argv[++i];
+            try { mcast_out_mbit = std::stod(val); }
+            catch (...) {}
+        }
+        else if (key == "--mcast-out-queue") {
+            if (val.empty() && i + 1 < argc) val = argv[++i];
+            try { mcastOut.queue_bytes = static_cast<size_t>(std::stoull(val)); }
+            catch (...) {}
+        }
+        else if (key == "--shm-policy" || key == "--file-policy" || key == "--socket-policy") {
+            if (val.empty() && i + 1 < argc) val = argv[++i];
+            BackPressure& target = (key == "--shm-policy") ? shmPolicy : (key == "--file-policy") ? filePolicy : socketPolicy;
+            if (!ConsoleSink::parsePolicy(to_lowercopy(val), target)) {
+                std::cerr << "[FATAL] Invalid value for " << key << ": " << val << "\n";
+#ifdef _WIN32
+                WSACleanup();
+#endif
+                return 1;
+            }
+            // only the file writer can hold a producer back; shm and socket drop instead
+            if (target == BackPressure::Block && key != "--file-policy") {
+                std::cerr << "[FATAL] " << key << " does not support block (use drop-newest or drop-oldest)\n";
+#ifdef _WIN32
+                WSACleanup();
+#endif
+                return 1;
+            }
+        }
         else if (key == "--ring-name") {
             if (val.empty() && i + 1 < argc) val = argv[++i];
             ringName = val;
@@ -197,6 +400,134 @@ int main(int argc, char* argv[]) {
             if (val.empty() && i + 1 < argc) val = argv[++i];
             fileBase = val;
         }
+        else if (key == "--file-live") {
+            if (val.empty() && i + 1 < argc) val = argv[++i];
+            std::string m = to_lowercopy(val);
+            if (m == "snap" || m == "snapshot") fileLive = FileWriter::LiveMode::Snapshot;
+            else if (m == "text") fileLive = FileWriter::LiveMode::Text;
+            else if (m == "both") fileLive = FileWriter::LiveMode::Both;
+            else {
+                std::cerr << "[FATAL] Invalid value for " << key << ": " << val << " (snap|text|both)\n";
+#ifdef _WIN32
+                WSACleanup();
+#endif
+                return 1;
+            }
+        }
+        else if (key == "--live-slots" || key == "--live-slot-bytes") {
+            if (val.empty() && i + 1 < argc) val = argv[++i];
+            uint32_t& target = (key == "--live-slots") ? liveSlots : liveSlotBytes;
+            try { target = static_cast<uint32_t>(std::stoul(val)); }
+            catch (...) {}
+        }
+        else if (key == "--file-io") {
+            if (val.empty() && i + 1 < argc) val = argv[++i];
+            std::string m = to_lowercopy(val);
+            if (m == "blocking") fileIo = FileWriter::IoBackend::Blocking;
+            else if (m == "uring" || m == "io_uring") fileIo = FileWriter::IoBackend::IoUring;
+            else {
+                std::cerr << "[FATAL] Invalid value for " << key << ": " << val << " (blocking|uring)\n";
+#ifdef _WIN32
+                WSACleanup();
+#endif
+                return 1;
+            }
+        }
+        else if (key == "--file-durability") {
+            if (val.empty() && i + 1 < argc) val = argv[++i];
+            std::string m = to_lowercopy(val);
+            if (m == "none") fileDurability = FileWriter::Durability::None;
+            else if (m == "periodic") fileDurability = FileWriter::Durability::Periodic;
+            else if (m == "batch") fileDurability = FileWriter::Durability::Batch;
+            else if (m == "dsync") fileDurability = FileWriter::Durability::DSync;
+            else {
+                std::cerr << "[FATAL] Invalid value for " << key << ": " << val << " (none|periodic|batch|dsync)\n";
+#ifdef _WIN32
+                WSACleanup();
+#endif
+                return 1;
+            }
+        }
+        else if (key == "--file-sync-ms") {
+            if (val.empty() && i + 1 < argc) val = argv[++i];
+            try { fileSyncMs = static_cast<unsigned>(std::stoul(val)); }
+            catch (...) {}
+        }
+        else if (key == "--file-format") {
+            if (val.empty() && i + 1 < argc) val = argv[++i];
+            std::string m = to_lowercopy(val);
+            if (m == "text" || m == "csv") fileFormat = FileWriter::HistFormat::Text;
+            else if (m == "lzo") fileFormat = FileWriter::HistFormat::LzoBlocks;
+            else if (m == "columnar") fileFormat = FileWriter::HistFormat::Columnar;
+            else {
+                std::cerr << "[FATAL] Invalid value for " << key << ": " << val << " (text|lzo|columnar)\n";
+#ifdef _WIN32
+                WSACleanup();
+#endif
+                return 1;
+            }
+        }
+        else if (key == "--file-block-bytes") {
+            if (val.empty() && i + 1 < argc) val = argv[++i];
+            try { fileBlockBytes = static_cast<size_t>(std::stoull(val)); }
+            catch (...) {}
+        }
+        else if (key == "--tick-rows") {
+            if (val.empty() && i + 1 < argc) val = argv[++i];
+            try { tickRows = static_cast<size_t>(std::stoull(val)); }
+            catch (...) {}
+        }
+        else if (key == "--tick-secs") {
+            if (val.empty() && i + 1 < argc) val = argv[++i];
+            try { tickSecs = static_cast<unsigned>(std::stoul(val)); }
+            catch (...) {}
+        }
+        else if (key == "--file-block-ms") {
+            if (val.empty() && i + 1 < argc) val = argv[++i];
+            try { fileBlockMs = static_cast<unsigned>(std::stoul(val)); }
+            catch (...) {}
+        }
+        else if (key == "--file-batch") {
+            if (val.empty() && i + 1 < argc) val = argv[++i];
+            try { fileBatch = static_cast<size_t>(std::stoull(val)); }
+            catch (...) {}
+        }
+        else if (key == "--file-rotate-daily") {
+            fileRotateDaily = true;
+        }
+        else if (key == "--file-rotate-bytes") {
+            if (val.empty() && i + 1 < argc) val = argv[++i];
+            try { fileRotateBytes = static_cast<uint64_t>(std::stoull(val)); }
+            catch (...) {}
+        }
+        else if (key == "--file-prealloc") {
+            if (val.empty() && i + 1 < argc) val = argv[++i];
+            try { filePrealloc = static_cast<uint64_t>(std::stoull(val)); }
+            catch (...) {}
+        }
+        else if (key == "--file-dontneed") {
+            fileDontNeed = true;
+        }
+        else if (key == "--file-queue-bytes") {
+            if (val.empty() && i + 1 < argc) val = argv[++i];
+            try { fileQueueBytes = static_cast<size_t>(std::stoull(val)); }
+            catch (...) {}
+        }
+        else if (key == "--file-flush-us") {
+            if (val.empty() && i + 1 < argc) val = argv[++i];
+            try { fileFlushUs = static_cast<unsigned>(std::stoul(val)); }
+            catch (...) {}
+        }
+        else if (key == "--file-shards") {
+            if (val.empty() && i + 1 < argc) val = argv[++i];
+            try { fileShards = static_cast<size_t>(std::stoul(val)); }
+            catch (...) {}
+        }
+        else if (key == "--file-max-fds") {
+            if (val.empty() && i + 1 < argc) val = argv[++i];
+            try { fileMaxFds = static_cast<size_t>(std::stoull(val)); }
+            catch (...) {}
+        }
         else if (key == "--socket-port") {
             if (val.empty() && i + 1 < argc) val = argv[++i];
             try { socket_port = static_cast<uint16_t>(std::stoi(val)); }
@@ -216,9 +547,109 @@ int main(int argc, char* argv[]) {
             try { socket_batch_bytes = static_cast<size_t>(std::stoul(val)); }
             catch (...) {}
         }
+        else if (key == "--socket-ring-bytes") {
+            if (val.empty() && i + 1 < argc) val = argv[++i];
+            try { socket_ring_bytes = static_cast<size_t>(std::stoull(val)); }
+            catch (...) {}
+        }
+        else if (key == "--socket-sndbuf") {
+            if (val.empty() && i + 1 < argc) val = argv[++i];
+            try { socket_sndbuf = std::stoi(val); }
+            catch (...) {}
+        }
+        else if (key == "--socket-nodelay") {
+            if (val.empty() && i + 1 < argc) val = argv[++i];
+            socket_nodelay = (val != "0" && val != "off");
+        }
+        else if (key == "--socket-zerocopy") {
+            if (val.empty() && i + 1 < argc) val = argv[++i];
+            try { socket_zerocopy = static_cast<size_t>(std::stoull(val)); }
+            catch (...) {}
+        }
+        else if (key == "--socket-evict-bytes") {
+            if (val.empty() && i + 1 < argc) val = argv[++i];
+            try { socket_evict_bytes = static_cast<size_t>(std::stoull(val)); }
+            catch (...) {}
+        }
+        else if (key == "--socket-evict-ms") {
+            if (val.empty() && i + 1 < argc) val = argv[++i];
+            try { socket_evict_ms = static_cast<unsigned>(std::stoul(val)); }
+            catch (...) {}
+        }
+        else if (key == "--socket-snapshot-slots") {
+            if (val.empty() && i + 1 < argc) val = argv[++i];
+            try { socket_snapshot_slots = static_cast<size_t>(std::stoull(val)); }
+            catch (...) {}
+        }
+        else if (key == "--socket-snapshot-bytes") {
+            if (val.empty() && i + 1 < argc) val = argv[++i];
+            try { socket_snapshot_bytes = static_cast<size_t>(std::stoull(val)); }
+            catch (...) {}
+        }
+        else if (key == "--socket-retain-bytes") {
+            if (val.empty() && i + 1 < argc) val = argv[++i];
+            try { socket_retain_bytes = static_cast<size_t>(std::stoull(val)); }
+            catch (...) {}
+        }
+        else if (key == "--socket-lzo-bytes") {
+            if (val.empty() && i + 1 < argc) val = argv[++i];
+            try { socket_lzo_bytes = static_cast<size_t>(std::stoull(val)); }
+            catch (...) {}
+        }
+        else if (key == "--socket-lzo-linger") {
+            if (val.empty() && i + 1 < argc) val = argv[++i];
+            try { socket_lzo_linger_ms = static_cast<unsigned>(std::stoul(val)); }
+            catch (...) {}
+        }
+        else if (key == "--socket-unix") {
+            if (val.empty() && i + 1 < argc) val = argv[++i];
+            socket_unix_path = val;
+        }
+        else if (key == "--socket-seqpacket") {
+            socket_seqpacket = true;
+        }
+        else if (key == "--socket-allow-uid") {
+            if (val.empty() && i + 1 < argc) val = argv[++i];
+#ifndef _WIN32
+            if (val == "self") socket_allow_uid = static_cast<long>(geteuid());
+            else
+#endif
+            try { socket_allow_uid = std::stol(val); }
+            catch (...) {}
+        }
+        else if (key == "--socket-max-clients") {
+            if (val.empty() && i + 1 < argc) val = argv[++i];
+            try { socket_max_clients = static_cast<size_t>(std::stoul(val)); }
+            catch (...) {}
+        }
+        else if (key == "--socket-stats") {
+            if (val.empty() && i + 1 < argc) val = argv[++i];
+            try { socket_stats_ms = static_cast<unsigned>(std::stoul(val)); }
+            catch (...) {}
+        }
+        else if (key == "--decode-workers") {
+            if (val.empty() && i + 1 < argc) val = argv[++i];
+            try { decodeCfg.workers = static_cast<size_t>(std::stoul(val)); }
+            catch (...) {}
+        }
+        else if (key == "--decode-queue-bytes") {
+            if (val.empty() && i + 1 < argc) val = argv[++i];
+            try { decodeCfg.queue_bytes = static_cast<size_t>(std::stoull(val)); }
+            catch (...) {}
+        }
+        else if (key == "--decode-stats") {
+            if (val.empty() && i + 1 < argc) val = argv[++i];
+            try { decodeCfg.stats_interval_ms = static_cast<unsigned>(std::stoul(val)); }
+            catch (...) {}
+        }
         else if (key == "--debug") {
             debugMirror = true;
         }
+        else if (key == "--console-buf") {
+            if (val.empty() && i + 1 < argc) val = argv[++i];
+            try { consoleCfg.buffer_bytes = static_cast<size_t>(std::stoull(val)); }
+            catch (...) {}
+        }
         else if (key == "--debug-schema") {
             debugSchema = true;
         }
@@ -305,28 +736,39 @@ int main(int argc, char* argv[]) {
         return 1;
     }
 
-    // Console sink
+    // Sinks: --out takes a comma list (e.g. shm,file,socket); --debug adds a console mirror
+    std::set<std::string> outKinds;
+    {
+        std::stringstream ss(outMode);
+        std::string item;
+        while (std::getline(ss, item, ',')) {
+            item = to_lowercopy(item);
+            if (!item.empty()) outKinds.insert(item);
+        }
+        if (outKinds.empty()) outKinds.insert("console");
+    }
     ConsoleSink sink;
-    ConsoleSink::setConsoleMirror(debugMirror);
 
-#ifdef _WIN32
     xmr::Writer shmWriter;
-#endif
     static FileWriter g_file_writer;
     bool file_writer_enabled = false;
 
-    // SocketRelay pointer (only used if outMode == "socket")
+    // SocketRelay pointer (only used if socket output is selected)
     std::unique_ptr<SocketRelay> socketRelay;
 
     // Setup outputs
-    if (outMode == "shm") {
-#ifdef _WIN32
+    if (outKinds.count("shm")) {
         try {
             xmr::Config cfg;
+#ifdef _WIN32
             cfg.nameW = std::wstring(ringName.begin(), ringName.end());
             cfg.tokenW = std::wstring(ringToken.begin(), ringToken.end());
+#else
+            cfg.name = ringName;        // shm_open("/<name>.<token>")
+            cfg.token = ringToken;
+#endif
             cfg.capacity_bytes = ringCap ? ringCap : (4ull << 20);
-            cfg.drop_policy = xmr::DropPolicy::DropOldest;
+            cfg.drop_policy = (shmPolicy == BackPressure::DropNewest) ? xmr::DropPolicy::DropNewest : xmr::DropPolicy::DropOldest;
             cfg.frame_mode = xmr::FrameMode::Newline;
             cfg.heartbeat_interval = std::chrono::nanoseconds(500'000'000);
 
@@ -337,12 +779,10 @@ int main(int argc, char* argv[]) {
             }
 
             shmWriter.open(cfg);
-            ConsoleSink::setExternal([&](const std::string& line) -> bool {
-                return shmWriter.write(line);
-                });
+            ConsoleSink::addShm(shmWriter);
 
-            std::cout << "[INFO] Writing to SHM ring '" << ringName << "'"
-                << " (cap " << cfg.capacity_bytes << " bytes, drop=DropOldest)\n";
+            std::cout << "[INFO] Writing to SHM ring '" << shmWriter.mapping_name() << "'"
+                << " (cap " << cfg.capacity_bytes << " bytes, drop=" << ConsoleSink::policyName(shmPolicy) << ")\n";
         }
         catch (const std::exception& e) {
             std::cerr << "[FATAL] SHM open failed: " << e.what() << "\n";
@@ -351,39 +791,40 @@ int main(int argc, char* argv[]) {
 #endif
             return 1;
         }
-#else
-        std::cerr << "[WARN] --out shm requested but SHM is only implemented on Windows\n";
-#endif
     }
-    else if (outMode == "file") {
+    if (outKinds.count("file")) {
         try {
+            g_file_writer.set_overflow_policy(
+                filePolicy == BackPressure::DropNewest ? FileWriter::Overflow::DropNewest :
+                filePolicy == BackPressure::Block ? FileWriter::Overflow::Block : FileWriter::Overflow::DropOldest);
+            g_file_writer.set_max_open_files(fileMaxFds);
+            g_file_writer.set_shards(fileShards);
+            g_file_writer.set_io_backend(fileIo);
+            g_file_writer.set_batching(fileBatch, fileFlushUs);
+            g_file_writer.set_queue_bytes(fileQueueBytes);
+            g_file_writer.set_durability(fileDurability, fileSyncMs);
+            g_file_writer.set_hist_rotation(fileRotateDaily, fileRotateBytes);
+            g_file_writer.set_hist_prealloc(filePrealloc, fileDontNeed);
+            g_file_writer.set_hist_format(fileFormat, fileBlockBytes, fileBlockMs);
+            g_file_writer.set_tick_segments(tickRows, tickSecs);
+            g_file_writer.set_live_mode(fileLive);
+            g_file_writer.set_live_slots(liveSlots, liveSlotBytes);
             g_file_writer.start(fileBase);
             file_writer_enabled = true;
-            ConsoleSink::setExternal([&](const std::string& line) -> bool {
-                std::vector<std::string> f;
-                split_csv_fields_simple(line, f);
-                uint32_t token = 0; uint16_t type = 0;
-                try { token = static_cast<uint32_t>(std::stoul(f.size() ? f[0] : "0")); }
-                catch (...) {}
-                try { type = static_cast<uint16_t>(std::stoi(f.size() > 1 ? f[1] : "0")); }
-                catch (...) {}
-                std::string market;
-                if (type == 7202 && f.size() > 2) market = f[2];
-                g_file_writer.enqueue(type, token, line, market);
-                if (debugMirror) std::cout << line << '\n';
-                return true;
-                });
-            std::cout << "[INFO] Writing to files under base=" << (fileBase.empty() ? "<exe-dir>/data" : fileBase) << "\n";
+            ConsoleSink::addFile(g_file_writer);
+            std::cout << "[INFO] Writing to files under base=" << (fileBase.empty() ? "<exe-dir>/data" : fileBase)
+                << " (" << g_file_writer.shards() << " writer shard" << (g_file_writer.shards() > 1 ? "s" : "")
+                << ", full queue=" << ConsoleSink::policyName(filePolicy) << ")\n";
         }
         catch (const std::exception& e) {
             std::cerr << "[FATAL] FileWriter start failed: " << e.what() << "\n";
             return 1;
         }
     }
-    else if (outMode == "socket") {
+    if (outKinds.count("socket")) {
         // socket mode selected
-        if (socket_auth_token.empty()) {
-            std::cerr << "[FATAL] --socket-token is mandatory when using --out socket\n";
+        if (socket_auth_token.empty() && (socket_unix_path.empty() || socket_allow_uid < 0)) {
+            std::cerr << "[FATAL] --socket-token is mandatory when using --out socket (or --socket-unix with --socket-allow-uid)\n";
 #ifdef _WIN32
             WSACleanup();
 #endif
@@ -396,8 +837,28 @@ int main(int argc, char* argv[]) {
         cfg.port = socket_port;
         cfg.auth_token = socket_auth_token;
         cfg.max_queue = socket_maxq;
+        // a lagging client cannot drop the newest line alone (the ring is shared): drop-newest
+        // skips its backlog instead
+        cfg.overflow = (socketPolicy == BackPressure::DropNewest) ? SocketRelay::Overflow::SkipToLatest : SocketRelay::Overflow::DropOldest;
         cfg.batch_bytes = socket_batch_bytes;
-        cfg.replace_client = true;
+        cfg.ring_bytes = socket_ring_bytes;
+        cfg.sndbuf = socket_sndbuf;
+        cfg.nodelay = socket_nodelay;
+        cfg.zerocopy_bytes = socket_zerocopy;
+        cfg.evict_queue_bytes = socket_evict_bytes;
+        cfg.evict_lag_ms = socket_evict_ms;
+        cfg.snapshot_slots = socket_snapshot_slots;
+        if (!socket_unix_path.empty()) {
+            cfg.transport = socket_seqpacket ? SocketRelay::Transport::UnixSeqpacket : SocketRelay::Transport::UnixStream;
+            cfg.unix_path = socket_unix_path;
+            cfg.allow_uid = socket_allow_uid;
+        }
+        cfg.snapshot_slot_bytes = socket_snapshot_bytes;
+        cfg.retain_bytes = socket_retain_bytes;
+        cfg.frame_bytes = socket_lzo_bytes;
+        cfg.frame_linger_ms = socket_lzo_linger_ms;
+        cfg.max_clients = socket_max_clients;
+        cfg.stats_interval_ms = socket_stats_ms;
         cfg.verbose = debugMirror;
 
         socketRelay.reset(new SocketRelay(cfg));
@@ -412,39 +873,55 @@ int main(int argc, char* argv[]) {
             return 1;
         }
         uint16_t p = socketRelay->listening_port();
-        std::cout << "[SOCKET] listening 127.0.0.1:" << p << " (token=" << (socket_auth_token.size() ? socket_auth_token.substr(0, 4) + "..." : "<none>") << ")\n";
-
-        // Set external sink to forward to file/shm as well as socket relay:
-        ConsoleSink::setExternal([&](const std::string& line) -> bool {
-            // forward to file writer if enabled
-            if (file_writer_enabled) {
-                std::vector<std::string> f;
-                split_csv_fields_simple(line, f);
-                uint32_t token = 0; uint16_t type = 0;
-                try { token = static_cast<uint32_t>(std::stoul(f.size() ? f[0] : "0")); }
-                catch (...) {}
-                try { type = static_cast<uint16_t>(std::stoi(f.size() > 1 ? f[1] : "0")); }
-                catch (...) {}
-                std::string market;
-                if (type == 7202 && f.size() > 2) market = f[2];
-                g_file_writer.enqueue(type, token, line, market);
-            }
+        if (!socket_unix_path.empty()) std::cout << "[SOCKET] listening unix:" << socket_unix_path << (socket_seqpacket ? " (seqpacket)" : "");
+        else std::cout << "[SOCKET] listening 127.0.0.1:" << p;
+        std::cout << " (token=" << (socket_auth_token.size() ? socket_auth_token.substr(0, 4) + "..." : "<none>") << ")\n";
+        ConsoleSink::addSocket(*socketRelay);
+        std::cout << "[INFO] Socket output enabled (lagging client: "
+            << (cfg.overflow == SocketRelay::Overflow::SkipToLatest ? "skip-to-latest" : "drop-oldest") << ")\n";
+    }
+    // multicast re-publisher: one decode, any number of subscribers on the group
+    std::unique_ptr<McastPublisher> mcastPub;
+    if (outKinds.count("mcast")) {
+        if (mcastOut.port == 0) {
+            std::cerr << "[FATAL] --out mcast needs --mcast-out <group|ip>:<port>\n";
 #ifdef _WIN32
-            // forward to shm if opened
-            if (shmWriter.is_open()) shmWriter.write(line);
+            WSACleanup();
 #endif
-            // notify socket relay (non-blocking; will drop if no client)
-            if (socketRelay) socketRelay->notify(line);
-            if (debugMirror) std::cout << line << "\n";
-            return true;
-            });
-
-        std::cout << "[INFO] Socket output enabled\n";
+            return 1;
+        }
+        mcastOut.rate_bytes = static_cast<uint64_t>(mcast_out_mbit * 1e6 / 8);
+        mcastOut.verbose = debugMirror;
+        mcastPub.reset(new McastPublisher(mcastOut));
+        try {
+            mcastPub->start();
+        }
+        catch (const std::exception& e) {
+            std::cerr << "[FATAL] McastPublisher start failed: " << e.what() << "\n";
+#ifdef _WIN32
+            WSACleanup();
+#endif
+            return 1;
+        }
+        ConsoleSink::addMcast(*mcastPub);
+        std::cout << "[MCAST] publishing " << (mcastOut.format == McastPublisher::Format::Binary ? "binary" : "csv")
+            << " to " << mcastOut.group << ":" << mcastOut.port << " (datagram " << mcastOut.datagram_bytes << " bytes, full queue=drop-newest";
+        if (mcastOut.rate_bytes) std::cout << ", cap " << mcast_out_mbit << " Mbit/s";
+        std::cout << ")\n";
     }
-    else {
-        std::cout << "[INFO] Output: console (core sink)\n";
+
+    // console prints only when mirroring (--debug), as before; lines go through a
+    // lock-free buffer so a slow terminal/pipe never stalls decoding
+    static AsyncConsole g_console;
+    if (debugMirror) {
+        g_console.start(consoleCfg);
+        ConsoleSink::addConsole(g_console);
     }
 
+    std::cout << "[INFO] Output sinks: ";
+    ConsoleSink::printSinks(std::cout);
+    std::cout << "\n";
+
     // Dispatcher & handlers
     PacketDispatcher dispatcher;
     auto want = [&](int code) {
@@ -466,17 +943,31 @@ int main(int argc, char* argv[]) {
     PacketParser parser(dispatcher);
     InstrumentDirectory instDir;
 
+    // Token-sharded decode workers: receive thread keeps LZO, handlers run on the pool
+    std::unique_ptr<DecodePool> decodePool;
+    if (decodeCfg.workers > 1) {
+        decodePool.reset(new DecodePool(decodeCfg, &instDir, strikes));
+        decodePool->start();
+        parser.setDecodePool(decodePool.get());
+        std::cout << "[INFO] Decode workers: " << decodeCfg.workers
+            << " (queue " << decodeCfg.queue_bytes << " bytes/worker)\n";
+    }
+
     // Multicast - now configurable via CLI flags above
 #ifdef _WIN32
     SOCKET sockfd = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
     if (sockfd == INVALID_SOCKET) { std::cerr << "[FATAL] socket\n"; WSACleanup(); return 1; }
     BOOL reuse = TRUE;
     setsockopt(sockfd, SOL_SOCKET, SO_REUSEADDR, (const char*)&reuse, sizeof(reuse));
+    DWORD rcv_tmo = 250; // wake periodically so Ctrl-C is noticed between packets
+    setsockopt(sockfd, SOL_SOCKET, SO_RCVTIMEO, (const char*)&rcv_tmo, sizeof(rcv_tmo));
 #else
     int sockfd = socket(AF_INET, SOCK_DGRAM, 0);
     if (sockfd < 0) { perror("[FATAL] socket"); return 1; }
     int reuse = 1;
     setsockopt(sockfd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+    timeval rcv_tmo{ 0, 250000 }; // wake periodically so SIGINT/SIGTERM are noticed between packets
+    setsockopt(sockfd, SOL_SOCKET, SO_RCVTIMEO, &rcv_tmo, sizeof(rcv_tmo));
 #endif
 
     sockaddr_in addr{};
@@ -565,7 +1056,7 @@ int main(int argc, char* argv[]) {
         }
         else {
             int err = WSAGetLastError();
-            if (err == WSAEINTR || err == WSAEWOULDBLOCK) continue;
+            if (err == WSAEINTR || err == WSAEWOULDBLOCK || err == WSAETIMEDOUT) continue;
             std::cerr << "[WARN] recvfrom error " << err << "\n";
         }
 #else
@@ -618,7 +1109,7 @@ int main(int argc, char* argv[]) {
             }
         }
         else {
-            if (errno == EINTR) continue;
+            if (errno == EINTR || errno == EAGAIN || errno == EWOULDBLOCK) continue;
             perror("[WARN] recvfrom");
         }
 #endif
@@ -634,18 +1125,36 @@ int main(int argc, char* argv[]) {
     close(sockfd);
 #endif
 
+    // drain decode workers before their sinks go away
+    if (decodePool) {
+        parser.setDecodePool(nullptr);
+        decodePool->stop();
+        decodePool.reset();
+    }
+
+    g_console.stop();
+
     if (socketRelay) {
+        socketRelay->print_stats(std::cerr);
         socketRelay->stop();
         socketRelay.reset();
     }
 
+    if (mcastPub) {
+        mcastPub->stop();
+        mcastPub->print_stats(std::cerr);
+        mcastPub.reset();
+    }
+
     if (file_writer_enabled) {
         g_file_writer.stop();
+        g_file_writer.print_stats(std::cerr);
     }
 
-#ifdef _WIN32
+    ConsoleSink::printSinkStats(std::cerr);
+    ConsoleSink::clearSinks();
+
     if (shmWriter.is_open()) shmWriter.close();
-#endif
 
     return 0;
 }
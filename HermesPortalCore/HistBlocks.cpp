@@ -0,0 +1,286 @@
+// src/HistBlocks.cpp
+// LZO block container for historical lines (see HistBlocks.h).
+
+#include "HistBlocks.h"
+#include "includes/hermes_core.h"
+
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <algorithm>
+#include <cstring>
+#include <ctime>
+
+namespace {
+
+    static uint32_t adler32(const unsigned char* p, size_t n) {
+        uint32_t a = 1, b = 0;
+        while (n) {
+            size_t k = n < 5552 ? n : 5552;     // largest run without overflowing b
+            n -= k;
+            while (k--) { a += *p++; b += a; }
+            a %= 65521u;
+            b %= 65521u;
+        }
+        return (b << 16) | a;
+    }
+
+    // unix seconds, or local "YYYY-MM-DD HH:MM:SS" / "YYYY-MM-DDTHH:MM:SS"
+    static bool parse_time(const std::string& s, uint32_t& out) {
+        if (!s.empty() && s.find_first_not_of("0123456789") == std::string::npos) {
+            try { out = static_cast<uint32_t>(std::stoul(s)); }
+            catch (...) { return false; }
+            return true;
+        }
+        std::tm tm{};
+        std::string t = s;
+        std::replace(t.begin(), t.end(), 'T', ' ');
+        std::istringstream is(t);
+        is >> std::get_time(&tm, "%Y-%m-%d %H:%M:%S");
+        if (is.fail()) return false;
+        tm.tm_isdst = -1;
+        std::time_t tt = std::mktime(&tm);
+        if (tt < 0) return false;
+        out = static_cast<uint32_t>(tt);
+        return true;
+    }
+
+} // namespace anon
+
+namespace HistBlocks {
+
+    std::string index_path(const std::string& data_path) {
+        std::string p = data_path;
+        const size_t dot = p.find_last_of('.');
+        const size_t sep = p.find_last_of("/\\");
+        if (dot != std::string::npos && (sep == std::string::npos || dot > sep)) p.resize(dot);
+        return p + ".hlx";
+    }
+
+    // ----------------- Encoder -----------------
+    Encoder::Encoder() : wrk_(Lzo::CompressWorkMem()) {}
+
+    std::string Encoder::file_header() {
+        FileHeader h{};
+        std::memcpy(h.magic, kMagic, sizeof(h.magic));
+        h.version = kVersion;
+        h.codec = kCodecLzo1x1;
+        return std::string(reinterpret_cast<const char*>(&h), sizeof(h));
+    }
+
+    void Encoder::seal(Pending& p, std::string& out, IndexEntry& idx) {
+        const uint32_t lines = static_cast<uint32_t>(p.ts.size());
+        raw_.resize(p.raw_bytes());
+        std::memcpy(&raw_[0], p.ts.data(), lines * sizeof(uint32_t));
+        std::memcpy(&raw_[lines * sizeof(uint32_t)], p.text.data(), p.text.size());
+        const unsigned char* raw = reinterpret_cast<const unsigned char*>(raw_.data());
+
+        BlockHdr h{};
+        h.magic = kBlockMagic;
+        h.raw_len = static_cast<uint32_t>(raw_.size());
+        h.lines = lines;
+        // min/max, not first/last: a clock step or out-of-order exchange time must not hide
+        // in-range lines from write_range
+        const auto mm = std::minmax_element(p.ts.begin(), p.ts.end());
+        h.first_ts = *mm.first;
+        h.last_ts = *mm.second;
+        h.adler = adler32(raw, raw_.size());
+
+        out.resize(sizeof(BlockHdr) + Lzo::CompressBound(raw_.size()));
+        unsigned char* payload = reinterpret_cast<unsigned char*>(&out[sizeof(BlockHdr)]);
+        size_t clen = 0;
+        if (Lzo::Compress1X(raw, raw_.size(), payload, out.size() - sizeof(BlockHdr), clen, wrk_.data()) && clen < raw_.size()) {
+            h.stored_len = static_cast<uint32_t>(clen);
+        }
+        else {
+            std::memcpy(payload, raw, raw_.size());
+            h.stored_len = h.raw_len;
+            h.flags |= kFlagStored;
+        }
+        out.resize(sizeof(BlockHdr) + h.stored_len);
+        std::memcpy(&out[0], &h, sizeof(h));
+
+        idx = IndexEntry{};
+        idx.first_ts = h.first_ts;
+        idx.last_ts = h.last_ts;
+        idx.lines = h.lines;
+        idx.stored_len = h.stored_len;
+        idx.raw_len = h.raw_len;
+        p.clear();
+    }
+
+    // ----------------- Reader -----------------
+    bool Reader::open(const std::string& data_path) {
+        close();
+        path_ = data_path;
+        in_.open(data_path, std::ios::binary);
+        if (!in_) return false;
+        in_.seekg(0, std::ios::end);
+        size_ = static_cast<uint64_t>(in_.tellg());
+        FileHeader fh{};
+        if (!read_at(0, &fh, sizeof(fh)) || std::memcmp(fh.magic, kMagic, sizeof(kMagic)) != 0 ||
+            fh.version != kVersion || fh.codec != kCodecLzo1x1) {
+            close();
+            return false;
+        }
+
+        // take index entries that line up with the data file; scan whatever they skip
+        std::vector<IndexEntry> idx;
+        std::ifstream ix(index_path(data_path), std::ios::binary);
+        if (ix) {
+            IndexEntry e{};
+            while (ix.read(reinterpret_cast<char*>(&e), sizeof(e))) idx.push_back(e);
+        }
+        uint64_t pos = sizeof(FileHeader);
+        for (const IndexEntry& e : idx) {
+            const uint64_t end = e.offset + sizeof(BlockHdr) + e.stored_len;
+            if (e.offset < pos || end > size_) continue;
+            if (e.offset > pos) scan(pos, e.offset);
+            BlockHdr h{};
+            if (!read_at(e.offset, &h, sizeof(h)) || h.magic != kBlockMagic || h.stored_len != e.stored_len) continue;
+            blocks_.push_back(e);
+            pos = end;
+        }
+        scan(pos, size_);
+        return true;
+    }
+
+    void Reader::close() {
+        if (in_.is_open()) in_.close();
+        in_.clear();
+        size_ = 0;
+        blocks_.clear();
+        scanned_ = 0;
+        bad_ = 0;
+    }
+
+    bool Reader::read_at(uint64_t off, void* dst, size_t len) {
+        if (off + len > size_) return false;
+        in_.clear();
+        in_.seekg(static_cast<std::streamoff>(off));
+        return static_cast<bool>(in_.read(static_cast<char*>(dst), static_cast<std::streamsize>(len)));
+    }
+
+    // walk block headers in [from, to); stops at the first thing that is not a whole block
+    void Reader::scan(uint64_t from, uint64_t to) {
+        uint64_t pos = from;
+        while (pos + sizeof(BlockHdr) <= to) {
+            BlockHdr h{};
+            if (!read_at(pos, &h, sizeof(h)) || h.magic != kBlockMagic) break;
+            const uint64_t end = pos + sizeof(BlockHdr) + h.stored_len;
+            if (end > to) break;                // torn tail
+            IndexEntry e{};
+            e.offset = pos;
+            e.first_ts = h.first_ts;
+            e.last_ts = h.last_ts;
+            e.lines = h.lines;
+            e.stored_len = h.stored_len;
+            e.raw_len = h.raw_len;
+            blocks_.push_back(e);
+            ++scanned_;
+            pos = end;
+        }
+    }
+
+    bool Reader::load_block(const IndexEntry& e, std::vector<uint32_t>& ts, std::string& text) {
+        BlockHdr h{};
+        if (!read_at(e.offset, &h, sizeof(h)) || h.magic != kBlockMagic) return false;
+        if (h.raw_len < h.lines * sizeof(uint32_t)) return false;
+        payload_.resize(h.stored_len);
+        if (h.stored_len && !read_at(e.offset + sizeof(BlockHdr), payload_.data(), h.stored_len)) return false;
+
+        std::string raw;
+        if (h.flags & kFlagStored) {
+            if (h.stored_len != h.raw_len) return false;
+            raw.assign(reinterpret_cast<const char*>(payload_.data()), payload_.size());
+        }
+        else {
+            raw.resize(h.raw_len);
+            size_t n = 0;
+            if (!Lzo::Decompress1X(payload_.data(), payload_.size(),
+                reinterpret_cast<unsigned char*>(&raw[0]), raw.size(), n) || n != h.raw_len) return false;
+        }
+        if (adler32(reinterpret_cast<const unsigned char*>(raw.data()), raw.size()) != h.adler) return false;
+
+        ts.resize(h.lines);
+        std::memcpy(ts.data(), raw.data(), h.lines * sizeof(uint32_t));
+        text.assign(raw, h.lines * sizeof(uint32_t), std::string::npos);
+        return true;
+    }
+
+    uint64_t Reader::write_range(uint32_t from, uint32_t to, std::ostream& out) {
+        uint64_t written = 0;
+        std::vector<uint32_t> ts;
+        std::string text;
+        for (const IndexEntry& e : blocks_) {
+            if (e.last_ts < from || e.first_ts > to) continue;    // the index answers most of the query
+            if (!load_block(e, ts, text)) { ++bad_; continue; }
+            size_t b = 0;
+            for (uint32_t i = 0; i < ts.size() && b < text.size(); ++i) {
+                size_t nl = text.find('\n', b);
+                size_t end = (nl == std::string::npos) ? text.size() : nl + 1;
+                if (ts[i] >= from && ts[i] <= to) {
+                    out.write(text.data() + b, static_cast<std::streamsize>(end - b));
+                    ++written;
+                }
+                b = end;
+            }
+        }
+        return written;
+    }
+
+} // namespace HistBlocks
+
+int RunHistDump(int argc, char* argv[]) {
+    std::string path;
+    uint32_t from = 0, to = 0xFFFFFFFFu;
+    bool list = false;
+    for (int i = 1; i < argc; ++i) {
+        std::string key = argv[i];
+        std::string val;
+        auto eq = key.find('=');
+        if (eq != std::string::npos) { val = key.substr(eq + 1); key = key.substr(0, eq); }
+        auto next = [&]() { if (val.empty() && i + 1 < argc) val = argv[++i]; return val; };
+        if (key == "--hist-dump") path = next();
+        else if (key == "--from" || key == "--to") {
+            std::string v = next();
+            if (!parse_time(v, key == "--from" ? from : to)) {
+                std::cerr << "[FATAL] invalid time for " << key << ": " << v << " (unix seconds or \"YYYY-MM-DD HH:MM:SS\")\n";
+                return 1;
+            }
+        }
+        else if (key == "--index") list = true;
+        else { std::cerr << "[FATAL] unknown hist-dump option " << key << "\n"; return 1; }
+    }
+    if (path.empty()) {
+        std::cerr << "[FATAL] --hist-dump needs a .hlz file\n";
+        return 1;
+    }
+
+    if (!Lzo::Init()) {
+        std::cerr << "[FATAL] LZO init failed\n";
+        return 1;
+    }
+    HistBlocks::Reader r;
+    if (!r.open(path)) {
+        std::cerr << "[FATAL] " << path << " is not a historical block file\n";
+        return 1;
+    }
+    if (list) {
+        std::ostringstream ss;
+        for (const auto& e : r.blocks()) {
+            ss << "offset=" << e.offset << " first=" << e.first_ts << " last=" << e.last_ts
+                << " lines=" << e.lines << " raw=" << e.raw_len << " stored=" << e.stored_len << "\n";
+        }
+        std::cout << ss.str();
+    }
+    else {
+        std::cout.unsetf(std::ios::unitbuf);   // main sets unitbuf for interactive logging
+        r.write_range(from, to, std::cout);
+        std::cout.flush();
+    }
+    if (r.scanned_blocks() || r.bad_blocks())
+        std::cerr << "[HIST] " << path << ": " << r.scanned_blocks() << " block(s) not in the index, "
+        << r.bad_blocks() << " unreadable\n";
+    return r.bad_blocks() ? 2 : 0;
+}
@@ -0,0 +1,128 @@
+#pragma once
+// HistBlocks: LZO-compressed historical container (historical/<market>/<token>.hlz + .hlx)
+// FileWriter buffers each token's lines into a block, compresses it with LZO1X-1 and appends
+// it to the .hlz file; a fixed-size entry per block goes to the .hlx index so a reader can seek
+// straight to a time range. Both files are append-only.
+//
+// .hlz layout (little endian):
+//   [FileHeader 32 bytes][BlockHdr 32 bytes][payload]...[BlockHdr][payload]
+//   payload = LZO1X(raw), or raw itself when kFlagStored is set (incompressible block)
+//   raw     = [uint32 ts x lines][line bytes, each ending with '\n']
+// .hlx layout: [IndexEntry 32 bytes]... in block order.
+// The index is written after its block; a reader trusts it only where it agrees with the data
+// file and scans block headers for anything it misses (e.g. after a crash between the two).
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <ostream>
+#include <fstream>
+#include <cstdint>
+#include <cstddef>
+
+namespace HistBlocks {
+
+    constexpr char kMagic[8] = { 'H','P','H','L','Z','1','\0','\0' };
+    constexpr uint32_t kVersion = 1;
+    constexpr uint32_t kCodecLzo1x1 = 1;
+    constexpr uint32_t kBlockMagic = 0x4B4C4248u;   // "HBLK"
+    constexpr uint32_t kFlagStored = 1u;            // payload is the raw block
+
+    struct FileHeader {
+        char magic[8];
+        uint32_t version;
+        uint32_t codec;
+        uint8_t reserved[16];
+    };
+
+    struct BlockHdr {
+        uint32_t magic;
+        uint32_t raw_len;
+        uint32_t stored_len;        // payload bytes following this header
+        uint32_t lines;
+        uint32_t first_ts;          // earliest / latest unix seconds in the block
+        uint32_t last_ts;
+        uint32_t flags;
+        uint32_t adler;             // adler32 of raw
+    };
+
+    struct IndexEntry {
+        uint64_t offset;            // BlockHdr position in the .hlz file
+        uint32_t first_ts;
+        uint32_t last_ts;
+        uint32_t lines;
+        uint32_t stored_len;
+        uint32_t raw_len;
+        uint32_t reserved;
+    };
+
+    static_assert(sizeof(FileHeader) == 32, "HistBlocks::FileHeader must be 32 bytes");
+    static_assert(sizeof(BlockHdr) == 32, "HistBlocks::BlockHdr must be 32 bytes");
+    static_assert(sizeof(IndexEntry) == 32, "HistBlocks::IndexEntry must be 32 bytes");
+
+    // .hlz path -> .hlx path
+    std::string index_path(const std::string& data_path);
+
+    // Lines of one token waiting to become a block.
+    struct Pending {
+        std::vector<uint32_t> ts;
+        std::string text;
+        uint64_t opened_ms = 0;     // steady-clock ms of the first line (age flush)
+
+        bool empty() const { return ts.empty(); }
+        size_t raw_bytes() const { return ts.size() * sizeof(uint32_t) + text.size(); }
+        void add(uint32_t unixsec, std::string_view line) { ts.push_back(unixsec); text.append(line.data(), line.size()); }
+        void clear() { ts.clear(); text.clear(); opened_ms = 0; }
+    };
+
+    // Turns Pending lines into encoded blocks. Owns the LZO work memory, so one per thread.
+    class Encoder {
+    public:
+        Encoder();
+
+        // Encode p (non-empty) as BlockHdr + payload into out (replaced) and describe it in idx
+        // (offset left 0 for the caller). p is cleared.
+        void seal(Pending& p, std::string& out, IndexEntry& idx);
+
+        // FileHeader bytes for a new .hlz file
+        static std::string file_header();
+
+    private:
+        std::vector<unsigned char> wrk_;
+        std::string raw_;
+    };
+
+    // Reads a .hlz file (and its .hlx index when present).
+    class Reader {
+    public:
+        bool open(const std::string& data_path);
+        void close();
+
+        // blocks found (index entries that match the data file, plus scanned ones)
+        const std::vector<IndexEntry>& blocks() const { return blocks_; }
+        uint64_t scanned_blocks() const { return scanned_; }    // not covered by the index
+        uint64_t bad_blocks() const { return bad_; }            // failed to decode (skipped)
+
+        // Write every line with from <= ts <= to to out, in file order. Returns lines written.
+        uint64_t write_range(uint32_t from, uint32_t to, std::ostream& out);
+
+    private:
+        bool load_block(const IndexEntry& e, std::vector<uint32_t>& ts, std::string& text);
+        bool read_at(uint64_t off, void* dst, size_t len);
+        void scan(uint64_t from, uint64_t to);
+
+        std::string path_;
+        std::ifstream in_;
+        uint64_t size_ = 0;
+        std::vector<IndexEntry> blocks_;
+        std::vector<unsigned char> payload_;
+        uint64_t scanned_ = 0;
+        uint64_t bad_ = 0;
+    };
+
+} // namespace HistBlocks
+
+// HermesPortal --hist-dump <file.hlz> [--from <time>] [--to <time>] [--index]
+//   streams the lines of a block file as CSV to stdout; <time> is unix seconds or local
+//   "YYYY-MM-DD HH:MM:SS". --index lists the blocks instead. Returns the process exit code.
+int RunHistDump(int argc, char* argv[]);
@@ -0,0 +1,390 @@
+// src/LiveSnapshot.cpp
+// Memory-mapped live snapshot file + lock-free reader (see LiveSnapshot.h).
+
+#include "LiveSnapshot.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <thread>
+#include <unordered_map>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+    using Header = LiveSnapshot::Header;
+    using SlotHdr = LiveSnapshot::SlotHdr;
+
+    static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t), "atomic<uint32_t> must be plain-sized");
+
+    static inline std::atomic<uint32_t>* as_atomic(uint32_t* p) {
+        return reinterpret_cast<std::atomic<uint32_t>*>(p);
+    }
+
+    static inline uint32_t slot_of(uint32_t token, uint32_t mask) {
+        return static_cast<uint32_t>((static_cast<uint64_t>(token) * 0x9E3779B97F4A7C15ull) >> 32) & mask;
+    }
+
+    static uint64_t now_ns() {
+        using namespace std::chrono;
+        return static_cast<uint64_t>(duration_cast<nanoseconds>(system_clock::now().time_since_epoch()).count());
+    }
+
+    // ----------------- file mapping -----------------
+    struct Mapping {
+        uint8_t* base = nullptr;
+        size_t size = 0;
+#ifdef _WIN32
+        HANDLE file = INVALID_HANDLE_VALUE;
+        HANDLE map = nullptr;
+#else
+        int fd = -1;
+#endif
+
+        // writable: create/extend to `want` bytes; read-only: map the existing file as is
+        bool open(const std::string& path, bool writable, size_t want) {
+#ifdef _WIN32
+            file = CreateFileA(path.c_str(), writable ? (GENERIC_READ | GENERIC_WRITE) : GENERIC_READ,
+                FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr,
+                writable ? OPEN_ALWAYS : OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+            if (file == INVALID_HANDLE_VALUE) return false;
+            LARGE_INTEGER cur{};
+            GetFileSizeEx(file, &cur);
+            size = static_cast<size_t>(cur.QuadPart);
+            if (writable && size != want) {
+                LARGE_INTEGER li{}; li.QuadPart = static_cast<LONGLONG>(want);
+                if (!SetFilePointerEx(file, li, nullptr, FILE_BEGIN) || !SetEndOfFile(file)) { close(); return false; }
+                size = want;
+            }
+            if (size < sizeof(Header)) { close(); return false; }
+            map = CreateFileMappingW(file, nullptr, writable ? PAGE_READWRITE : PAGE_READONLY, 0, 0, nullptr);
+            if (!map) { close(); return false; }
+            base = static_cast<uint8_t*>(MapViewOfFile(map, writable ? FILE_MAP_WRITE : FILE_MAP_READ, 0, 0, size));
+            if (!base) { close(); return false; }
+            return true;
+#else
+            fd = ::open(path.c_str(), writable ? (O_RDWR | O_CREAT | O_CLOEXEC) : (O_RDONLY | O_CLOEXEC), 0644);
+            if (fd < 0) return false;
+            struct stat st {};
+            if (fstat(fd, &st) != 0) { close(); return false; }
+            size = static_cast<size_t>(st.st_size);
+            if (writable && size != want) {
+                if (ftruncate(fd, static_cast<off_t>(want)) != 0) { close(); return false; }
+                size = want;
+            }
+            if (size < sizeof(Header)) { close(); return false; }
+            void* p = mmap(nullptr, size, writable ? (PROT_READ | PROT_WRITE) : PROT_READ, MAP_SHARED, fd, 0);
+            if (p == MAP_FAILED) { close(); return false; }
+            base = static_cast<uint8_t*>(p);
+            return true;
+#endif
+        }
+
+        void close() {
+#ifdef _WIN32
+            if (base) UnmapViewOfFile(base);
+            if (map) CloseHandle(map);
+            if (file != INVALID_HANDLE_VALUE) CloseHandle(file);
+            map = nullptr; file = INVALID_HANDLE_VALUE;
+#else
+            if (base) munmap(base, size);
+            if (fd >= 0) ::close(fd);
+            fd = -1;
+#endif
+            base = nullptr; size = 0;
+        }
+    };
+
+    struct Table {
+        Mapping m;
+        Header* hdr = nullptr;
+        uint32_t slot_bytes = 0;
+        uint32_t mask = 0;
+
+        SlotHdr* slot(uint32_t i) const {
+            return reinterpret_cast<SlotHdr*>(m.base + sizeof(Header) + static_cast<size_t>(i) * slot_bytes);
+        }
+        char* payload(SlotHdr* s) const { return reinterpret_cast<char*>(s) + sizeof(SlotHdr); }
+        uint32_t capacity() const { return slot_bytes - static_cast<uint32_t>(sizeof(SlotHdr)); }
+    };
+
+    static bool header_valid(const Header* h, size_t file_size) {
+        if (std::memcmp(h->magic, LiveSnapshot::kMagic, sizeof(h->magic)) != 0) return false;
+        if (h->version != LiveSnapshot::kVersion) return false;
+        if (h->slot_bytes < sizeof(SlotHdr) + 8 || (h->slot_bytes & 7)) return false;
+        if (!h->slot_count || (h->slot_count & (h->slot_count - 1))) return false;
+        return file_size >= sizeof(Header) + static_cast<size_t>(h->slot_count) * h->slot_bytes;
+    }
+
+    struct WriterImpl {
+        Table t;
+    };
+
+} // namespace anon
+
+// ----------------- LiveSnapshot (writer) -----------------
+LiveSnapshot::LiveSnapshot() {
+    impl_ = new WriterImpl();
+}
+
+LiveSnapshot::~LiveSnapshot() {
+    close();
+    delete reinterpret_cast<WriterImpl*>(impl_);
+    impl_ = nullptr;
+}
+
+bool LiveSnapshot::open(const std::string& path, uint32_t slot_count, uint32_t slot_bytes) {
+    WriterImpl* I = reinterpret_cast<WriterImpl*>(impl_);
+    close();
+
+    uint32_t count = 64;
+    while (count < slot_count) count <<= 1;
+    uint32_t bytes = (slot_bytes + 7u) & ~7u;
+    if (bytes < sizeof(SlotHdr) + 64) bytes = static_cast<uint32_t>(sizeof(SlotHdr) + 64);
+    const size_t want = sizeof(Header) + static_cast<size_t>(count) * bytes;
+
+    if (!I->t.m.open(path, true, want)) return false;
+    Header* h = reinterpret_cast<Header*>(I->t.m.base);
+
+    // keep the previous session's values when the geometry is unchanged
+    bool reuse = header_valid(h, I->t.m.size) && h->slot_count == count && h->slot_bytes == bytes;
+    if (!reuse) {
+        std::memset(I->t.m.base, 0, want);
+        h->version = kVersion;
+        h->slot_bytes = bytes;
+        h->slot_count = count;
+        h->used = 0;
+        h->create_ns = now_ns();
+        std::atomic_thread_fence(std::memory_order_release);
+        std::memcpy(h->magic, kMagic, sizeof(kMagic));   // magic last: readers reject a half-built file
+    }
+    else {
+        // a crash mid-update may have left a slot odd; make every slot readable again
+        for (uint32_t i = 0; i < count; ++i) {
+            SlotHdr* s = reinterpret_cast<SlotHdr*>(I->t.m.base + sizeof(Header) + static_cast<size_t>(i) * bytes);
+            uint32_t seq = as_atomic(&s->seq)->load(std::memory_order_relaxed);
+            if (seq & 1u) as_atomic(&s->seq)->store(seq + 1, std::memory_order_release);
+        }
+    }
+
+    I->t.hdr = h;
+    I->t.slot_bytes = bytes;
+    I->t.mask = count - 1;
+    return true;
+}
+
+void LiveSnapshot::close() {
+    WriterImpl* I = reinterpret_cast<WriterImpl*>(impl_);
+    if (!I || !I->t.m.base) return;
+    I->t.m.close();
+    I->t.hdr = nullptr;
+}
+
+bool LiveSnapshot::is_open() const {
+    WriterImpl* I = reinterpret_cast<WriterImpl*>(impl_);
+    return I->t.m.base != nullptr;
+}
+
+bool LiveSnapshot::update(uint32_t token, std::string_view line) {
+    WriterImpl* I = reinterpret_cast<WriterImpl*>(impl_);
+    Table& t = I->t;
+    if (!t.m.base || token == 0) return false;
+
+    // find the token's slot, or claim the first empty one on its probe path (CAS: writer
+    // threads owning different tokens may race for the same empty slot)
+    std::atomic<uint32_t>* used = as_atomic(&t.hdr->used);
+    uint32_t idx = slot_of(token, t.mask);
+    SlotHdr* s = nullptr;
+    for (uint32_t probe = 0; probe <= t.mask; ++probe, idx = (idx + 1) & t.mask) {
+        SlotHdr* c = t.slot(idx);
+        uint32_t tk = as_atomic(&c->token)->load(std::memory_order_acquire);
+        if (tk == token) { s = c; break; }
+        if (tk != 0) continue;
+        if (used->load(std::memory_order_relaxed) >= t.mask) return false;  // keep one empty slot so probes terminate
+        uint32_t expected = 0;
+        if (as_atomic(&c->token)->compare_exchange_strong(expected, token, std::memory_order_acq_rel)) {
+            used->fetch_add(1, std::memory_order_relaxed);
+            s = c;
+            break;
+        }
+        if (expected == token) { s = c; break; }
+    }
+    if (!s) return false;
+
+    std::atomic<uint32_t>* seq = as_atomic(&s->seq);
+    const uint32_t v = seq->load(std::memory_order_relaxed);
+    seq->store(v + 1, std::memory_order_relaxed);           // odd: write in progress
+    std::atomic_thread_fence(std::memory_order_release);
+
+    const uint32_t cap = t.capacity();
+    const uint32_t n = line.size() > cap ? cap : static_cast<uint32_t>(line.size());
+    std::memcpy(t.payload(s), line.data(), n);
+    s->len = n;
+    s->flags = (n < line.size()) ? kFlagTruncated : 0u;
+    s->update_ns = now_ns();
+    seq->store(v + 2, std::memory_order_release);
+    return true;
+}
+
+uint32_t LiveSnapshot::slot_count() const {
+    WriterImpl* I = reinterpret_cast<WriterImpl*>(impl_);
+    return I->t.hdr ? I->t.mask + 1 : 0;
+}
+
+uint32_t LiveSnapshot::used() const {
+    WriterImpl* I = reinterpret_cast<WriterImpl*>(impl_);
+    return I->t.hdr ? as_atomic(&I->t.hdr->used)->load(std::memory_order_relaxed) : 0;
+}
+
+// ----------------- LiveSnapshotReader -----------------
+LiveSnapshotReader::LiveSnapshotReader() {
+    impl_ = new Table();
+}
+
+LiveSnapshotReader::~LiveSnapshotReader() {
+    close();
+    delete reinterpret_cast<Table*>(impl_);
+    impl_ = nullptr;
+}
+
+bool LiveSnapshotReader::open(const std::string& path) {
+    Table* T = reinterpret_cast<Table*>(impl_);
+    close();
+    if (!T->m.open(path, false, 0)) return false;
+    Header* h = reinterpret_cast<Header*>(T->m.base);
+    if (!header_valid(h, T->m.size)) { T->m.close(); return false; }
+    T->hdr = h;
+    T->slot_bytes = h->slot_bytes;
+    T->mask = h->slot_count - 1;
+    return true;
+}
+
+void LiveSnapshotReader::close() {
+    Table* T = reinterpret_cast<Table*>(impl_);
+    if (!T || !T->m.base) return;
+    T->m.close();
+    T->hdr = nullptr;
+}
+
+uint32_t LiveSnapshotReader::slot_count() const {
+    Table* T = reinterpret_cast<Table*>(impl_);
+    return T->hdr ? T->mask + 1 : 0;
+}
+
+bool LiveSnapshotReader::read_slot(uint32_t idx, uint32_t& token, std::string& out, uint64_t& update_ns) const {
+    Table* T = reinterpret_cast<Table*>(impl_);
+    if (!T->hdr || idx > T->mask) return false;
+    SlotHdr* s = T->slot(idx);
+    std::atomic<uint32_t>* seq = as_atomic(&s->seq);
+    const uint32_t cap = T->capacity();
+    for (;;) {
+        uint32_t s1 = seq->load(std::memory_order_acquire);
+        if (s1 == 0) return false;                              // claimed, first value not written yet
+        if (s1 & 1u) continue;                                  // writer inside the slot
+        uint32_t tk = as_atomic(&s->token)->load(std::memory_order_acquire);
+        if (tk == 0) return false;
+        uint32_t n = s->len;
+        if (n > cap) n = cap;
+        out.assign(T->payload(s), n);
+        uint64_t ts = s->update_ns;
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (seq->load(std::memory_order_relaxed) != s1) continue;  // torn read: retry
+        token = tk;
+        update_ns = ts;
+        return true;
+    }
+}
+
+bool LiveSnapshotReader::read(uint32_t token, std::string& out, uint64_t* update_ns) const {
+    Table* T = reinterpret_cast<Table*>(impl_);
+    if (!T->hdr || token == 0) return false;
+    uint32_t idx = slot_of(token, T->mask);
+    for (uint32_t probe = 0; probe <= T->mask; ++probe, idx = (idx + 1) & T->mask) {
+        uint32_t tk = as_atomic(&T->slot(idx)->token)->load(std::memory_order_acquire);
+        if (tk == 0) return false;
+        if (tk != token) continue;
+        uint32_t got = 0;
+        uint64_t ts = 0;
+        if (!read_slot(idx, got, out, ts)) return false;
+        if (update_ns) *update_ns = ts;
+        return true;
+    }
+    return false;
+}
+
+// ---------------- --live-read ----------------
+int RunLiveRead(int argc, char* argv[]) {
+    std::string path;
+    uint32_t token = 0;
+    double secs = 0;
+    unsigned poll_ms = 100;
+    for (int i = 1; i < argc; ++i) {
+        std::string key = argv[i];
+        std::string val;
+        auto eq = key.find('=');
+        if (eq != std::string::npos) { val = key.substr(eq + 1); key = key.substr(0, eq); }
+        auto next = [&]() { if (val.empty() && i + 1 < argc) val = argv[++i]; return val; };
+        try {
+            if (key == "--live-read") path = next();
+            else if (key == "--token") token = static_cast<uint32_t>(std::stoul(next()));
+            else if (key == "--secs") secs = std::stod(next());
+            else if (key == "--poll-ms") poll_ms = static_cast<unsigned>(std::stoul(next()));
+            else { std::cerr << "[FATAL] unknown live-read option " << key << "\n"; return 1; }
+        }
+        catch (...) { std::cerr << "[FATAL] invalid value for " << key << ": " << val << "\n"; return 1; }
+    }
+    if (path.empty()) {
+        std::cerr << "[FATAL] --live-read needs a live/<market>.snap file\n";
+        return 1;
+    }
+    LiveSnapshotReader r;
+    if (!r.open(path)) {
+        std::cerr << "[FATAL] cannot open snapshot " << path << " (missing or not a snapshot)\n";
+        return 1;
+    }
+
+    // each pass prints the tokens updated since the previous one (the first: all of them)
+    std::cout.unsetf(std::ios::unitbuf);   // main sets unitbuf for interactive logging
+    std::unordered_map<uint32_t, uint64_t> seen;   // token -> update_ns printed
+    uint64_t passes = 0, updates = 0;
+    auto emit = [&](uint32_t tk, const std::string& line, uint64_t ts) {
+        uint64_t& last = seen[tk];
+        if (passes && last == ts) return;
+        last = ts;
+        ++updates;
+        std::cout << line << '\n';
+    };
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(static_cast<long long>(secs * 1000));
+    for (;;) {
+        if (token) {
+            std::string line;
+            uint64_t ts = 0;
+            if (r.read(token, line, &ts)) emit(token, line, ts);
+        }
+        else r.for_each(emit);
+        ++passes;
+        if (secs <= 0 || std::chrono::steady_clock::now() >= deadline) break;
+        std::this_thread::sleep_for(std::chrono::milliseconds(poll_ms));
+    }
+    std::cout.flush();
+
+    std::ostringstream ss;
+    ss << "[LIVE] " << path << " tokens=" << seen.size() << " slots=" << r.slot_count()
+        << " passes=" << passes << " updates=" << updates;
+    std::cerr << ss.str() << "\n";
+    if (token && seen.empty()) {
+        std::cerr << "[LIVE] token " << token << " has no slot\n";
+        return 2;
+    }
+    return 0;
+}
@@ -0,0 +1,110 @@
+#pragma once
+// LiveSnapshot: memory-mapped "latest line per token" file for one market (live/<market>.snap)
+// Replaces the tmp+rename of live/<market>/<token>.txt on every tick with a memcpy into a
+// fixed-size slot. Each slot is guarded by a sequence counter (seqlock) so any number of
+// readers can poll the file without locks while the FileWriter thread updates it.
+//
+// File layout (little endian):
+//   [Header 64 bytes][Slot 0][Slot 1]...[Slot slot_count-1]
+//   Slot = [uint32 seq][uint32 token][uint32 len][uint32 flags][uint64 update_ns][line bytes]
+// Tokens are placed by open addressing (Fibonacci hash, linear probe); token 0 = empty slot.
+// seq is odd while the writer is inside the slot; a reader retries until it sees the same
+// even value before and after copying.
+
+#include <string>
+#include <string_view>
+#include <cstdint>
+#include <cstddef>
+
+class LiveSnapshot {
+public:
+    static constexpr char kMagic[8] = { 'H','P','L','I','V','E','1','\0' };
+    static constexpr uint32_t kVersion = 1;
+    static constexpr uint32_t kFlagTruncated = 1u;
+
+    struct Header {
+        char magic[8];
+        uint32_t version;
+        uint32_t slot_bytes;        // total bytes per slot, header included
+        uint32_t slot_count;        // power of two
+        uint32_t used;              // slots holding a token (writer-maintained)
+        uint64_t create_ns;
+        uint8_t reserved[32];
+    };
+
+    struct SlotHdr {
+        uint32_t seq;
+        uint32_t token;
+        uint32_t len;
+        uint32_t flags;
+        uint64_t update_ns;         // system_clock ns of the last update
+    };
+
+    static_assert(sizeof(Header) == 64, "LiveSnapshot::Header must be 64 bytes");
+    static_assert(sizeof(SlotHdr) == 24, "LiveSnapshot::SlotHdr must be 24 bytes");
+
+    LiveSnapshot();
+    ~LiveSnapshot();
+
+    // Create (or reuse when the geometry matches) and map the snapshot file.
+    // slot_bytes is rounded up to a multiple of 8; slot_count to a power of two.
+    bool open(const std::string& path, uint32_t slot_count, uint32_t slot_bytes);
+    void close();
+    bool is_open() const;
+
+    // Copy the latest line for token into its slot. false when the table is full.
+    // Thread-safe across writers as long as each token has a single writer (FileWriter shards
+    // own disjoint tokens); claiming an empty slot is a CAS.
+    bool update(uint32_t token, std::string_view line);
+
+    uint32_t slot_count() const;
+    uint32_t used() const;
+
+private:
+    void* impl_; // opaque pointer to implementation
+
+    LiveSnapshot(const LiveSnapshot&) = delete;
+    LiveSnapshot& operator=(const LiveSnapshot&) = delete;
+};
+
+// Lock-free reader for a snapshot written by another thread or process.
+class LiveSnapshotReader {
+public:
+    LiveSnapshotReader();
+    ~LiveSnapshotReader();
+
+    bool open(const std::string& path);
+    void close();
+
+    // Latest line for token (no newline). false when the token has no slot yet.
+    bool read(uint32_t token, std::string& out, uint64_t* update_ns = nullptr) const;
+
+    // Call fn(token, line, update_ns) for every occupied slot; returns the number visited.
+    template <class Fn>
+    size_t for_each(Fn&& fn) const {
+        size_t n = 0;
+        std::string line;
+        for (uint32_t i = 0; i < slot_count(); ++i) {
+            uint32_t token = 0;
+            uint64_t ts = 0;
+            if (read_slot(i, token, line, ts)) { fn(token, line, ts); ++n; }
+        }
+        return n;
+    }
+
+    uint32_t slot_count() const;
+
+private:
+    bool read_slot(uint32_t idx, uint32_t& token, std::string& out, uint64_t& update_ns) const;
+
+    void* impl_; // opaque pointer to implementation
+
+    LiveSnapshotReader(const LiveSnapshotReader&) = delete;
+    LiveSnapshotReader& operator=(const LiveSnapshotReader&) = delete;
+};
+
+// HermesPortal --live-read <live/market.snap> [--token <n>] [--secs <n>] [--poll-ms <ms>]
+//   dumps the latest line of every token (or just --token) through LiveSnapshotReader; with
+//   --secs it keeps polling every poll_ms (default 100) and prints each token again when its
+//   slot changed, while the writer runs. Returns the process exit code (2: token not found).
+int RunLiveRead(int argc, char* argv[]);
@@ -2,6 +2,7 @@
 
 extern "C" {
 #include <lzo/lzo1z.h>
+#include <lzo/lzo1x.h>
 }
 
 namespace Lzo {
@@ -23,4 +24,37 @@ namespace Lzo {
         return true;
     }
 
+    std::size_t CompressWorkMem() {
+        return static_cast<std::size_t>(LZO1X_1_MEM_COMPRESS);
+    }
+
+    // worst case for incompressible input (LZO documentation)
+    std::size_t CompressBound(std::size_t inLen) {
+        return inLen + inLen / 16 + 64 + 3;
+    }
+
+    bool Compress1X(const unsigned char* in, std::size_t inLen,
+        unsigned char* out, std::size_t outCap, std::size_t& outLen, void* workMem) {
+        if (!in || !out || !workMem || inLen == 0 || outCap < CompressBound(inLen)) return false;
+        lzo_uint dst_len = static_cast<lzo_uint>(outCap);
+        int rc = lzo1x_1_compress(const_cast<unsigned char*>(in),
+            static_cast<lzo_uint>(inLen),
+            out, &dst_len, workMem);
+        if (rc != LZO_E_OK) return false;
+        outLen = static_cast<std::size_t>(dst_len);
+        return true;
+    }
+
+    bool Decompress1X(const unsigned char* in, std::size_t inLen,
+        unsigned char* out, std::size_t outCap, std::size_t& outLen) {
+        if (!in || !out || inLen == 0 || outCap == 0) return false;
+        lzo_uint dst_len = static_cast<lzo_uint>(outCap);
+        int rc = lzo1x_decompress_safe(const_cast<unsigned char*>(in),
+            static_cast<lzo_uint>(inLen),
+            out, &dst_len, nullptr);
+        if (rc != LZO_E_OK) return false;
+        outLen = static_cast<std::size_t>(dst_len);
+        return true;
+    }
+
 } // namespace Lzo
@@ -0,0 +1,514 @@
+// src/McastPublisher.cpp
+// Implementation for McastPublisher (--out mcast)
+// Uses opaque impl_ pointer in header to avoid nested-private-access issues.
+//
+// Datagrams live in a ring of fixed slots of cfg.datagram_bytes. Slot numbers are the
+// datagram sequence numbers: [sent_seq, open_seq) are sealed and waiting for the sender,
+// open_seq is being filled by publish(). The sender reads sealed slots without the lock
+// (producers only ever write the open slot, which is never one of them) and returns them by
+// advancing sent_seq. A record that does not fit the open slot seals it; when no free slot is
+// left the record is dropped, so a rate cap or a slow socket never reaches the decode lanes.
+
+#include "McastPublisher.h"
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <vector>
+#include <string>
+#include <iostream>
+#include <sstream>
+#include <chrono>
+#include <cstring>
+#include <stdexcept>
+#include <algorithm>
+#include <atomic>
+#include <csignal>
+#include <cerrno>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#define WIN32_LEAN_AND_MEAN
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#pragma comment(lib, "Ws2_32.lib")
+using sock_t = SOCKET;
+static const sock_t INVALID_SOCK = INVALID_SOCKET;
+#else
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <sys/time.h>
+using sock_t = int;
+static const sock_t INVALID_SOCK = -1;
+#endif
+
+namespace {
+
+    using Clock = std::chrono::steady_clock;
+
+    // Local implementation type (hidden)
+    struct Impl {
+        McastPublisher::Config cfg;
+        sock_t s = INVALID_SOCK;
+        uint32_t session = 0;
+
+        // datagram slots
+        std::vector<char> mem;
+        std::vector<uint32_t> lens;             // payload bytes of each sealed slot
+        size_t slots = 0;
+
+        mutable std::mutex mtx;
+        std::condition_variable cv;
+        uint64_t sent_seq = 0;                  // next slot for the sender
+        uint64_t open_seq = 0;                  // slot publish() fills
+        uint32_t open_len = 0;
+        uint32_t open_records = 0;
+        Clock::time_point open_since;           // first record of the open slot
+        bool running = false;
+        std::thread sender;
+        McastPublisher::Stats st;
+
+        char* slot(uint64_t n) { return mem.data() + (n % slots) * cfg.datagram_bytes; }
+
+        Impl(const McastPublisher::Config& c) : cfg(c) {}
+    };
+
+    inline void close_sock(sock_t s) {
+#ifdef _WIN32
+        if (s != INVALID_SOCK) closesocket(s);
+#else
+        if (s != INVALID_SOCK) close(s);
+#endif
+    }
+
+    // Write the header of the open slot and hand it to the sender (mtx held)
+    static void seal(Impl* I) {
+        McastPublisher::DatagramHdr h{};
+        h.magic = McastPublisher::kMagic;
+        h.version = McastPublisher::kVersion;
+        h.format = static_cast<uint16_t>(I->cfg.format);
+        h.seq = I->open_seq;
+        h.records = I->open_records;
+        h.session = I->session;
+        std::memcpy(I->slot(I->open_seq), &h, sizeof(h));
+        I->lens[I->open_seq % I->slots] = I->open_len;
+        ++I->open_seq;
+        I->open_len = sizeof(McastPublisher::DatagramHdr);
+        I->open_records = 0;
+        I->st.queue_hwm = std::max<uint64_t>(I->st.queue_hwm, I->open_seq - I->sent_seq);
+    }
+
+    // UDP socket connected to group:port; multicast options when group is a class D address
+    static sock_t open_socket(const McastPublisher::Config& cfg) {
+        sockaddr_in dst{};
+        dst.sin_family = AF_INET;
+        dst.sin_port = htons(cfg.port);
+        if (inet_pton(AF_INET, cfg.group.c_str(), &dst.sin_addr) != 1) return INVALID_SOCK;
+        sock_t s = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+        if (s == INVALID_SOCK) return s;
+
+        int sndbuf = 4 << 20;                   // best-effort: absorbs bursts between paced sends
+        setsockopt(s, SOL_SOCKET, SO_SNDBUF, reinterpret_cast<const char*>(&sndbuf), sizeof(sndbuf));
+        const uint32_t first = ntohl(dst.sin_addr.s_addr) >> 24;
+        if (first >= 224 && first <= 239) {
+            in_addr ifa{};
+            if (!cfg.iface.empty() && inet_pton(AF_INET, cfg.iface.c_str(), &ifa) == 1)
+                setsockopt(s, IPPROTO_IP, IP_MULTICAST_IF, reinterpret_cast<const char*>(&ifa), sizeof(ifa));
+#ifdef _WIN32
+            DWORD ttl = static_cast<DWORD>(cfg.ttl), loop = cfg.loop ? 1 : 0;
+#else
+            unsigned char ttl = static_cast<unsigned char>(cfg.ttl), loop = cfg.loop ? 1 : 0;
+#endif
+            setsockopt(s, IPPROTO_IP, IP_MULTICAST_TTL, reinterpret_cast<const char*>(&ttl), sizeof(ttl));
+            setsockopt(s, IPPROTO_IP, IP_MULTICAST_LOOP, reinterpret_cast<const char*>(&loop), sizeof(loop));
+        }
+        if (connect(s, reinterpret_cast<sockaddr*>(&dst), sizeof(dst)) != 0) {
+            close_sock(s);
+            return INVALID_SOCK;
+        }
+        return s;
+    }
+
+    // Sender thread: sealed slots in order, paced by cfg.rate_bytes; seals a partial slot
+    // flush_us after its first record. Drains everything before exiting.
+    // Slots already sent go back to publish() before every pacing sleep, not only at the end
+    // of the run, so a rate cap holds no more of the ring than it has yet to send.
+    static void send_loop(Impl* I) {
+        Clock::time_point next_free = Clock::now();
+        Clock::duration paced{};                // rate-cap waits since start (paced_ms)
+        std::unique_lock<std::mutex> lk(I->mtx);
+        while (true) {
+            if (I->sent_seq == I->open_seq) {
+                if (I->open_records) {
+                    const auto due = I->open_since + std::chrono::microseconds(I->cfg.flush_us);
+                    if (I->running && Clock::now() < due) { I->cv.wait_until(lk, due); continue; }
+                    seal(I);                    // the ring is empty, so there is a free slot
+                }
+                else {
+                    if (!I->running) break;
+                    I->cv.wait_for(lk, std::chrono::milliseconds(100));
+                    continue;
+                }
+            }
+            uint64_t from = I->sent_seq;
+            const uint64_t to = I->open_seq;
+            lk.unlock();
+
+            uint64_t bytes = 0, errors = 0;
+            auto give_back = [&](uint64_t upto) {
+                I->sent_seq = upto;
+                I->st.datagrams += (upto - from) - errors;
+                I->st.bytes += bytes;
+                I->st.send_errors += errors;
+                I->st.paced_ms = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(paced).count());
+                from = upto;
+                bytes = errors = 0;
+            };
+            for (uint64_t k = from; k < to; ++k) {
+                const uint32_t len = I->lens[k % I->slots];
+                if (I->cfg.rate_bytes) {
+                    const auto now = Clock::now();
+                    if (next_free > now) {
+                        if (k > from) {
+                            lk.lock();
+                            give_back(k);
+                            lk.unlock();
+                        }
+                        std::this_thread::sleep_until(next_free);
+                        paced += next_free - now;
+                    }
+                    else next_free = now;       // no credit for idle time
+                    next_free += std::chrono::nanoseconds(static_cast<uint64_t>(len * 1e9 / I->cfg.rate_bytes));
+                }
+                if (send(I->s, I->slot(k), static_cast<int>(len), 0) < 0) ++errors;
+                else bytes += len;
+            }
+
+            lk.lock();
+            give_back(to);
+        }
+    }
+
+} // namespace anon
+
+// Public McastPublisher methods
+
+McastPublisher::McastPublisher(const Config& cfg) {
+    impl_ = new Impl(cfg);
+}
+
+McastPublisher::~McastPublisher() {
+    try { stop(); }
+    catch (...) {}
+    if (impl_) { delete reinterpret_cast<Impl*>(impl_); impl_ = nullptr; }
+}
+
+void McastPublisher::start() {
+    if (!impl_) return;
+    Impl* I = reinterpret_cast<Impl*>(impl_);
+    if (I->running) return;
+    if (I->cfg.port == 0) throw std::runtime_error("McastPublisher: port required");
+    I->cfg.datagram_bytes = std::min<size_t>(std::max<size_t>(I->cfg.datagram_bytes, 256), 65507);
+
+    I->s = open_socket(I->cfg);
+    if (I->s == INVALID_SOCK) throw std::runtime_error("McastPublisher: cannot open a UDP socket to " + I->cfg.group);
+
+    I->slots = std::max<size_t>(I->cfg.queue_bytes / I->cfg.datagram_bytes, 16);
+    I->mem.assign(I->slots * I->cfg.datagram_bytes, 0);
+    I->lens.assign(I->slots, 0);
+    I->sent_seq = I->open_seq = 0;
+    I->open_len = sizeof(DatagramHdr);
+    I->open_records = 0;
+    I->st = Stats{};
+    I->session = static_cast<uint32_t>(std::chrono::system_clock::now().time_since_epoch().count() ^
+        (std::chrono::steady_clock::now().time_since_epoch().count() << 7));
+    I->running = true;
+    I->sender = std::thread(send_loop, I);
+
+    if (I->cfg.verbose) std::cerr << "[MCAST] publishing to " << I->cfg.group << ":" << I->cfg.port << "\n";
+}
+
+void McastPublisher::stop() {
+    if (!impl_) return;
+    Impl* I = reinterpret_cast<Impl*>(impl_);
+    {
+        std::lock_guard<std::mutex> lk(I->mtx);
+        if (!I->running) return;
+        I->running = false;
+    }
+    I->cv.notify_one();
+    if (I->sender.joinable()) I->sender.join();
+    close_sock(I->s);
+    I->s = INVALID_SOCK;
+}
+
+bool McastPublisher::publish(const RecordMeta& meta, std::string_view csvLine) {
+    if (!impl_) return false;
+    Impl* I = reinterpret_cast<Impl*>(impl_);
+    if (!csvLine.empty() && csvLine.back() == '\n') csvLine.remove_suffix(1);
+    const bool binary = I->cfg.format == Format::Binary;
+    const size_t need = binary ? sizeof(RecordHdr) + csvLine.size() : csvLine.size() + 1;
+
+    bool wake = false;
+    {
+        std::lock_guard<std::mutex> lk(I->mtx);
+        if (!I->running) return false;
+        if (need > I->cfg.datagram_bytes - sizeof(DatagramHdr) || csvLine.size() > 0xFFFF) { ++I->st.oversize; return false; }
+        if (I->open_len + need > I->cfg.datagram_bytes) {
+            if (I->open_seq + 1 - I->sent_seq >= I->slots) { ++I->st.dropped; return false; }
+            seal(I);
+            wake = true;
+        }
+        char* p = I->slot(I->open_seq) + I->open_len;
+        if (binary) {
+            RecordHdr r{};
+            r.token = meta.token;
+            r.type = meta.type;
+            r.market = meta.market;
+            r.exch_time = meta.exch_time;
+            r.len = static_cast<uint16_t>(csvLine.size());
+            std::memcpy(p, &r, sizeof(r));
+            std::memcpy(p + sizeof(r), csvLine.data(), csvLine.size());
+        }
+        else {
+            std::memcpy(p, csvLine.data(), csvLine.size());
+            p[csvLine.size()] = '\n';
+        }
+        if (!I->open_records) {
+            I->open_since = Clock::now();
+            wake = wake || I->sent_seq == I->open_seq;   // sender idle: start its flush_us clock
+        }
+        I->open_len += static_cast<uint32_t>(need);
+        ++I->open_records;
+        ++I->st.records;
+    }
+    if (wake) I->cv.notify_one();
+    return true;
+}
+
+McastPublisher::Stats McastPublisher::stats() const {
+    if (!impl_) return Stats{};
+    Impl* I = reinterpret_cast<Impl*>(impl_);
+    std::lock_guard<std::mutex> lk(I->mtx);
+    return I->st;
+}
+
+void McastPublisher::print_stats(std::ostream& os) const {
+    if (!impl_) return;
+    Impl* I = reinterpret_cast<Impl*>(impl_);
+    const Stats s = stats();
+    std::ostringstream ss;
+    ss << "[MCAST] " << I->cfg.group << ":" << I->cfg.port
+        << " format=" << (I->cfg.format == Format::Binary ? "binary" : "csv")
+        << " records=" << s.records << " datagrams=" << s.datagrams << " bytes=" << s.bytes
+        << " dropped=" << s.dropped << " oversize=" << s.oversize << " send_errors=" << s.send_errors
+        << " queue_hwm=" << s.queue_hwm << "/" << I->slots;
+    if (I->cfg.rate_bytes) ss << " paced_ms=" << s.paced_ms;
+    ss << "\n";
+    os << ss.str();
+}
+
+// ---------------- --mcast-read ----------------
+namespace {
+
+    std::atomic<bool> g_read_stop{ false };
+#ifdef _WIN32
+    BOOL WINAPI read_ctrl_handler(DWORD) { g_read_stop.store(true); return TRUE; }
+#else
+    void read_signal_handler(int) { g_read_stop.store(true); }
+#endif
+
+    inline int sock_error() {
+#ifdef _WIN32
+        return WSAGetLastError();
+#else
+        return errno;
+#endif
+    }
+    // the receive timeout expired (or the call was interrupted): worth another recv
+    inline bool recv_retry(int err) {
+#ifdef _WIN32
+        return err == WSAETIMEDOUT || err == WSAEWOULDBLOCK || err == WSAEINTR;
+#else
+        return err == EAGAIN || err == EWOULDBLOCK || err == EINTR;
+#endif
+    }
+
+    // UDP socket bound to port that joins group on iface (a unicast address is bound as is);
+    // blocking with a 200 ms receive timeout
+    static sock_t open_receiver(const std::string& group, uint16_t port, const std::string& iface) {
+        in_addr g{};
+        if (inet_pton(AF_INET, group.c_str(), &g) != 1) return INVALID_SOCK;
+        const uint32_t first = ntohl(g.s_addr) >> 24;
+        const bool multicast = first >= 224 && first <= 239;
+        sock_t s = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+        if (s == INVALID_SOCK) return s;
+
+        int on = 1;                             // several readers may share the port
+        setsockopt(s, SOL_SOCKET, SO_REUSEADDR, reinterpret_cast<const char*>(&on), sizeof(on));
+        int rcvbuf = 4 << 20;                   // best-effort: absorbs bursts while stdout blocks
+        setsockopt(s, SOL_SOCKET, SO_RCVBUF, reinterpret_cast<const char*>(&rcvbuf), sizeof(rcvbuf));
+
+        sockaddr_in a{};
+        a.sin_family = AF_INET;
+        a.sin_port = htons(port);
+#ifdef _WIN32
+        a.sin_addr.s_addr = multicast ? htonl(INADDR_ANY) : g.s_addr;   // Windows binds groups on any
+#else
+        a.sin_addr = g;                         // only this group's datagrams
+#endif
+        if (bind(s, reinterpret_cast<sockaddr*>(&a), sizeof(a)) != 0) { close_sock(s); return INVALID_SOCK; }
+        if (multicast) {
+            ip_mreq mr{};
+            mr.imr_multiaddr = g;
+            mr.imr_interface.s_addr = htonl(INADDR_ANY);
+            if (!iface.empty() && inet_pton(AF_INET, iface.c_str(), &mr.imr_interface) != 1) { close_sock(s); return INVALID_SOCK; }
+            if (setsockopt(s, IPPROTO_IP, IP_ADD_MEMBERSHIP, reinterpret_cast<const char*>(&mr), sizeof(mr)) != 0) {
+                close_sock(s);
+                return INVALID_SOCK;
+            }
+        }
+#ifdef _WIN32
+        DWORD tmo = 200;
+        setsockopt(s, SOL_SOCKET, SO_RCVTIMEO, reinterpret_cast<const char*>(&tmo), sizeof(tmo));
+#else
+        timeval tmo{ 0, 200000 };
+        setsockopt(s, SOL_SOCKET, SO_RCVTIMEO, &tmo, sizeof(tmo));
+#endif
+        return s;
+    }
+
+    // records of one datagram as CSV lines; false when they do not add up to the header
+    static bool decode_records(const McastPublisher::DatagramHdr& h, const char* p, size_t len, bool quiet, uint64_t& records) {
+        uint32_t n = 0;
+        if (h.format == static_cast<uint16_t>(McastPublisher::Format::Csv)) {
+            while (len) {
+                const char* nl = static_cast<const char*>(std::memchr(p, '\n', len));
+                if (!nl) return false;          // a record never spans datagrams
+                const size_t take = static_cast<size_t>(nl - p) + 1;
+                if (!quiet) std::cout.write(p, static_cast<std::streamsize>(take));
+                p += take;
+                len -= take;
+                ++n;
+            }
+        }
+        else {
+            while (len) {
+                McastPublisher::RecordHdr r;
+                if (len < sizeof(r)) return false;
+                std::memcpy(&r, p, sizeof(r));
+                if (len - sizeof(r) < r.len) return false;
+                if (!quiet) {
+                    std::cout.write(p + sizeof(r), r.len);
+                    std::cout.put('\n');
+                }
+                p += sizeof(r) + r.len;
+                len -= sizeof(r) + r.len;
+                ++n;
+            }
+        }
+        records += n;
+        return n == h.records;
+    }
+
+} // namespace anon
+
+int RunMcastRead(int argc, char* argv[]) {
+    std::string target, iface = "127.0.0.1";
+    bool quiet = false;
+    double secs = 0;
+    for (int i = 1; i < argc; ++i) {
+        std::string key = argv[i];
+        std::string val;
+        auto eq = key.find('=');
+        if (eq != std::string::npos) { val = key.substr(eq + 1); key = key.substr(0, eq); }
+        auto next = [&]() { if (val.empty() && i + 1 < argc) val = argv[++i]; return val; };
+        if (key == "--mcast-read") target = next();
+        else if (key == "--iface") iface = next();
+        else if (key == "--quiet") quiet = true;
+        else if (key == "--secs") {
+            try { secs = std::stod(next()); }
+            catch (...) { std::cerr << "[FATAL] invalid value for --secs: " << val << "\n"; return 1; }
+        }
+        else { std::cerr << "[FATAL] unknown mcast-read option " << key << "\n"; return 1; }
+    }
+    const size_t colon = target.rfind(':');
+    uint16_t port = 0;
+    if (colon != std::string::npos) {
+        try { port = static_cast<uint16_t>(std::stoi(target.substr(colon + 1))); }
+        catch (...) {}
+    }
+    if (!port) {
+        std::cerr << "[FATAL] --mcast-read needs <group|ip>:<port>\n";
+        return 1;
+    }
+    sock_t s = open_receiver(target.substr(0, colon), port, iface);
+    if (s == INVALID_SOCK) {
+        std::cerr << "[FATAL] cannot receive on " << target << " (iface " << iface << ")\n";
+        return 1;
+    }
+
+    // Ctrl-C ends the read with the totals (main's handler only stops the feed loop)
+#ifdef _WIN32
+    SetConsoleCtrlHandler(read_ctrl_handler, TRUE);
+#else
+    std::signal(SIGINT, read_signal_handler);
+    std::signal(SIGTERM, read_signal_handler);
+#endif
+
+    std::cout.unsetf(std::ios::unitbuf);   // main sets unitbuf for interactive logging
+    uint64_t datagrams = 0, records = 0, bytes = 0, bad = 0;
+    uint64_t lost = 0, gaps = 0, late = 0, sessions = 0;
+    uint32_t session = 0;
+    uint64_t expect = 0;                    // next seq in this session
+    int rc = 0;
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(static_cast<long long>(secs * 1000));
+    std::vector<char> buf(64 * 1024);
+    while (!g_read_stop.load() && (secs <= 0 || std::chrono::steady_clock::now() < deadline)) {
+        int n = static_cast<int>(recv(s, buf.data(), static_cast<int>(buf.size()), 0));
+        if (n < 0) {
+            const int err = sock_error();
+            if (recv_retry(err)) continue;  // receive timeout: check the deadline
+            std::cerr << "[READ] " << target << ": recv failed (error " << err
+#ifndef _WIN32
+                << ", " << std::strerror(err)
+#endif
+                << ")\n";
+            rc = 2;
+            break;
+        }
+        McastPublisher::DatagramHdr h;
+        if (static_cast<size_t>(n) < sizeof(h)) { ++bad; continue; }
+        std::memcpy(&h, buf.data(), sizeof(h));
+        if (h.magic != McastPublisher::kMagic || h.version != McastPublisher::kVersion ||
+            h.format > static_cast<uint16_t>(McastPublisher::Format::Binary)) { ++bad; continue; }
+        ++datagrams;
+        bytes += static_cast<uint64_t>(n);
+
+        // a new session id: the publisher restarted and counts from 0 again
+        if (!sessions || h.session != session) {
+            if (sessions) std::cerr << "[READ] " << target << ": session " << session << " -> " << h.session << " at seq " << h.seq << "\n";
+            ++sessions;
+            session = h.session;
+            expect = 0;
+        }
+        if (h.seq > expect) { ++gaps; lost += h.seq - expect; }
+        else if (h.seq < expect) ++late;    // reordered or duplicated on the way
+        expect = std::max(expect, h.seq + 1);
+
+        if (!decode_records(h, buf.data() + sizeof(h), static_cast<size_t>(n) - sizeof(h), quiet, records)) ++bad;
+    }
+    close_sock(s);
+    std::cout.flush();
+
+    std::ostringstream ss;
+    ss << "[READ] " << target << " datagrams=" << datagrams << " records=" << records << " bytes=" << bytes
+        << " lost=" << lost << " gaps=" << gaps << " late=" << late << " sessions=" << sessions << " bad=" << bad;
+    std::cerr << ss.str() << "\n";
+    return rc;
+}
@@ -0,0 +1,103 @@
+#pragma once
+// McastPublisher: republishes decoded records as UDP datagrams (--out mcast)
+// One decode feeds any number of subscribers on a multicast group (or one unicast address,
+// e.g. loopback) at constant cost. publish() packs records straight into fixed datagram slots
+// under a short lock; a sender thread sends sealed datagrams in order, paced by an optional
+// byte-rate cap, and seals a partial datagram after flush_us. Nothing waits on the network:
+// when the slots are full (rate cap, slow NIC) new records are dropped and counted.
+//
+// Datagram (little endian): [DatagramHdr 24 bytes][records]
+//   Csv:    each record is the CSV line followed by '\n'
+//   Binary: each record is [RecordHdr 16 bytes][CSV line without '\n']
+// seq counts datagrams from 0 per session: a receiver that sees a jump lost datagrams, and a
+// new session id means the publisher restarted. A record never spans datagrams.
+// See implementation in src/McastPublisher.cpp
+
+#include <string>
+#include <string_view>
+#include <ostream>
+#include <cstdint>
+
+#include "includes/record_meta.h"
+
+class McastPublisher {
+public:
+    enum class Format : uint16_t { Csv = 0, Binary = 1 };
+
+    static constexpr uint32_t kMagic = 0x434D5048u;     // "HPMC"
+    static constexpr uint16_t kVersion = 1;
+
+    struct DatagramHdr {
+        uint32_t magic;
+        uint16_t version;
+        uint16_t format;            // Format
+        uint64_t seq;               // datagram number within the session
+        uint32_t records;
+        uint32_t session;           // changes on every start()
+    };
+
+    struct RecordHdr {
+        uint32_t token;
+        uint16_t type;
+        uint16_t market;
+        uint32_t exch_time;
+        uint16_t len;               // CSV bytes that follow
+        uint16_t reserved;
+    };
+
+    static_assert(sizeof(DatagramHdr) == 24, "McastPublisher::DatagramHdr must be 24 bytes");
+    static_assert(sizeof(RecordHdr) == 16, "McastPublisher::RecordHdr must be 16 bytes");
+
+    struct Config {
+        std::string group = "239.255.0.1";      // multicast group, or a unicast address (127.0.0.1)
+        uint16_t port = 0;                      // required
+        std::string iface = "127.0.0.1";        // outgoing interface for multicast (IP_MULTICAST_IF)
+        int ttl = 0;                            // 0 => this host only, 1 => local subnet
+        bool loop = true;                       // IP_MULTICAST_LOOP: deliver to subscribers on this host
+        Format format = Format::Csv;
+        size_t datagram_bytes = 1472;           // UDP payload incl. header (1500-byte MTU minus IP/UDP)
+        unsigned flush_us = 1000;               // a partial datagram goes out after this
+        uint64_t rate_bytes = 0;                // send cap in bytes/s (0 => none)
+        size_t queue_bytes = 8 << 20;           // datagram slots; records are dropped when all are full
+        bool verbose = false;
+    };
+
+    struct Stats {
+        uint64_t records = 0;                   // packed into datagrams
+        uint64_t datagrams = 0;                 // sent
+        uint64_t bytes = 0;                     // UDP payload bytes sent
+        uint64_t dropped = 0;                   // records rejected: slots full
+        uint64_t oversize = 0;                  // records rejected: larger than a datagram
+        uint64_t send_errors = 0;               // datagrams the socket refused
+        uint64_t queue_hwm = 0;                 // most sealed datagrams waiting
+        uint64_t paced_ms = 0;                  // time the rate cap held the sender back
+    };
+
+    explicit McastPublisher(const Config& cfg);
+    ~McastPublisher();
+
+    // open the socket and start the sender thread (throws on socket error)
+    void start();
+
+    // send what is queued and stop the sender thread
+    void stop();
+
+    // pack one CSV line (any thread). false when it was dropped (see Stats).
+    bool publish(const RecordMeta& meta, std::string_view csvLine);
+
+    Stats stats() const;
+    void print_stats(std::ostream& os) const;
+
+private:
+    void* impl_; // opaque pointer to implementation
+
+    McastPublisher(const McastPublisher&) = delete;
+    McastPublisher& operator=(const McastPublisher&) = delete;
+};
+
+// HermesPortal --mcast-read <group|ip>:<port> [--iface <ip>] [--secs <n>] [--quiet]
+//   reference receiver for --out mcast: joins the group on iface (default 127.0.0.1), checks
+//   each datagram's magic / version, decodes Csv and Binary records to CSV lines on stdout and
+//   counts seq gaps (lost datagrams) and session changes (publisher restarts) on stderr.
+//   Runs for secs (0: until Ctrl-C). Returns the process exit code.
+int RunMcastRead(int argc, char* argv[]);
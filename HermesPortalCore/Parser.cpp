@@ -1,5 +1,6 @@
 // Parser.cpp
 #include "includes/hermes_core.h"
+#include "DecodePool.h"
 #include <vector>
 #include <fstream>
 #include <cstdio>
@@ -58,7 +59,8 @@ void PacketParser::parse(const char* buf, int len, ConsoleSink& out,
         if (base >= 0 && code != 0) {
             MessageView mv{ dst, dst_len };
             if (auto* h = disp_.find(static_cast<uint16_t>(code))) {
-                h->handle(mv, out, instDir, strikes);
+                if (pool_) pool_->submitFO(h, base, dst, dst_len);
+                else h->handle(mv, out, instDir, strikes);
             }
         }
     }
@@ -130,7 +132,8 @@ void PacketParser::parseCM(const uint8_t* buf, size_t len, ConsoleSink& out,
 
             MessageView mv{ proc + pos, static_cast<int>(iLen) };
             if (auto* h = disp_.find(iCode)) {
-                h->handle(mv, out, instDir, strikes);
+                if (pool_) pool_->submitCM(h, mv.buf, mv.len);
+                else h->handle(mv, out, instDir, strikes);
             }
             pos += iLen;
         }
@@ -284,7 +287,8 @@ void PacketParser::parseCM(const uint8_t* buf, size_t len, ConsoleSink& out,
         // dispatch: construct MessageView with pointer to header start (so handlers can detect offsets themselves)
         MessageView mv{ reinterpret_cast<const char*>(proc_ptr + pos), static_cast<int>(rec_total) };
         if (auto* h = disp_.find(iCode)) {
-            h->handle(mv, out, instDir, strikes);
+            if (pool_) pool_->submitCM(h, mv.buf, mv.len);
+            else h->handle(mv, out, instDir, strikes);
         }
         else {
             if (g_cm_debug) {
@@ -0,0 +1,154 @@
+// src/Sinks.cpp
+// Sink registry behind ConsoleSink::sendLine (see hermes_core.h).
+// Fixed slot table + switch over concrete sink types: no std::function, no per-line allocation.
+
+#include "includes/hermes_core.h"
+#include "FileWriter.h"
+#include "SocketRelay.h"
+#include "McastPublisher.h"
+#include "AsyncConsole.h"
+#include "XMemoryRing.hpp"
+
+#include <atomic>
+#include <mutex>
+
+namespace {
+
+    struct Slot {
+        SinkKind kind = SinkKind::Console;
+        void* target = nullptr;
+        bool single_producer = false;           // needs serializing when several lanes write
+        std::mutex mtx;
+        std::atomic<uint64_t> rejected{ 0 };
+    };
+
+    static Slot g_slots[ConsoleSink::kMaxSinks];
+    static size_t g_count = 0;
+
+    static const char* kind_name(SinkKind k) {
+        switch (k) {
+        case SinkKind::Console: return "console";
+        case SinkKind::Shm:     return "shm";
+        case SinkKind::File:    return "file";
+        case SinkKind::Socket:  return "socket";
+        case SinkKind::Mcast:   return "mcast";
+        }
+        return "?";
+    }
+
+    static bool add_slot(SinkKind kind, void* target, bool single_producer) {
+        if (g_count >= ConsoleSink::kMaxSinks) return false;
+        for (size_t i = 0; i < g_count; ++i) {
+            if (g_slots[i].kind == kind) return false; // one of each kind
+        }
+        Slot& s = g_slots[g_count];
+        s.kind = kind;
+        s.target = target;
+        s.single_producer = single_producer;
+        s.rejected.store(0, std::memory_order_relaxed);
+        ++g_count;
+        return true;
+    }
+
+    static inline bool deliver(Slot& s, std::string_view line, const RecordMeta& meta) {
+        switch (s.kind) {
+        case SinkKind::Console:
+            return static_cast<AsyncConsole*>(s.target)->write(line);
+        case SinkKind::Shm:
+            return static_cast<xmr::Writer*>(s.target)->write(
+                reinterpret_cast<const uint8_t*>(line.data()), line.size());
+        case SinkKind::File:
+            return static_cast<FileWriter*>(s.target)->enqueue(meta, line);
+        case SinkKind::Socket:
+            return static_cast<SocketRelay*>(s.target)->notify(meta, line);
+        case SinkKind::Mcast:
+            return static_cast<McastPublisher*>(s.target)->publish(meta, line);
+        }
+        return false;
+    }
+
+} // namespace anon
+
+void ConsoleSink::sendLine(std::string_view line, const RecordMeta& meta) {
+    const bool serialize = s_serialized;
+    for (size_t i = 0; i < g_count; ++i) {
+        Slot& s = g_slots[i];
+        bool ok;
+        if (serialize && s.single_producer) {
+            std::lock_guard<std::mutex> lk(s.mtx);
+            ok = deliver(s, line, meta);
+        }
+        else {
+            ok = deliver(s, line, meta);
+        }
+        if (!ok) s.rejected.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+bool ConsoleSink::addConsole(AsyncConsole& con) {
+    // the ring is multi-producer and never blocks: a full buffer drops the line
+    if (!add_slot(SinkKind::Console, &con, false)) return false;
+    s_consoleMirror = true;
+    return true;
+}
+
+bool ConsoleSink::addShm(xmr::Writer& w) {
+    return add_slot(SinkKind::Shm, &w, true);
+}
+
+bool ConsoleSink::addFile(FileWriter& fw) {
+    return add_slot(SinkKind::File, &fw, false);
+}
+
+bool ConsoleSink::addSocket(SocketRelay& relay) {
+    return add_slot(SinkKind::Socket, &relay, false);
+}
+
+bool ConsoleSink::addMcast(McastPublisher& pub) {
+    return add_slot(SinkKind::Mcast, &pub, false);
+}
+
+void ConsoleSink::clearSinks() {
+    g_count = 0;
+    s_consoleMirror = false;
+}
+
+size_t ConsoleSink::sinkCount() {
+    return g_count;
+}
+
+void ConsoleSink::printSinks(std::ostream& os) {
+    std::ostringstream ss;
+    for (size_t i = 0; i < g_count; ++i) {
+        const Slot& s = g_slots[i];
+        if (i) ss << ' ';
+        ss << kind_name(s.kind);
+    }
+    if (!g_count) ss << "<none>";
+    os << ss.str();
+}
+
+void ConsoleSink::printSinkStats(std::ostream& os) {
+    std::ostringstream ss;
+    for (size_t i = 0; i < g_count; ++i) {
+        const Slot& s = g_slots[i];
+        ss << "[SINK] " << kind_name(s.kind) << " rejected=" << s.rejected.load(std::memory_order_relaxed) << "\n";
+    }
+    os << ss.str();
+}
+
+const char* ConsoleSink::policyName(BackPressure p) {
+    switch (p) {
+    case BackPressure::DropNewest: return "drop-newest";
+    case BackPressure::DropOldest: return "drop-oldest";
+    case BackPressure::Block:      return "block";
+    }
+    return "?";
+}
+
+bool ConsoleSink::parsePolicy(const std::string& s, BackPressure& out) {
+    if (s == "drop-newest") { out = BackPressure::DropNewest; return true; }
+    if (s == "drop-oldest") { out = BackPressure::DropOldest; return true; }
+    if (s == "block") { out = BackPressure::Block; return true; }
+    return false;
+}
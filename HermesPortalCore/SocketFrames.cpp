@@ -0,0 +1,261 @@
+// src/SocketFrames.cpp
+// LZO batch framing for the socket protocol and the reference client (see SocketFrames.h).
+
+#include "SocketFrames.h"
+#include "includes/hermes_core.h"
+
+#include <chrono>
+#include <iostream>
+#include <sstream>
+#include <algorithm>
+#include <cstring>
+#include <cerrno>
+
+#ifndef _WIN32
+#include <netdb.h>
+#include <sys/un.h>
+#include <sys/time.h>
+#endif
+
+namespace SocketFrames {
+
+    // ----------------- Encoder -----------------
+    Encoder::Encoder() : wrk_(Lzo::CompressWorkMem()) {}
+
+    void Encoder::seal(std::string_view raw, uint32_t lines, uint64_t first_seq, uint64_t last_seq,
+        uint32_t flags, std::string& out) {
+        FrameHdr h{};
+        h.magic = kMagic;
+        h.flags = flags;
+        h.raw_len = static_cast<uint32_t>(raw.size());
+        h.lines = lines;
+        h.first_seq = first_seq;
+        h.last_seq = last_seq;
+
+        const size_t at = out.size();
+        out.resize(at + sizeof(FrameHdr) + Lzo::CompressBound(raw.size()));
+        unsigned char* payload = reinterpret_cast<unsigned char*>(&out[at + sizeof(FrameHdr)]);
+        const unsigned char* src = reinterpret_cast<const unsigned char*>(raw.data());
+        size_t clen = 0;
+        if (Lzo::Compress1X(src, raw.size(), payload, out.size() - at - sizeof(FrameHdr), clen, wrk_.data()) && clen < raw.size()) {
+            h.stored_len = static_cast<uint32_t>(clen);
+        }
+        else {
+            std::memcpy(payload, src, raw.size());
+            h.stored_len = h.raw_len;
+            h.flags |= kFlagStored;
+        }
+        out.resize(at + sizeof(FrameHdr) + h.stored_len);
+        std::memcpy(&out[at], &h, sizeof(h));
+    }
+
+    // ----------------- Decoder -----------------
+    void Decoder::feed(const char* p, size_t n) {
+        if (off_ == buf_.size()) { buf_.clear(); off_ = 0; }
+        else if (off_ > (1u << 20)) { buf_.erase(0, off_); off_ = 0; }
+        buf_.append(p, n);
+        wire_ += n;
+    }
+
+    int Decoder::next(FrameHdr& hdr, std::string_view& raw) {
+        if (buf_.size() - off_ < sizeof(FrameHdr)) return 0;
+        std::memcpy(&hdr, buf_.data() + off_, sizeof(hdr));
+        if (hdr.magic != kMagic || hdr.raw_len == 0 || hdr.raw_len > kMaxRaw) return -1;
+        if (buf_.size() - off_ - sizeof(FrameHdr) < hdr.stored_len) return 0;
+        const char* payload = buf_.data() + off_ + sizeof(FrameHdr);
+        if (hdr.flags & kFlagStored) {
+            if (hdr.stored_len != hdr.raw_len) return -1;
+            raw = std::string_view(payload, hdr.raw_len);
+        }
+        else {
+            out_.resize(hdr.raw_len);
+            size_t got = 0;
+            if (!Lzo::Decompress1X(reinterpret_cast<const unsigned char*>(payload), hdr.stored_len,
+                out_.data(), out_.size(), got) || got != hdr.raw_len) return -1;
+            raw = std::string_view(reinterpret_cast<const char*>(out_.data()), got);
+        }
+        off_ += sizeof(FrameHdr) + hdr.stored_len;
+        raw_ += hdr.raw_len;
+        ++frames_;
+        return 1;
+    }
+
+} // namespace SocketFrames
+
+namespace {
+
+#ifdef _WIN32
+    using sock_t = SOCKET;
+    static const sock_t INVALID_SOCK = INVALID_SOCKET;
+    inline void close_sock(sock_t s) { closesocket(s); }
+    inline int sock_error() { return WSAGetLastError(); }
+    // the receive timeout expired (or the call was interrupted): worth another recv
+    inline bool recv_retry(int err) { return err == WSAETIMEDOUT || err == WSAEWOULDBLOCK || err == WSAEINTR; }
+#else
+    using sock_t = int;
+    static const sock_t INVALID_SOCK = -1;
+    inline void close_sock(sock_t s) { close(s); }
+    inline int sock_error() { return errno; }
+    inline bool recv_retry(int err) { return err == EAGAIN || err == EWOULDBLOCK || err == EINTR; }
+#endif
+
+    // "host:port" (TCP) or "unix:<path>" (POSIX); blocking socket with a 200 ms receive timeout
+    static sock_t connect_to(const std::string& target) {
+        sock_t s = INVALID_SOCK;
+        if (target.rfind("unix:", 0) == 0) {
+#ifndef _WIN32
+            sockaddr_un a{};
+            a.sun_family = AF_UNIX;
+            const std::string path = target.substr(5);
+            if (path.empty() || path.size() >= sizeof(a.sun_path)) return INVALID_SOCK;
+            std::memcpy(a.sun_path, path.c_str(), path.size() + 1);
+            s = socket(AF_UNIX, SOCK_STREAM, 0);
+            if (s != INVALID_SOCK && connect(s, reinterpret_cast<sockaddr*>(&a), sizeof(a)) != 0) { close_sock(s); s = INVALID_SOCK; }
+#endif
+        }
+        else {
+            const size_t colon = target.rfind(':');
+            if (colon == std::string::npos) return INVALID_SOCK;
+            addrinfo hints{};
+            hints.ai_family = AF_UNSPEC;
+            hints.ai_socktype = SOCK_STREAM;
+            addrinfo* res = nullptr;
+            if (getaddrinfo(target.substr(0, colon).c_str(), target.substr(colon + 1).c_str(), &hints, &res) != 0) return INVALID_SOCK;
+            for (addrinfo* ai = res; ai && s == INVALID_SOCK; ai = ai->ai_next) {
+                s = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+                if (s != INVALID_SOCK && connect(s, ai->ai_addr, static_cast<int>(ai->ai_addrlen)) != 0) { close_sock(s); s = INVALID_SOCK; }
+            }
+            freeaddrinfo(res);
+        }
+        if (s == INVALID_SOCK) return s;
+#ifdef _WIN32
+        DWORD tmo = 200;
+        setsockopt(s, SOL_SOCKET, SO_RCVTIMEO, reinterpret_cast<const char*>(&tmo), sizeof(tmo));
+#else
+        timeval tmo{ 0, 200000 };
+        setsockopt(s, SOL_SOCKET, SO_RCVTIMEO, &tmo, sizeof(tmo));
+#endif
+        return s;
+    }
+
+} // namespace
+
+int RunSocketRead(int argc, char* argv[]) {
+    std::string target, token;
+    std::vector<std::string> cmds;
+    bool lzo = false, quiet = false;
+    double secs = 0;
+    for (int i = 1; i < argc; ++i) {
+        std::string key = argv[i];
+        std::string val;
+        auto eq = key.find('=');
+        if (eq != std::string::npos) { val = key.substr(eq + 1); key = key.substr(0, eq); }
+        auto next = [&]() { if (val.empty() && i + 1 < argc) val = argv[++i]; return val; };
+        if (key == "--socket-read") target = next();
+        else if (key == "--socket-token") token = next();
+        else if (key == "--cmd") cmds.push_back(next());
+        else if (key == "--lzo") lzo = true;
+        else if (key == "--quiet") quiet = true;
+        else if (key == "--secs") {
+            try { secs = std::stod(next()); }
+            catch (...) { std::cerr << "[FATAL] invalid value for --secs: " << val << "\n"; return 1; }
+        }
+        else { std::cerr << "[FATAL] unknown socket-read option " << key << "\n"; return 1; }
+    }
+    if (target.empty()) {
+        std::cerr << "[FATAL] --socket-read needs <host:port> or unix:<path>\n";
+        return 1;
+    }
+    if (lzo && !Lzo::Init()) {
+        std::cerr << "[FATAL] LZO init failed\n";
+        return 1;
+    }
+    sock_t s = connect_to(target);
+    if (s == INVALID_SOCK) {
+        std::cerr << "[FATAL] cannot connect to " << target << "\n";
+        return 1;
+    }
+
+    // everything in one write: FORMAT must arrive before the relay sends stream bytes
+    std::string hello = token.empty() ? "AUTH\n" : "AUTH " + token + "\n";
+    if (lzo) hello += "FORMAT lzo\n";
+    for (const std::string& c : cmds) hello += c + "\n";
+    send(s, hello.data(), static_cast<int>(hello.size()), 0);
+
+    std::cout.unsetf(std::ios::unitbuf);   // main sets unitbuf for interactive logging
+    SocketFrames::Decoder dec;
+    std::string head;                       // text until the stream starts
+    size_t replies = lzo ? 2 : 1;           // "OK" [+ "OK lzo"]
+    uint64_t lines = 0, wire = 0, last_seq = 0;
+    bool have_seq = false;
+    int rc = 0;
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(static_cast<long long>(secs * 1000));
+    std::vector<char> buf(256 * 1024);
+    while (rc == 0 && (secs <= 0 || std::chrono::steady_clock::now() < deadline)) {
+        int n = static_cast<int>(recv(s, buf.data(), static_cast<int>(buf.size()), 0));
+        if (n == 0) break;
+        if (n < 0) {
+            const int err = sock_error();
+            if (recv_retry(err)) continue;  // receive timeout: check the deadline
+            std::cerr << "[READ] " << target << ": recv failed (error " << err
+#ifndef _WIN32
+                << ", " << std::strerror(err)
+#endif
+                << ")\n";
+            rc = 2;
+            break;
+        }
+        wire += static_cast<uint64_t>(n);
+        const char* p = buf.data();
+        size_t len = static_cast<size_t>(n);
+        while (replies && len) {
+            const char* nl = static_cast<const char*>(std::memchr(p, '\n', len));
+            const size_t take = nl ? static_cast<size_t>(nl - p) + 1 : len;
+            head.append(p, take);
+            p += take;
+            len -= take;
+            if (!nl) break;
+            if (head.rfind("OK", 0) != 0) {
+                std::cerr << "[READ] " << target << ": " << head;
+                rc = 2;
+                break;
+            }
+            head.clear();
+            --replies;
+        }
+        if (rc || !len) continue;
+        if (!lzo) {
+            lines += static_cast<uint64_t>(std::count(p, p + len, '\n'));
+            if (!quiet) std::cout.write(p, static_cast<std::streamsize>(len));
+            continue;
+        }
+        dec.feed(p, len);
+        SocketFrames::FrameHdr h;
+        std::string_view raw;
+        int r;
+        while ((r = dec.next(h, raw)) > 0) {
+            if (!(h.flags & SocketFrames::kFlagText)) {
+                lines += h.lines;
+                last_seq = h.last_seq;
+                have_seq = true;
+            }
+            if (!quiet) std::cout.write(raw.data(), static_cast<std::streamsize>(raw.size()));
+        }
+        if (r < 0) {
+            std::cerr << "[READ] " << target << ": corrupt frame after " << dec.frames() << " frames\n";
+            rc = 2;
+        }
+    }
+    close_sock(s);
+    std::cout.flush();
+
+    std::ostringstream ss;
+    ss << std::fixed << std::setprecision(1) << "[READ] " << target << " lines=" << lines << " wire=" << wire;
+    if (lzo) {
+        ss << " frames=" << dec.frames() << " raw=" << dec.raw_bytes()
+            << " ratio=" << (dec.wire_bytes() ? static_cast<double>(dec.raw_bytes()) / dec.wire_bytes() : 0.0);
+        if (have_seq) ss << " last_seq=" << last_seq;
+    }
+    std::cerr << ss.str() << "\n";
+    return rc;
+}
@@ -0,0 +1,81 @@
+#pragma once
+// SocketFrames: LZO batch framing for SocketRelay clients that negotiate "FORMAT lzo"
+// After "OK lzo\n" the stream is a sequence of frames (little endian):
+//   [FrameHdr 40 bytes][payload]...[FrameHdr][payload]
+//   payload = LZO1X-1(raw), or raw itself when kFlagStored is set (incompressible batch)
+//   raw     = CSV lines, each ending with '\n'
+// A data frame carries ring lines first_seq..last_seq; a filtered client gets only the lines
+// its SUB/TYPES select from that range (lines = how many). kFlagText frames carry what the
+// text protocol sends outside the stream (#SNAPSHOT and its lines, #LIVE, #RESUME, #GAP);
+// their seq fields are 0. To resume, send "RESUME <last_seq + 1>" for the last data frame.
+// The relay encodes a frame once on its loop thread; clients that take every line and sit
+// at the same cursor are sent the same bytes.
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+namespace SocketFrames {
+
+    constexpr uint32_t kMagic = 0x42465048u;        // "HPFB"
+    constexpr uint32_t kFlagStored = 1u;            // payload is the raw batch
+    constexpr uint32_t kFlagText = 2u;              // protocol lines, not ring lines
+    constexpr uint32_t kMaxRaw = 64u << 20;         // decoder sanity limit
+
+    struct FrameHdr {
+        uint32_t magic;
+        uint32_t flags;
+        uint32_t raw_len;
+        uint32_t stored_len;        // payload bytes following this header
+        uint32_t lines;
+        uint32_t reserved;
+        uint64_t first_seq;         // ring sequence numbers of the first / last line
+        uint64_t last_seq;
+    };
+
+    static_assert(sizeof(FrameHdr) == 40, "SocketFrames::FrameHdr must be 40 bytes");
+
+    // Owns the LZO work memory, so one per thread.
+    class Encoder {
+    public:
+        Encoder();
+
+        // Append raw (non-empty, whole lines) to out as one frame.
+        void seal(std::string_view raw, uint32_t lines, uint64_t first_seq, uint64_t last_seq,
+            uint32_t flags, std::string& out);
+
+    private:
+        std::vector<unsigned char> wrk_;
+    };
+
+    // Incremental decoder: feed() bytes as they arrive, then call next() until it returns 0.
+    class Decoder {
+    public:
+        void feed(const char* p, size_t n);
+
+        // Next complete frame: 1 with hdr and its lines in raw (valid until the next feed()
+        // or next()), 0 when more bytes are needed, -1 on a corrupt stream.
+        int next(FrameHdr& hdr, std::string_view& raw);
+
+        uint64_t frames() const { return frames_; }
+        uint64_t wire_bytes() const { return wire_; }  // fed so far
+        uint64_t raw_bytes() const { return raw_; }    // decoded so far
+
+    private:
+        std::string buf_;
+        size_t off_ = 0;
+        std::vector<unsigned char> out_;
+        uint64_t frames_ = 0, wire_ = 0, raw_ = 0;
+    };
+
+} // namespace SocketFrames
+
+// HermesPortal --socket-read <host:port|unix:path> [--socket-token <token>] [--lzo]
+//                [--cmd "<line>"]... [--secs <n>] [--quiet]
+//   reference client: AUTH, the given commands (SUB ..., RESUME ...), then the stream as CSV on
+//   stdout (frames decoded with --lzo) and wire / raw byte totals on stderr when it ends.
+//   A receive error other than the timeout (reset, not connected, ...) ends it with rc 2.
+//   Returns the process exit code.
+int RunSocketRead(int argc, char* argv[]);
@@ -1,20 +1,70 @@
 // src/SocketRelay.cpp
-// Implementation for SocketRelay (HermesPortal v1.4.1)
+// Implementation for SocketRelay (multi-client event loop)
 // Uses opaque impl_ pointer in header to avoid nested-private-access issues.
+//
+// One thread owns every socket: the listener, clients in the AUTH handshake and live
+// clients. notify() copies the line once into the broadcast ring under a short lock and
+// wakes the loop (eventfd on Linux, a self-connected UDP socket elsewhere) when a client was
+// caught up. The loop writes each client's span of the ring with writev until the socket
+// would block; then it waits for writability (EPOLLOUT / POLLOUT) for that client only.
+//
+// The ring holds whole lines: line n is bytes [start(n), index[n].end) of data (wrapping),
+// and lines [tail_seq, head_seq) are retained. index[n] also carries the line's token and
+// type, so each client's SUB/TYPES filter is applied while its span is gathered: lines it
+// did not ask for are stepped over and never reach its socket.
+// notify() evicts the tail to make room (moving cursors that sit on it), except a span a
+// client is sending from right now (its pin); then the new line is rejected instead.
+// A send that stops inside a line copies the rest of that line into the client's pending
+// buffer, so a client never depends on ring bytes once its cursor has passed them.
+//
+// The relay also keeps the latest line per (token, type) in a fixed slot table, updated by
+// notify() even with nobody connected. Right after AUTH (and the commands that came with it)
+// a client gets "#SNAPSHOT <n>", the n latest lines its filter selects, then "#LIVE <seq>"
+// and the stream. The snapshot is taken under the same lock that places its cursor at ring
+// line seq, so every update is in exactly one of the two.
+//
+// Ring line numbers double as the stream's sequence numbers. A client that sent SEQ gets
+// "<seq> " in front of every line (an extra span per line from a stack buffer; the ring is
+// not touched), and after a reconnect "RESUME <seq>" moves its cursor back to that line
+// while the ring still holds it. With cfg.retain_bytes the ring keeps filling while nobody
+// is connected, so a lone consumer can also resume across its own drop.
+//
+// A client that negotiates FORMAT lzo gets SocketFrames batches instead of text. The loop
+// copies a run of ring lines out under the lock and compresses it outside it; a frame that
+// takes every line is kept by its first seq, so the next client at that cursor sends the
+// same bytes. Frames are cut at the cursors of the other such clients (so they stay on frame
+// boundaries), and one short of cfg.frame_bytes waits up to cfg.frame_linger_ms for more lines.
+//
+// The listener is TCP or, for local consumers, AF_UNIX (stream or SOCK_SEQPACKET). On
+// seqpacket every message carries whole lines (a gathered span, or a snapshot chunk cut at a
+// newline): sends are atomic, so a reader never reassembles a line. A Unix peer whose uid
+// (SO_PEERCRED / getpeereid) is cfg.allow_uid passes AUTH without the token.
+//
+// Large sends may use MSG_ZEROCOPY (Linux): the kernel then reads the ring pages until the
+// completion arrives on the socket error queue, so the pin stays on the oldest such send
+// until then. The first completion the kernel reports as copied (loopback) turns zerocopy off
+// for that client. A client whose zerocopy pin is still on the tail when notify() needs the
+// room (the peer stopped reading, so the completion never comes) is disconnected by the loop
+// as soon as notify() wakes it, evict_* or not. Clients that stay behind too long or queue
+// too many unsent bytes are evicted (disconnected) too.
 
 #include "SocketRelay.h"
+#include "SocketFrames.h"
 
 #include <thread>
 #include <mutex>
-#include <condition_variable>
-#include <deque>
 #include <vector>
+#include <map>
+#include <memory>
 #include <string>
 #include <iostream>
+#include <sstream>
 #include <chrono>
 #include <cstring>
 #include <stdexcept>
 #include <algorithm>
+#include <cstdio>
+#include <cstdlib>
 
 #ifdef _WIN32
 #ifndef NOMINMAX
@@ -23,6 +73,7 @@
 #define WIN32_LEAN_AND_MEAN
 #include <winsock2.h>
 #include <ws2tcpip.h>
+#include <deque>
 #pragma comment(lib, "Ws2_32.lib")
 using sock_t = SOCKET;
 static const sock_t INVALID_SOCK = INVALID_SOCKET;
@@ -33,12 +84,198 @@ static const sock_t INVALID_SOCK = INVALID_SOCKET;
 #include <arpa/inet.h>
 #include <unistd.h>
 #include <netdb.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/uio.h>
+#include <sys/un.h>
+#include <cerrno>
+#include <deque>
+#ifdef __linux__
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/ioctl.h>
+#include <netinet/tcp.h>
+#include <linux/errqueue.h>
+#include <linux/sockios.h>
+#ifndef SO_ZEROCOPY
+#define SO_ZEROCOPY 60
+#endif
+#ifndef MSG_ZEROCOPY
+#define MSG_ZEROCOPY 0x4000000
+#endif
+#ifndef SO_EE_ORIGIN_ZEROCOPY
+#define SO_EE_ORIGIN_ZEROCOPY 5
+#endif
+#ifndef SO_EE_CODE_ZEROCOPY_COPIED
+#define SO_EE_CODE_ZEROCOPY_COPIED 1
+#endif
+#else
+#include <netinet/tcp.h>
+#endif
 using sock_t = int;
 static const sock_t INVALID_SOCK = -1;
 #endif
 
 namespace {
 
+    using Clock = std::chrono::steady_clock;
+
+#if defined(__linux__)
+    static constexpr int kSendFlags = MSG_NOSIGNAL;
+    static constexpr int MSG_ZEROCOPY_FLAG = MSG_ZEROCOPY;
+#else
+    static constexpr int kSendFlags = 0;
+    static constexpr int MSG_ZEROCOPY_FLAG = 0;
+#endif
+
+    static constexpr size_t kMaxSpans = 64;     // iovecs per send (a stamped line takes 2-3)
+    static constexpr uint64_t kScanLines = 4096;// ring lines looked at per gather (bounds the lock)
+    static constexpr uint32_t kMaxToken = 1u << 24;
+
+    // Per-client selection: tokens (bitmap) and message types. A bitmap of subscribed
+    // tokens (Include) or of unsubscribed ones (Exclude, the initial state: everything).
+    // The first SUB of a fresh client switches it to Include (only what it names).
+    struct Filter {
+        bool fresh = true;
+        bool exclude = true;
+        std::vector<uint64_t> bits;             // grown to the largest token named
+        std::vector<uint16_t> types;            // empty => all types
+
+        bool has(uint32_t token) const {
+            return token / 64 < bits.size() && ((bits[token / 64] >> (token % 64)) & 1);
+        }
+        void set(uint32_t token, bool on) {
+            if (token >= kMaxToken) return;
+            if (token / 64 >= bits.size()) {
+                if (!on) return;
+                bits.resize(token / 64 + 1, 0);
+            }
+            if (on) bits[token / 64] |= uint64_t(1) << (token % 64);
+            else bits[token / 64] &= ~(uint64_t(1) << (token % 64));
+        }
+        bool match(uint32_t token, uint16_t type) const {
+            if (!types.empty() && std::find(types.begin(), types.end(), type) == types.end()) return false;
+            return has(token) != exclude;
+        }
+        // selects every line (frames can be shared)
+        bool everything() const {
+            return exclude && types.empty() && std::all_of(bits.begin(), bits.end(), [](uint64_t b) { return b == 0; });
+        }
+    };
+
+    // Latest line per (token, type): open addressing (Fibonacci hash, linear probe) over
+    // fixed-size slots, so an update is a memcpy. Lines longer than a slot are not kept.
+    // put() runs under clients_mtx; a snapshot is copied without it, so each slot carries a
+    // seqlock and the ring position its line ended at (see send_snapshot).
+    struct SnapTable {
+        struct Slot {
+            uint64_t key;                       // 0 = empty
+            uint64_t seq;                       // head_seq right after the line was stored
+            uint32_t len;
+            uint32_t ver;                       // seqlock: odd while put() writes the slot
+        };
+        static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t), "atomic<uint32_t> must be plain-sized");
+        static std::atomic<uint32_t>* as_atomic(uint32_t* p) { return reinterpret_cast<std::atomic<uint32_t>*>(p); }
+        std::vector<char> mem;
+        size_t slot_bytes = 0;
+        size_t count = 0;                       // power of two; 0 => disabled
+        size_t used = 0;
+        uint64_t misses = 0;                    // table full or line too long
+
+        static uint64_t key_of(uint32_t token, uint16_t type) {
+            return (static_cast<uint64_t>(token) << 16 | type) | (uint64_t(1) << 63);
+        }
+        Slot* slot(size_t i) { return reinterpret_cast<Slot*>(mem.data() + i * slot_bytes); }
+        const Slot* slot(size_t i) const { return reinterpret_cast<const Slot*>(mem.data() + i * slot_bytes); }
+
+        void init(size_t slots, size_t bytes) {
+            count = 0;
+            if (slots) for (count = 1; count < slots && count < (size_t(1) << 24); count <<= 1) {}
+            slot_bytes = (std::max<size_t>(bytes, sizeof(Slot) + 64) + 7) & ~size_t(7);
+            mem.assign(count * slot_bytes, 0);
+            used = 0;
+            misses = 0;
+        }
+        // line without its newline; seq = head_seq once the line is in the ring
+        void put(uint32_t token, uint16_t type, std::string_view line, uint64_t seq) {
+            if (!count) return;
+            if (line.size() > slot_bytes - sizeof(Slot)) { ++misses; return; }
+            const uint64_t key = key_of(token, type);
+            size_t i = static_cast<size_t>((key * 0x9E3779B97F4A7C15ull) >> 32) & (count - 1);
+            for (size_t probe = 0; probe < count; ++probe, i = (i + 1) & (count - 1)) {
+                Slot* sl = slot(i);
+                if (sl->key != key && sl->key != 0) continue;
+                std::atomic<uint32_t>* ver = as_atomic(&sl->ver);
+                const uint32_t v = ver->load(std::memory_order_relaxed);
+                ver->store(v + 1, std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_release);
+                if (sl->key == 0) { sl->key = key; ++used; }
+                sl->seq = seq;
+                sl->len = static_cast<uint32_t>(line.size());
+                std::memcpy(sl + 1, line.data(), line.size());
+                ver->store(v + 2, std::memory_order_release);
+                return;
+            }
+            ++misses;
+        }
+        // Without clients_mtx: fn(token, type, line) for every slot whose line is in the ring
+        // before upto (or was stored with nobody connected). A slot being written or rewritten
+        // meanwhile holds a line from upto on: it is skipped, the stream carries it.
+        template <class Fn>
+        void for_each_before(uint64_t upto, std::string& line, Fn&& fn) {
+            for (size_t i = 0; i < count; ++i) {
+                Slot* sl = slot(i);
+                std::atomic<uint32_t>* ver = as_atomic(&sl->ver);
+                const uint32_t v = ver->load(std::memory_order_acquire);
+                if (v & 1u) continue;
+                const uint64_t key = sl->key, seq = sl->seq;
+                const uint32_t len = std::min<uint32_t>(sl->len, static_cast<uint32_t>(slot_bytes - sizeof(Slot)));
+                if (!key || seq > upto) continue;
+                line.assign(reinterpret_cast<const char*>(sl + 1), len);
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if (ver->load(std::memory_order_relaxed) != v) continue;   // torn: rewritten since
+                fn(static_cast<uint32_t>((key & ~(uint64_t(1) << 63)) >> 16), static_cast<uint16_t>(key & 0xFFFF), line);
+            }
+        }
+    };
+
+    struct Client {
+        sock_t s = INVALID_SOCK;
+        uint64_t id = 0;
+        std::string peer;
+        long uid = -1;                          // Unix peer uid (-1 when unknown / TCP)
+        bool live = false;                      // AUTH accepted
+        bool closing = false;                   // drop after this loop iteration
+        bool want_write = false;                // waiting for writability
+        Clock::time_point since;                // accepted, then authenticated
+        std::string in;                         // partial command line
+
+        // loop thread only
+        std::string pending;                    // snapshot, or rest of a line a send stopped inside
+        size_t pending_off = 0;
+        bool snap_due = false;                  // AUTH accepted, snapshot not taken yet
+        bool stamp = false;                     // SEQ: "<seq> " before every stream line
+        Clock::time_point linger_until{};       // lzo: frame held back for more lines until then
+        struct Sel { uint64_t seq, from, to; uint32_t pre; };   // pre: stamp bytes before the line
+        std::vector<Sel> sel;                   // lines of the span being sent
+        bool zc = false;                        // MSG_ZEROCOPY enabled on the socket
+        uint32_t zc_next = 0;                   // id the kernel gives the next zerocopy send
+        std::deque<std::pair<uint32_t, uint64_t>> zc_q;   // in flight: (id, first ring line)
+
+        // shared with notify() under Impl::clients_mtx
+        Filter filter;
+        bool lzo = false;                       // FORMAT lzo: pending holds frames
+        uint64_t next_seq = 0;                  // cursor: next ring line to look at
+        uint64_t pin = UINT64_MAX;              // first line of the spans being sent / in flight
+        bool pin_blocked = false;               // notify() needed the room its pin holds
+        bool idle = true;                       // caught up; notify() wakes the loop for it
+        uint64_t wake_seq = UINT64_MAX;         // lzo frame lingering: notify() wakes the loop once
+        uint64_t wake_bytes = UINT64_MAX;       // ... the ring reaches this line or byte offset
+        Clock::time_point behind_since;         // when it last stopped being caught up
+        uint64_t lines = 0, bytes = 0, dropped = 0, lag_hwm = 0;
+        uint64_t sndq = 0, zc_sends = 0, zc_copied = 0, snap_lines = 0;
+    };
+
     // Local implementation type (hidden)
     struct Impl {
         SocketRelay::Config cfg;
@@ -46,21 +283,60 @@ namespace {
         // listen socket and chosen port
         sock_t listen_sock = INVALID_SOCK;
         uint16_t listen_port = 0;
+        bool unix_sock = false;                 // AF_UNIX listener
+        bool seqpacket = false;                 // ... of type SOCK_SEQPACKET
+        std::vector<char> rbuf;                 // loop-thread receive buffer (a whole seqpacket message)
 
-        std::thread accept_thread;
-        std::thread worker_thread;
+        std::thread loop_thread;
         std::atomic<bool> running{ false };
 
-        // client state (single client)
-        std::mutex client_mtx;
-        sock_t client_sock = INVALID_SOCK;
-        std::string client_peer;
-        std::atomic<bool> client_connected{ false };
+        // wake-up channel for the loop
+#ifdef __linux__
+        int ep = -1;
+        int wake_fd = -1;
+#else
+        sock_t wake_sock = INVALID_SOCK;        // UDP socket connected to itself
+#endif
+
+        // all connections are owned by the loop; live ones are also visible to notify()
+        std::vector<std::unique_ptr<Client>> conns;
+        mutable std::mutex clients_mtx;
+        std::vector<Client*> live;
+        std::atomic<size_t> live_count{ 0 };
+        std::atomic<bool> pin_wake{ false };    // notify() hit a client's pin: check_clients now
+        uint64_t next_id = 0;
+
+        // broadcast ring (under clients_mtx)
+        std::vector<char> data;                 // power-of-two bytes
+        struct Entry {
+            uint64_t end;                       // absolute end offset of the line
+            uint32_t token;
+            uint16_t type;
+        };
+        std::vector<Entry> index;               // power-of-two lines
+        uint64_t head_seq = 0, tail_seq = 0;    // lines [tail_seq, head_seq) are retained
+        uint64_t head_bytes = 0, tail_bytes = 0;// tail_bytes = start of line tail_seq
+        uint64_t rejected = 0;
+        uint64_t evictions = 0;
+        bool retain = false;                    // fill the ring with nobody connected (RESUME window)
+        SnapTable snap;                         // latest line per (token, type)
 
-        // queue while connected
-        std::mutex queue_mtx;
-        std::condition_variable queue_cv;
-        std::deque<std::string> q;
+        // FORMAT lzo (loop thread only)
+        struct Frame {
+            uint64_t end;                       // ring lines [first, end)
+            uint32_t lines;
+            std::string bytes;                  // header + payload
+        };
+        std::map<uint64_t, Frame> frames;       // shared frames by first seq
+        SocketFrames::Encoder frame_enc;
+        std::string frame_raw;
+
+        const Entry& entry(uint64_t n) const {
+            return index[n & (index.size() - 1)];
+        }
+        uint64_t line_start(uint64_t n) const {
+            return n <= tail_seq ? tail_bytes : entry(n - 1).end;
+        }
 
         Impl(const SocketRelay::Config& c) : cfg(c) {}
         ~Impl() {}
@@ -86,55 +362,107 @@ namespace {
 #endif
     }
 
-    // Blocking recv-a-line with optional timeout (ms). Returns true if a line (without newline) was read.
-    bool recv_line_with_timeout(sock_t s, std::string& out, int timeout_ms = 5000) {
-        out.clear();
+    inline bool set_nonblocking(sock_t s) {
 #ifdef _WIN32
-        DWORD tv = (timeout_ms >= 0) ? static_cast<DWORD>(timeout_ms) : 0;
-        setsockopt(s, SOL_SOCKET, SO_RCVTIMEO, reinterpret_cast<const char*>(&tv), sizeof(tv));
+        u_long on = 1;
+        return ioctlsocket(s, FIONBIO, &on) == 0;
 #else
-        if (timeout_ms >= 0) {
-            timeval tv{ static_cast<long>(timeout_ms / 1000), static_cast<long>((timeout_ms % 1000) * 1000) };
-            setsockopt(s, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
-        }
+        int fl = fcntl(s, F_GETFL, 0);
+        return fl >= 0 && fcntl(s, F_SETFL, fl | O_NONBLOCK) == 0;
 #endif
+    }
 
-        char ch;
-        while (true) {
+    // last socket call failed only because it would block
+    inline bool would_block() {
 #ifdef _WIN32
-            int n = recv(s, &ch, 1, 0);
-            if (n <= 0) return false;
+        return WSAGetLastError() == WSAEWOULDBLOCK;
 #else
-            ssize_t n = ::recv(s, &ch, 1, 0);
-            if (n <= 0) return false;
+        return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+#endif
+    }
+
+    // Non-blocking send; bytes sent, 0 when the socket is full, -1 on error
+    inline long send_some(sock_t s, const char* buf, size_t len) {
+#ifdef _WIN32
+        int n = send(s, buf, static_cast<int>(std::min<size_t>(len, 1u << 30)), 0);
+        if (n == SOCKET_ERROR) return would_block() ? 0 : -1;
+        return n;
+#else
+        ssize_t n = ::send(s, buf, len, kSendFlags);
+        if (n < 0) return would_block() ? 0 : -1;
+        return static_cast<long>(n);
 #endif
-            if (ch == '\n') break;
-            if (ch == '\r') continue;
-            out.push_back(ch);
-            if (out.size() > 64 * 1024) return false; // protective limit
-        }
-        return true;
     }
 
-    // Blocking send-all (no message splitting); returns false on any send error
-    bool send_all(sock_t s, const char* buf, size_t len, int timeout_ms = 5000) {
+    struct Span {
+        const char* p;
+        size_t n;
+    };
+
+    // Non-blocking gather send of up to kMaxSpans spans
+    inline long send_vec(sock_t s, const Span* v, int cnt, int flags) {
 #ifdef _WIN32
-        DWORD tv = (timeout_ms >= 0) ? static_cast<DWORD>(timeout_ms) : 0;
-        setsockopt(s, SOL_SOCKET, SO_SNDTIMEO, reinterpret_cast<const char*>(&tv), sizeof(tv));
+        WSABUF b[kMaxSpans];
+        for (int i = 0; i < cnt; ++i) {
+            b[i].buf = const_cast<char*>(v[i].p);
+            b[i].len = static_cast<ULONG>(v[i].n);
+        }
+        DWORD sent = 0;
+        (void)flags;
+        if (WSASend(s, b, static_cast<DWORD>(cnt), &sent, 0, nullptr, nullptr) == SOCKET_ERROR) return would_block() ? 0 : -1;
+        return static_cast<long>(sent);
+#else
+        iovec io[kMaxSpans];
+        for (int i = 0; i < cnt; ++i) {
+            io[i].iov_base = const_cast<char*>(v[i].p);
+            io[i].iov_len = v[i].n;
+        }
+        msghdr mh{};
+        mh.msg_iov = io;
+        mh.msg_iovlen = static_cast<decltype(mh.msg_iovlen)>(cnt);
+        ssize_t n = sendmsg(s, &mh, kSendFlags | flags);
+        if (n < 0) return would_block() ? 0 : -1;
+        return static_cast<long>(n);
 #endif
-        size_t sent = 0;
-        while (sent < len) {
+    }
+
+    // Per-client socket options from the config (best-effort)
+    static void tune_client(const SocketRelay::Config& cfg, Client* c) {
 #ifdef _WIN32
-            int n = send(s, buf + sent, static_cast<int>(len - sent), 0);
-            if (n == SOCKET_ERROR || n == 0) return false;
-            sent += static_cast<size_t>(n);
+        BOOL nd = cfg.nodelay ? TRUE : FALSE;
+        setsockopt(c->s, IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<const char*>(&nd), sizeof(nd));
+        if (cfg.sndbuf > 0) setsockopt(c->s, SOL_SOCKET, SO_SNDBUF, reinterpret_cast<const char*>(&cfg.sndbuf), sizeof(cfg.sndbuf));
 #else
-            ssize_t n = ::send(s, buf + sent, len - sent, 0);
-            if (n <= 0) return false;
-            sent += static_cast<size_t>(n);
+        int nd = cfg.nodelay ? 1 : 0;
+        if (c->uid < 0) setsockopt(c->s, IPPROTO_TCP, TCP_NODELAY, &nd, sizeof(nd));
+        if (cfg.sndbuf > 0) setsockopt(c->s, SOL_SOCKET, SO_SNDBUF, &cfg.sndbuf, sizeof(cfg.sndbuf));
 #endif
-        }
-        return true;
+#ifdef __linux__
+        int on = 1;
+        if (cfg.zerocopy_bytes) c->zc = setsockopt(c->s, SOL_SOCKET, SO_ZEROCOPY, &on, sizeof(on)) == 0;
+#endif
+    }
+
+    // Bytes the kernel still holds for the client (unsent + unacknowledged); 0 when unknown
+    static uint64_t kernel_sndq(sock_t s) {
+#ifdef __linux__
+        int v = 0;
+        if (ioctl(s, SIOCOUTQ, &v) == 0 && v > 0) return static_cast<uint64_t>(v);
+#else
+        (void)s;
+#endif
+        return 0;
+    }
+
+    inline size_t round_pow2(size_t v, size_t min_v) {
+        size_t p = min_v;
+        while (p < v && p < (size_t(1) << 40)) p <<= 1;
+        return p;
+    }
+
+    // Best-effort short reply (handshake); the socket buffer of a new connection has room
+    inline void send_reply(sock_t s, const char* msg) {
+        send_some(s, msg, std::strlen(msg));
     }
 
     // Get peer address as string (best-effort)
@@ -152,6 +480,43 @@ namespace {
         return std::string("<unknown>");
     }
 
+    // uid of a connected AF_UNIX peer, -1 when unavailable
+    static long peer_uid(sock_t s) {
+#if defined(__linux__)
+        ucred cr{};
+        socklen_t len = sizeof(cr);
+        if (getsockopt(s, SOL_SOCKET, SO_PEERCRED, &cr, &len) == 0) return static_cast<long>(cr.uid);
+#elif !defined(_WIN32)
+        uid_t uid;
+        gid_t gid;
+        if (getpeereid(s, &uid, &gid) == 0) return static_cast<long>(uid);
+#else
+        (void)s;
+#endif
+        return -1;
+    }
+
+    // AF_UNIX listener on path (a stale socket file is replaced). POSIX only.
+    static sock_t create_unix_listen_socket(const std::string& path, bool seqpacket) {
+#ifdef _WIN32
+        (void)path; (void)seqpacket;
+        return INVALID_SOCK;
+#else
+        sockaddr_un addr{};
+        if (path.empty() || path.size() >= sizeof(addr.sun_path)) return INVALID_SOCK;
+        sock_t s = socket(AF_UNIX, seqpacket ? SOCK_SEQPACKET : SOCK_STREAM, 0);
+        if (s == INVALID_SOCK) return INVALID_SOCK;
+        addr.sun_family = AF_UNIX;
+        std::memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+        ::unlink(path.c_str());
+        if (bind(s, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0 || listen(s, SOMAXCONN) < 0 || !set_nonblocking(s)) {
+            close_sock(s);
+            return INVALID_SOCK;
+        }
+        return s;
+#endif
+    }
+
     // Helper: create listen socket and bind/listen. Returns chosen port in out_port.
     static sock_t create_listen_socket(const std::string& bind_addr, uint16_t port, uint16_t& out_port) {
         sock_t s = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
@@ -171,7 +536,7 @@ namespace {
             return INVALID_SOCK;
         }
 
-        if (listen(s, 1) < 0) {
+        if (listen(s, SOMAXCONN) < 0 || !set_nonblocking(s)) {
             close_sock(s);
             return INVALID_SOCK;
         }
@@ -189,141 +554,715 @@ namespace {
         return s;
     }
 
-    // Accept loop: accepts connections, performs AUTH handshake, installs client (replace policy).
-    static void accept_loop(Impl* I) {
-        while (I->running.load()) {
-            if (I->listen_sock == INVALID_SOCK) {
-                std::this_thread::sleep_for(std::chrono::milliseconds(50));
-                continue;
-            }
+    // ----------------- wake-up and readiness -----------------
+    static bool open_waker(Impl* I) {
+#ifdef __linux__
+        I->ep = epoll_create1(EPOLL_CLOEXEC);
+        I->wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (I->ep < 0 || I->wake_fd < 0) return false;
+        epoll_event ev{};
+        ev.events = EPOLLIN;
+        ev.data.ptr = &I->wake_fd;
+        epoll_ctl(I->ep, EPOLL_CTL_ADD, I->wake_fd, &ev);
+        ev.data.ptr = &I->listen_sock;
+        return epoll_ctl(I->ep, EPOLL_CTL_ADD, I->listen_sock, &ev) == 0;
+#else
+        sock_t u = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+        if (u == INVALID_SOCK) return false;
+        sockaddr_in a{};
+        a.sin_family = AF_INET;
+        a.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        socklen_t len = static_cast<socklen_t>(sizeof(a));
+        if (bind(u, reinterpret_cast<sockaddr*>(&a), sizeof(a)) < 0 ||
+            getsockname(u, reinterpret_cast<sockaddr*>(&a), &len) < 0 ||
+            connect(u, reinterpret_cast<sockaddr*>(&a), sizeof(a)) < 0 || !set_nonblocking(u)) {
+            close_sock(u);
+            return false;
+        }
+        I->wake_sock = u;
+        return true;
+#endif
+    }
 
-            sockaddr_in peer{};
+    static void close_waker(Impl* I) {
+#ifdef __linux__
+        if (I->wake_fd >= 0) close(I->wake_fd);
+        if (I->ep >= 0) close(I->ep);
+        I->wake_fd = I->ep = -1;
+#else
+        close_sock(I->wake_sock);
+        I->wake_sock = INVALID_SOCK;
+#endif
+    }
+
+    static void wake(Impl* I) {
+#ifdef __linux__
+        uint64_t one = 1;
+        ssize_t r = write(I->wake_fd, &one, sizeof(one));
+        (void)r;
+#else
+        char b = 1;
+        send(I->wake_sock, &b, 1, 0);
+#endif
+    }
+
+    static void drain_waker(Impl* I) {
+#ifdef __linux__
+        uint64_t v;
+        ssize_t r = read(I->wake_fd, &v, sizeof(v));
+        (void)r;
+#else
+        char buf[64];
+        while (recv(I->wake_sock, buf, sizeof(buf), 0) > 0) {}
+#endif
+    }
+
+    // (de)register interest in writability; the generic poll path reads want_write directly
+    static void watch(Impl* I, Client* c, bool add) {
+#ifdef __linux__
+        epoll_event ev{};
+        ev.events = EPOLLIN | EPOLLRDHUP | (c->want_write ? static_cast<uint32_t>(EPOLLOUT) : 0u);
+        ev.data.ptr = c;
+        epoll_ctl(I->ep, add ? EPOLL_CTL_ADD : EPOLL_CTL_MOD, c->s, &ev);
+#else
+        (void)I; (void)c; (void)add;
+#endif
+    }
+
+    static void set_want_write(Impl* I, Client* c, bool on) {
+        if (c->want_write == on) return;
+        c->want_write = on;
+        watch(I, c, false);
+    }
+
+    struct Ready {
+        void* who;                              // Client*, &listen_sock or the waker
+        bool in, out, err;
+    };
+
+    static void wait_ready(Impl* I, std::vector<Ready>& ready, int timeout_ms) {
+        ready.clear();
+#ifdef __linux__
+        epoll_event evs[64];
+        int n = epoll_wait(I->ep, evs, 64, timeout_ms);
+        for (int i = 0; i < n; ++i) {
+            const uint32_t e = evs[i].events;
+            ready.push_back(Ready{ evs[i].data.ptr, (e & EPOLLIN) != 0, (e & EPOLLOUT) != 0,
+                (e & (EPOLLERR | EPOLLHUP | EPOLLRDHUP)) != 0 });
+        }
+#else
+        std::vector<pollfd> fds;
+        std::vector<void*> who;
+        fds.push_back(pollfd{ I->wake_sock, POLLIN, 0 }); who.push_back(&I->wake_sock);
+        fds.push_back(pollfd{ I->listen_sock, POLLIN, 0 }); who.push_back(&I->listen_sock);
+        for (auto& c : I->conns) {
+            fds.push_back(pollfd{ c->s, static_cast<short>(POLLIN | (c->want_write ? POLLOUT : 0)), 0 });
+            who.push_back(c.get());
+        }
+#ifdef _WIN32
+        int n = WSAPoll(fds.data(), static_cast<ULONG>(fds.size()), timeout_ms);
+#else
+        int n = poll(fds.data(), static_cast<nfds_t>(fds.size()), timeout_ms);
+#endif
+        for (size_t i = 0; n > 0 && i < fds.size(); ++i) {
+            const short e = fds[i].revents;
+            if (!e) continue;
+            ready.push_back(Ready{ who[i], (e & POLLIN) != 0, (e & POLLOUT) != 0, (e & (POLLERR | POLLHUP | POLLNVAL)) != 0 });
+        }
+#endif
+    }
+
+    static bool is_waker(Impl* I, void* who) {
+#ifdef __linux__
+        return who == &I->wake_fd;
+#else
+        return who == &I->wake_sock;
+#endif
+    }
+
+    // ----------------- connections -----------------
+    static void accept_all(Impl* I) {
+        while (true) {
+            sockaddr_storage peer{};
             socklen_t plen = static_cast<socklen_t>(sizeof(peer));
             sock_t s = accept(I->listen_sock, reinterpret_cast<sockaddr*>(&peer), &plen);
-            if (s == INVALID_SOCK) {
-                // transient error
-                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            if (s == INVALID_SOCK) return;      // drained (or transient error)
+            set_nonblocking(s);
+            const long uid = I->unix_sock ? peer_uid(s) : -1;
+            std::string peerstr = !I->unix_sock ? peer_to_string(s) : uid >= 0 ? "unix:uid=" + std::to_string(uid) : std::string("unix");
+            if (I->conns.size() >= I->cfg.max_clients) {   // live + still in AUTH
+                send_reply(s, "ERR busy\n");
+                close_sock(s);
+                if (I->cfg.verbose) std::cerr << "[SOCKET] rejected " << peerstr << ": " << I->cfg.max_clients << " clients already\n";
                 continue;
             }
-
-            std::string peerstr = peer_to_string(s);
+            std::unique_ptr<Client> c(new Client());
+            c->s = s;
+            c->id = ++I->next_id;
+            c->peer = peerstr;
+            c->uid = uid;
+            c->since = Clock::now();
+            tune_client(I->cfg, c.get());
+            watch(I, c.get(), true);
             if (I->cfg.verbose) std::cerr << "[SOCKET] incoming connection from " << peerstr << "\n";
+            I->conns.push_back(std::move(c));
+        }
+    }
 
-            // read AUTH line
-            std::string line;
-            bool got = recv_line_with_timeout(s, line, 3000);
-            if (!got) {
-                if (I->cfg.verbose) std::cerr << "[SOCKET] auth read failed from " << peerstr << "\n";
-                close_sock(s);
-                continue;
+    // AUTH <token>\n -> OK\n (client goes live) or ERR auth\n (closed).
+    // A Unix peer with uid cfg.allow_uid may send just "AUTH".
+    static void handle_auth(Impl* I, Client* c, const std::string& line) {
+        const bool token_ok = !I->cfg.auth_token.empty() && line.size() >= 6 && line.rfind("AUTH ", 0) == 0 && line.substr(5) == I->cfg.auth_token;
+        const bool cred_ok = I->cfg.allow_uid >= 0 && c->uid == I->cfg.allow_uid && line.rfind("AUTH", 0) == 0;
+        if (token_ok || cred_ok) {
+            send_reply(c->s, "OK\n");
+            c->live = true;
+            c->since = Clock::now();
+            c->snap_due = I->snap.count != 0;
+            {
+                std::lock_guard<std::mutex> lk(I->clients_mtx);
+                c->next_seq = I->head_seq;      // starts with the next line
+                I->live.push_back(c);
+                I->live_count.store(I->live.size());
             }
+            if (I->cfg.verbose) std::cerr << "[SOCKET] client accepted: " << c->peer << "\n";
+        }
+        else {
+            send_reply(c->s, "ERR auth\n");
+            c->closing = true;
+            if (I->cfg.verbose) std::cerr << "[SOCKET] auth failed from " << c->peer << "\n";
+        }
+    }
 
-            bool ok = false;
-            if (line.size() >= 6 && line.rfind("AUTH ", 0) == 0) {
-                std::string tok = line.substr(5);
-                if (tok == I->cfg.auth_token) ok = true;
+    // Numbers separated by ',' or ' '; "*" => all. Returns false on anything else.
+    static bool parse_list(const std::string& args, std::vector<uint32_t>& out, bool& all) {
+        out.clear();
+        all = false;
+        size_t i = 0;
+        while (i < args.size()) {
+            if (args[i] == ',' || args[i] == ' ') { ++i; continue; }
+            if (args[i] == '*') { all = true; ++i; continue; }
+            if (args[i] < '0' || args[i] > '9') return false;
+            uint64_t v = 0;
+            while (i < args.size() && args[i] >= '0' && args[i] <= '9' && v <= 0xFFFFFFFFull) v = v * 10 + static_cast<uint64_t>(args[i++] - '0');
+            if (v > 0xFFFFFFFFull) return false;
+            out.push_back(static_cast<uint32_t>(v));
+        }
+        return all || !out.empty();
+    }
+
+    static void flush_client(Impl* I, Client* c);
+
+    // Protocol text outside the stream (snapshot, markers): as is, or as kFlagText frames
+    // of at most cfg.frame_bytes (cut at a newline) for an lzo client
+    static void queue_text(Impl* I, Client* c, const std::string& text) {
+        if (!c->lzo) { c->pending += text; return; }
+        size_t pos = 0;
+        while (pos < text.size()) {
+            size_t take = text.size() - pos;
+            if (take > I->cfg.frame_bytes) {
+                size_t cut = text.rfind('\n', pos + I->cfg.frame_bytes - 1);
+                if (cut == std::string::npos || cut < pos) cut = text.find('\n', pos);
+                if (cut != std::string::npos) take = cut + 1 - pos;
             }
+            const std::string_view part(text.data() + pos, take);
+            I->frame_enc.seal(part, static_cast<uint32_t>(std::count(part.begin(), part.end(), '\n')), 0, 0,
+                SocketFrames::kFlagText, c->pending);
+            pos += take;
+        }
+    }
 
-            if (!ok) {
-                const char* err = "ERR auth\n";
-                send_all(s, err, strlen(err));
-                close_sock(s);
-                if (I->cfg.verbose) std::cerr << "[SOCKET] auth failed from " << peerstr << "\n";
-                continue;
+    // RESUME <seq>: continue from ring line seq when it is still retained ("#RESUME <seq>"),
+    // else report the gap and replay from the oldest line kept ("#GAP <seq> <oldest>").
+    // Either way the replay replaces the snapshot.
+    static void resume_client(Impl* I, Client* c, uint64_t seq) {
+        uint64_t from;
+        {
+            std::lock_guard<std::mutex> lk(I->clients_mtx);
+            from = (seq >= I->tail_seq && seq <= I->head_seq) ? seq : I->tail_seq;
+            c->next_seq = from;
+            if (c->idle && from < I->head_seq) {
+                c->idle = false;
+                c->behind_since = Clock::now();
             }
+        }
+        queue_text(I, c, (from == seq) ? "#RESUME " + std::to_string(seq) + "\n"
+            : "#GAP " + std::to_string(seq) + " " + std::to_string(from) + "\n");
+        c->snap_due = false;
+        if (I->cfg.verbose) std::cerr << "[SOCKET] client " << c->peer << " resumes at " << from << (from == seq ? "\n" : " (gap)\n");
+        flush_client(I, c);
+    }
 
-            // send OK
-            const char* okmsg = "OK\n";
-            send_all(s, okmsg, strlen(okmsg));
+    // After AUTH (not acknowledged; the stream carries data lines only):
+    //   SUB <token,...|*>    add tokens (* => every token again)
+    //   UNSUB <token,...|*>  remove tokens (* => none)
+    //   TYPES <type,...|*>   only these message types (7208, 7202, ...; * => all)
+    //   SEQ                  stamp stream lines with their sequence number
+    //   RESUME <seq>         see resume_client
+    //   FORMAT lzo           "OK lzo" and frames from then on (SocketFrames.h); only before
+    //                        the first stream byte, i.e. sent with AUTH; else "ERR format"
+    static void handle_command(Impl* I, Client* c, const std::string& line) {
+        const size_t sp = line.find(' ');
+        const std::string verb = line.substr(0, sp);
+        const std::string args = (sp == std::string::npos) ? std::string() : line.substr(sp + 1);
+        if (verb == "SEQ" && args.empty()) { c->stamp = true; return; }
+        if (verb == "FORMAT") {
+            std::lock_guard<std::mutex> lk(I->clients_mtx);
+            const bool ok = args == "lzo" && !I->seqpacket && !c->lzo && c->bytes == 0 && c->pending.empty();
+            c->pending += ok ? "OK lzo\n" : "ERR format\n";
+            c->lzo = c->lzo || ok;
+            return;
+        }
+        if (verb == "RESUME" && !args.empty() && args.find_first_not_of("0123456789") == std::string::npos) {
+            resume_client(I, c, std::strtoull(args.c_str(), nullptr, 10));
+            return;
+        }
+        std::vector<uint32_t> list;
+        bool all = false;
+        const bool sub = (verb == "SUB"), unsub = (verb == "UNSUB"), types = (verb == "TYPES");
+        if (!(sub || unsub || types) || !parse_list(args, list, all)) {
+            if (I->cfg.verbose) std::cerr << "[SOCKET] client " << c->peer << ": ignored command '" << line.substr(0, 64) << "'\n";
+            return;
+        }
+        std::lock_guard<std::mutex> lk(I->clients_mtx);
+        Filter& f = c->filter;
+        if (types) {
+            f.types.clear();
+            if (!all) for (uint32_t t : list) if (t <= 0xFFFF) f.types.push_back(static_cast<uint16_t>(t));
+            return;
+        }
+        if (all || (sub && f.fresh)) {
+            f.exclude = sub && all;             // SUB * => everything, UNSUB * => nothing
+            f.bits.clear();
+        }
+        f.fresh = false;
+        for (uint32_t t : list) f.set(t, sub != f.exclude);
+    }
 
-            {
-                std::lock_guard<std::mutex> lk(I->client_mtx);
-                if (I->client_connected.load() && I->client_sock != INVALID_SOCK) {
-                    if (I->cfg.replace_client) {
-                        if (I->cfg.verbose) std::cerr << "[SOCKET] replacing existing client\n";
-                        close_sock(I->client_sock);
+    // Queue the snapshot (filtered) and start the client's cursor at the ring head.
+    // Only the cursor is set under clients_mtx; the slots are copied after it, while notify()
+    // goes on. A slot rewritten by then holds a line from seq on, which the stream delivers.
+    static void send_snapshot(Impl* I, Client* c) {
+        std::string body, line;
+        uint64_t n = 0, seq;
+        size_t used;
+        {
+            std::lock_guard<std::mutex> lk(I->clients_mtx);
+            seq = I->head_seq;
+            c->next_seq = seq;                  // every line before seq is in the snapshot
+            used = I->snap.used;
+        }
+        body.reserve(used * 160);
+        I->snap.for_each_before(seq, line, [&](uint32_t token, uint16_t type, const std::string& l) {
+            if (!c->filter.match(token, type)) return;
+            body.append(l);
+            body.push_back('\n');
+            ++n;
+        });
+        {
+            std::lock_guard<std::mutex> lk(I->clients_mtx);
+            c->snap_lines = n;
+        }
+        queue_text(I, c, "#SNAPSHOT " + std::to_string(n) + "\n" + body + "#LIVE " + std::to_string(seq) + "\n");
+        c->snap_due = false;
+    }
+
+    // AUTH line first, then filter commands; a line may arrive in pieces.
+    // The snapshot follows the commands that arrived together with AUTH.
+    static void read_client(Impl* I, Client* c) {
+        char* buf = I->rbuf.data();
+        while (!c->closing) {
+            int n = static_cast<int>(recv(c->s, buf, static_cast<int>(I->rbuf.size()), 0));
+            if (n == 0) { c->closing = true; break; }
+            if (n < 0) { if (!would_block()) c->closing = true; break; }
+            c->in.append(buf, static_cast<size_t>(n));
+            size_t pos = 0, nl;
+            while (!c->closing && (nl = c->in.find('\n', pos)) != std::string::npos) {
+                std::string line = c->in.substr(pos, nl - pos);
+                pos = nl + 1;
+                if (!line.empty() && line.back() == '\r') line.pop_back();
+                if (c->live) handle_command(I, c, line);
+                else handle_auth(I, c, line);
+            }
+            c->in.erase(0, pos);
+            if (c->in.size() > 64 * 1024) c->closing = true;   // protective limit
+        }
+        if (c->closing) return;
+        if (c->snap_due) send_snapshot(I, c);
+        if (c->pending_off < c->pending.size() && !c->want_write) flush_client(I, c);   // snapshot or replies
+    }
+
+    // Send what is queued in pending; false when the socket filled up (or failed)
+    static bool send_pending(Impl* I, Client* c) {
+        while (c->pending_off < c->pending.size()) {
+            size_t want = c->pending.size() - c->pending_off;
+            if (I->seqpacket && want > I->cfg.batch_bytes) {
+                // one message = whole lines: cut at the last newline that fits (or after one long line)
+                const char* p = c->pending.data() + c->pending_off;
+                size_t cut = std::string_view(p, I->cfg.batch_bytes).rfind('\n');
+                if (cut == std::string_view::npos) cut = std::string_view(p, want).find('\n');
+                if (cut != std::string_view::npos) want = cut + 1;
+            }
+            long n = send_some(c->s, c->pending.data() + c->pending_off, want);
+            if (n < 0) { c->closing = true; return false; }
+            if (n == 0) { set_want_write(I, c, true); return false; }
+            c->pending_off += static_cast<size_t>(n);
+            std::lock_guard<std::mutex> lk(I->clients_mtx);
+            c->bytes += static_cast<uint64_t>(n);
+        }
+        c->pending.clear();
+        c->pending_off = 0;
+        if (c->pending.capacity() > 64 * 1024) std::string().swap(c->pending);   // snapshot sent
+        return true;
+    }
+
+    // FORMAT lzo: the next frame from the client's cursor into pending. A shared frame is taken
+    // from the cache or made and cached; a filtered client's (or one starting inside a cached
+    // frame) is its own. False when caught up or lingering for a fuller frame.
+    static bool next_frame(Impl* I, Client* c) {
+        const auto now = Clock::now();
+        std::string& raw = I->frame_raw;
+        raw.clear();
+        const Impl::Frame* hit = nullptr;
+        uint64_t first, end, first_sel = 0, last_sel = 0;
+        uint32_t lines = 0;
+        bool cache = false;
+        {
+            std::lock_guard<std::mutex> lk(I->clients_mtx);
+            first = c->next_seq;
+            const bool shared = c->filter.everything();
+
+            // forget frames behind every sharing client (or already out of the ring)
+            uint64_t low = UINT64_MAX;
+            for (const Client* o : I->live) if (o->lzo && o->filter.everything()) low = std::min(low, o->next_seq);
+            while (!I->frames.empty() && (I->frames.begin()->second.end <= low || I->frames.begin()->first < I->tail_seq)) I->frames.erase(I->frames.begin());
+
+            if (first >= I->head_seq) {
+                c->idle = true;
+                c->linger_until = Clock::time_point{};
+                c->wake_seq = c->wake_bytes = UINT64_MAX;
+                return false;
+            }
+            uint64_t limit = std::min(I->head_seq, first + kScanLines);
+            if (shared) {
+                auto it = I->frames.find(first);
+                if (it != I->frames.end()) hit = &it->second;
+                else {
+                    cache = true;
+                    auto nx = I->frames.upper_bound(first);
+                    if (nx != I->frames.end()) limit = std::min(limit, nx->first);
+                    if (nx != I->frames.begin() && std::prev(nx)->second.end > first) {
+                        limit = std::min(limit, std::prev(nx)->second.end);   // inside a cached frame: up to its end, uncached
+                        cache = false;
                     }
-                    else {
-                        const char* busy = "ERR busy\n";
-                        send_all(s, busy, strlen(busy));
-                        close_sock(s);
-                        continue;
+                    for (const Client* o : I->live) {
+                        if (o != c && o->lzo && o->next_seq > first && o->next_seq < limit && o->filter.everything()) limit = o->next_seq;
                     }
                 }
-                I->client_sock = s;
-                I->client_peer = peerstr;
-                I->client_connected.store(true);
             }
+            if (hit) {
+                c->next_seq = hit->end;
+                c->lines += hit->lines;
+                c->linger_until = Clock::time_point{};
+                c->wake_seq = c->wake_bytes = UINT64_MAX;
+            }
+            else {
+                // wait for a fuller frame while it is only short because the writer has not got further
+                // (and while the lines waiting are a small part of the ring, so none get evicted)
+                const uint64_t full_lines = I->index.size() / 4;
+                const uint64_t full_bytes = std::min<uint64_t>(I->cfg.frame_bytes, I->data.size() / 4);
+                if (I->cfg.frame_linger_ms && limit == I->head_seq && limit - first < full_lines &&
+                    I->entry(limit - 1).end - I->line_start(first) < full_bytes) {
+                    if (c->linger_until == Clock::time_point{}) {
+                        c->linger_until = now + std::chrono::milliseconds(I->cfg.frame_linger_ms);
+                        if (c->idle) { c->idle = false; c->behind_since = now; }   // the loop comes back for it
+                    }
+                    if (now < c->linger_until) {
+                        c->wake_seq = first + full_lines;
+                        c->wake_bytes = I->line_start(first) + full_bytes;
+                        return false;
+                    }
+                }
+                c->wake_seq = c->wake_bytes = UINT64_MAX;
+                const uint64_t mask = I->data.size() - 1;
+                uint64_t k = first;
+                for (; k < limit; ++k) {
+                    const Impl::Entry& e = I->entry(k);
+                    if (!shared && !c->filter.match(e.token, e.type)) continue;
+                    const uint64_t from = I->line_start(k);
+                    const size_t n = static_cast<size_t>(e.end - from);
+                    if (lines && raw.size() + n > I->cfg.frame_bytes) break;
+                    const size_t off = static_cast<size_t>(from & mask);
+                    const size_t n1 = std::min(n, I->data.size() - off);
+                    raw.append(I->data.data() + off, n1);
+                    if (n1 < n) raw.append(I->data.data(), n - n1);
+                    if (!lines) first_sel = k;
+                    last_sel = k;
+                    ++lines;
+                }
+                end = k;
+                c->next_seq = end;
+                c->lines += lines;
+                c->linger_until = Clock::time_point{};
+            }
+        }
+        if (hit) { c->pending += hit->bytes; return true; }
+        if (!lines) return true;                // nothing selected in the scanned lines; look further
+        const size_t at = c->pending.size();
+        I->frame_enc.seal(raw, lines, first_sel, last_sel, 0, c->pending);
+        if (cache) I->frames.emplace(first, Impl::Frame{ end, lines, c->pending.substr(at) });
+        return true;
+    }
 
-            // wake worker if waiting
-            I->queue_cv.notify_one();
-
-            if (I->cfg.verbose) std::cerr << "[SOCKET] client accepted: " << peerstr << "\n";
+    // FORMAT lzo: whole frames, sent from pending
+    static void flush_frames(Impl* I, Client* c) {
+        while (!c->closing) {
+            if (!send_pending(I, c)) return;
+            if (!next_frame(I, c)) break;
         }
+        if (c->closing) return;
+        set_want_write(I, c, false);
     }
 
-    // Worker loop: wait for queued messages and send to client in batches
-    static void worker_loop(Impl* I) {
-        while (I->running.load()) {
-            // Wait until there is a client and data
-            std::unique_lock<std::mutex> qlk(I->queue_mtx);
-            I->queue_cv.wait(qlk, [&] {
-                return !I->running.load() || (I->client_connected.load() && !I->q.empty());
-                });
-
-            if (!I->running.load()) break;
-
-            // copy a batch
-            std::vector<std::string> batch;
-            size_t bytes = 0;
-            while (!I->q.empty() && bytes < I->cfg.batch_bytes) {
-                batch.emplace_back(std::move(I->q.front()));
-                bytes += batch.back().size() + 1; // newline
-                I->q.pop_front();
-            }
-            qlk.unlock();
-
-            if (batch.empty()) {
-                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    // Send the client's span of the ring (and any torn line) until caught up or the socket is full
+    static void flush_client(Impl* I, Client* c) {
+        if (c->lzo) { flush_frames(I, c); return; }
+        while (!c->closing) {
+            if (c->pending_off < c->pending.size()) {
+                if (!send_pending(I, c)) return;
                 continue;
             }
 
-            // build send buffer
-            std::string out;
-            out.reserve(bytes);
-            for (auto& m : batch) {
-                out.append(m);
-                if (m.empty() || m.back() != '\n') out.push_back('\n');
+            // gather the client's lines into spans; filtered lines are stepped over
+            std::vector<Client::Sel>& sel = c->sel;
+            Span v[kMaxSpans];
+            char stamp[kMaxSpans][24];          // "<seq> " per selected line (SEQ)
+            const int per_line = c->stamp ? 3 : 2;
+            int cnt = 0;
+            size_t len = 0;
+            uint64_t first, scan_end;
+            sel.clear();
+            {
+                std::lock_guard<std::mutex> lk(I->clients_mtx);
+                first = c->next_seq;
+                const uint64_t mask = I->data.size() - 1;
+                const uint64_t limit = std::min(I->head_seq, first + kScanLines);
+                uint64_t k = first;
+                for (; k < limit && cnt + per_line <= static_cast<int>(kMaxSpans); ++k) {
+                    const Impl::Entry& e = I->entry(k);
+                    if (!c->filter.match(e.token, e.type)) continue;
+                    const uint64_t from = I->line_start(k);
+                    const size_t n = static_cast<size_t>(e.end - from);
+                    uint32_t pre = 0;
+                    if (c->stamp) pre = static_cast<uint32_t>(std::snprintf(stamp[sel.size()], sizeof(stamp[0]), "%llu ", static_cast<unsigned long long>(k)));
+                    if (!sel.empty() && len + pre + n > I->cfg.batch_bytes) break;
+                    if (pre) v[cnt++] = Span{ stamp[sel.size()], pre };
+                    const size_t off = static_cast<size_t>(from & mask);
+                    const size_t n1 = std::min(n, I->data.size() - off);
+                    const char* p = I->data.data() + off;
+                    if (cnt && v[cnt - 1].p + v[cnt - 1].n == p) v[cnt - 1].n += n1;   // adjacent in the ring
+                    else v[cnt++] = Span{ p, n1 };
+                    if (n1 < n) v[cnt++] = Span{ I->data.data(), n - n1 };
+                    sel.push_back(Client::Sel{ k, from, e.end, pre });
+                    len += pre + n;
+                }
+                scan_end = k;
+                if (sel.empty()) {
+                    c->next_seq = scan_end;
+                    if (scan_end == I->head_seq) { c->idle = true; break; }   // caught up
+                    continue;
+                }
+                c->idle = false;
+                c->pin = c->zc_q.empty() ? first : c->zc_q.front().second;   // spans cannot be overwritten while pinned
             }
 
-            // send under client lock
-            bool ok = true;
-            {
-                std::lock_guard<std::mutex> lk(I->client_mtx);
-                if (!I->client_connected.load() || I->client_sock == INVALID_SOCK) {
-                    ok = false;
+            const bool zc = c->zc && len >= I->cfg.zerocopy_bytes;
+            long n = send_vec(c->s, v, cnt, zc ? MSG_ZEROCOPY_FLAG : 0);
+            if (zc && n > 0) c->zc_q.emplace_back(c->zc_next++, first);   // pages stay referenced until completion
+
+            uint64_t k = scan_end;
+            uint64_t sent = 0;
+            uint64_t left = n > 0 ? static_cast<uint64_t>(n) : 0;
+            for (size_t i = 0; i < sel.size(); ++i) {
+                const Client::Sel& l = sel[i];
+                if (left >= l.pre + (l.to - l.from)) { left -= l.pre + (l.to - l.from); ++sent; continue; }
+                k = l.seq;
+                if (left) {
+                    // keep the rest of the torn line out of the ring (short; only when the socket filled up)
+                    const uint64_t mask = I->data.size() - 1;
+                    if (left < l.pre) c->pending.append(stamp[i] + left, static_cast<size_t>(l.pre - left));
+                    for (uint64_t b = l.from + (left > l.pre ? left - l.pre : 0); b < l.to; ++b) c->pending.push_back(I->data[static_cast<size_t>(b & mask)]);
+                    ++sent;
+                    ++k;
                 }
-                else {
-                    if (I->cfg.verbose) {
-                        std::cerr << "[SOCKET] worker: sending bytes=" << out.size() << " to " << I->client_peer << "\n";
-                    }
-                    if (!send_all(I->client_sock, out.data(), out.size())) {
-                        if (I->cfg.verbose) std::cerr << "[SOCKET] failed to send to client " << I->client_peer << "\n";
-                        close_sock(I->client_sock);
-                        I->client_sock = INVALID_SOCK;
-                        I->client_connected.store(false);
-                        ok = false;
-                    }
-                    else {
-                        if (I->cfg.verbose) std::cerr << "[SOCKET] worker: send OK\n";
-                    }
+                break;
+            }
+            {
+                std::lock_guard<std::mutex> lk(I->clients_mtx);
+                c->pin = c->zc_q.empty() ? UINT64_MAX : c->zc_q.front().second;
+                c->next_seq = k;
+                c->lines += sent;
+                if (n > 0) c->bytes += static_cast<uint64_t>(n);
+                if (zc && n > 0) ++c->zc_sends;
+            }
+            if (n < 0) {
+                if (I->cfg.verbose) std::cerr << "[SOCKET] failed to send to client " << c->peer << "\n";
+                c->closing = true;
+                return;
+            }
+            if (k < scan_end || !c->pending.empty()) { set_want_write(I, c, true); return; }   // pending: torn line
+        }
+        if (c->closing) return;
+        set_want_write(I, c, false);
+    }
+
+    // Zerocopy completions from the error queue: release the pin of finished sends
+    static void reap_zerocopy(Impl* I, Client* c) {
+#ifdef __linux__
+        if (c->zc_q.empty()) return;
+        uint64_t copied = 0;
+        while (true) {
+            char control[128];
+            msghdr mh{};
+            mh.msg_control = control;
+            mh.msg_controllen = sizeof(control);
+            if (recvmsg(c->s, &mh, MSG_ERRQUEUE) < 0) break;
+            for (cmsghdr* cm = CMSG_FIRSTHDR(&mh); cm; cm = CMSG_NXTHDR(&mh, cm)) {
+                if (!((cm->cmsg_level == SOL_IP && cm->cmsg_type == IP_RECVERR) ||
+                    (cm->cmsg_level == SOL_IPV6 && cm->cmsg_type == IPV6_RECVERR))) continue;
+                const sock_extended_err* ee = reinterpret_cast<const sock_extended_err*>(CMSG_DATA(cm));
+                if (ee->ee_errno != 0 || ee->ee_origin != SO_EE_ORIGIN_ZEROCOPY) continue;
+                const uint32_t hi = ee->ee_data;   // ids [ee_info, ee_data] are done
+                if (ee->ee_code & SO_EE_CODE_ZEROCOPY_COPIED) copied += hi - ee->ee_info + 1;
+                while (!c->zc_q.empty() && static_cast<int32_t>(c->zc_q.front().first - hi) <= 0) c->zc_q.pop_front();
+            }
+        }
+        if (copied) c->zc = false;              // the kernel copied anyway (loopback): not worth it
+        std::lock_guard<std::mutex> lk(I->clients_mtx);
+        c->zc_copied += copied;
+        c->pin = c->zc_q.empty() ? UINT64_MAX : c->zc_q.front().second;
+#else
+        (void)I; (void)c;
+#endif
+    }
+
+    // Disconnect clients that break cfg.evict_lag_ms / cfg.evict_queue_bytes, or whose zerocopy
+    // sends still pin the ring tail notify() needed (always: the ring is shared); refresh sndq
+    static void check_clients(Impl* I, Clock::time_point now) {
+        std::vector<std::pair<Client*, const char*>> evict;
+        std::vector<Client*> pinned;
+        {
+            std::lock_guard<std::mutex> lk(I->clients_mtx);
+            for (Client* c : I->live) {
+                if (c->pin_blocked) { c->pin_blocked = false; if (!c->zc_q.empty()) pinned.push_back(c); }
+            }
+        }
+        for (Client* c : pinned) reap_zerocopy(I, c);  // a completion may just be late
+        {
+            std::lock_guard<std::mutex> lk(I->clients_mtx);
+            for (Client* c : pinned) {
+                if (c->pin > I->tail_seq) continue;
+                // abort (RST): the kernel drops the queued sends instead of reading ring pages
+                // that are about to be reused
+                linger lg{ 1, 0 };
+                setsockopt(c->s, SOL_SOCKET, SO_LINGER, reinterpret_cast<const char*>(&lg), sizeof(lg));
+                evict.emplace_back(c, "zerocopy pin");
+                c->closing = true;
+            }
+            for (Client* c : I->live) {
+                if (c->closing) continue;
+                const uint64_t kq = kernel_sndq(c->s);
+                c->sndq = kq + (c->pending.size() - c->pending_off);
+                if (I->cfg.evict_lag_ms && !c->idle && now - c->behind_since > std::chrono::milliseconds(I->cfg.evict_lag_ms)) evict.emplace_back(c, "behind");
+                else if (I->cfg.evict_queue_bytes && kq > I->cfg.evict_queue_bytes) evict.emplace_back(c, "send queue");   // a snapshot being sent does not count
+            }
+            I->evictions += evict.size();
+        }
+        for (const auto& e : evict) {
+            Client* c = e.first;
+            std::cerr << "[SOCKET] evicting client " << c->id << " " << c->peer << ": " << e.second
+                << " (lag=" << (I->head_seq - c->next_seq) << " lines, sndq=" << c->sndq << " bytes)\n";
+            c->closing = true;
+        }
+    }
+
+    static void drop_closed(Impl* I) {
+        bool any = false;
+        for (auto& c : I->conns) any = any || c->closing;
+        if (!any) return;
+        {
+            std::lock_guard<std::mutex> lk(I->clients_mtx);
+            I->live.erase(std::remove_if(I->live.begin(), I->live.end(), [](Client* c) { return c->closing; }), I->live.end());
+            I->live_count.store(I->live.size());
+        }
+        for (auto& c : I->conns) {
+            if (!c->closing) continue;
+            if (I->cfg.verbose && c->live) std::cerr << "[SOCKET] client " << c->peer << " disconnected\n";
+            close_sock(c->s);                   // also removes it from the epoll set
+            c.reset();
+        }
+        I->conns.erase(std::remove(I->conns.begin(), I->conns.end(), nullptr), I->conns.end());
+    }
+
+    // Event loop: accept, AUTH, sends. Exits when running is cleared (stop() wakes it).
+    static void event_loop(Impl* I, SocketRelay* self) {
+        std::vector<Ready> ready;
+        auto next_stats = Clock::now() + std::chrono::milliseconds(I->cfg.stats_interval_ms);
+        auto next_check = Clock::now();
+        while (I->running.load()) {
+            int timeout_ms = 100;
+            Clock::time_point linger{};         // earliest lzo frame deadline
+            for (auto& c : I->conns) {
+                if (c->linger_until != Clock::time_point{} && (linger == Clock::time_point{} || c->linger_until < linger)) linger = c->linger_until;
+            }
+            if (linger != Clock::time_point{}) {
+                const auto left = std::chrono::duration_cast<std::chrono::milliseconds>(linger - Clock::now()).count() + 1;
+                timeout_ms = static_cast<int>(std::max<long long>(0, std::min<long long>(timeout_ms, left)));
+            }
+            wait_ready(I, ready, timeout_ms);
+            bool woken = false;
+            for (const Ready& r : ready) {
+                if (is_waker(I, r.who)) { drain_waker(I); woken = true; continue; }
+                if (r.who == &I->listen_sock) { accept_all(I); continue; }
+                Client* c = static_cast<Client*>(r.who);
+                if (r.err) reap_zerocopy(I, c);
+                if (r.in || r.err) read_client(I, c);
+                if (r.out && c->live) flush_client(I, c);
+            }
+            if (woken) {
+                for (auto& c : I->conns) {
+                    if (c->live && !c->want_write) flush_client(I, c.get());
                 }
             }
 
+            // AUTH deadline for connections that never sent their line
+            const auto now = Clock::now();
+            if (linger != Clock::time_point{} && now >= linger) {
+                for (auto& c : I->conns) {
+                    if (c->linger_until != Clock::time_point{} && now >= c->linger_until && !c->want_write) flush_client(I, c.get());
+                }
+            }
+            for (auto& c : I->conns) {
+                if (!c->live && now - c->since > std::chrono::milliseconds(I->cfg.auth_timeout_ms)) {
+                    if (I->cfg.verbose) std::cerr << "[SOCKET] auth read failed from " << c->peer << "\n";
+                    c->closing = true;
+                }
+            }
+            // a blocking pin rejects every line for every client: no waiting for the tick
+            const bool pin_wake = I->pin_wake.exchange(false);
+            if (pin_wake || now >= next_check) {
+                if (now >= next_check) next_check = now + std::chrono::milliseconds(50);
+                check_clients(I, now);
+            }
+            drop_closed(I);
 
-            // per requirement: if send failed, we DROP the batch (no preservation)
-            (void)ok;
+            if (I->cfg.stats_interval_ms && now >= next_stats) {
+                next_stats = now + std::chrono::milliseconds(I->cfg.stats_interval_ms);
+                if (I->live_count.load()) self->print_stats(std::cerr);
+            }
         }
+        for (auto& c : I->conns) c->closing = true;
+        drop_closed(I);
     }
 
 } // namespace anon
@@ -345,27 +1284,42 @@ void SocketRelay::start() {
     Impl* I = reinterpret_cast<Impl*>(impl_);
     if (I->running.load()) return;
 
-    if (I->cfg.auth_token.empty()) {
+    const bool unix_sock = I->cfg.transport != SocketRelay::Transport::Tcp;
+    if (I->cfg.auth_token.empty() && !(unix_sock && I->cfg.allow_uid >= 0)) {
         throw std::runtime_error("SocketRelay: auth_token required");
     }
+    if (I->cfg.max_clients == 0) I->cfg.max_clients = 1;
+    I->retain = I->cfg.retain_bytes != 0;
+    I->data.assign(round_pow2(std::max(I->cfg.ring_bytes, I->cfg.retain_bytes), 64 * 1024), 0);
+    I->index.assign(round_pow2(std::max(I->cfg.max_queue, I->cfg.retain_bytes / 64), 64), Impl::Entry{ 0, 0, 0 });
+    I->head_seq = I->tail_seq = I->head_bytes = I->tail_bytes = 0;
+    I->snap.init(I->cfg.snapshot_slots, I->cfg.snapshot_slot_bytes);
 
     // create listen socket
     uint16_t chosen = 0;
-    sock_t ls = create_listen_socket(I->cfg.bind_addr, I->cfg.port, chosen);
+    I->unix_sock = unix_sock;
+    I->seqpacket = I->cfg.transport == SocketRelay::Transport::UnixSeqpacket;
+    sock_t ls = unix_sock ? create_unix_listen_socket(I->cfg.unix_path, I->seqpacket)
+        : create_listen_socket(I->cfg.bind_addr, I->cfg.port, chosen);
     if (ls == INVALID_SOCK) {
-        throw std::runtime_error("SocketRelay: failed to bind/listen on " + I->cfg.bind_addr);
+        throw std::runtime_error("SocketRelay: failed to bind/listen on " + (unix_sock ? I->cfg.unix_path : I->cfg.bind_addr));
     }
     I->listen_sock = ls;
     I->listen_port = chosen;
+    I->rbuf.assign(I->seqpacket ? 64 * 1024 : 4096, 0);
+    if (!open_waker(I)) {
+        close_waker(I);
+        close_sock(I->listen_sock);
+        I->listen_sock = INVALID_SOCK;
+        throw std::runtime_error("SocketRelay: cannot create the event loop");
+    }
 
     I->running.store(true);
-    // accept thread
-    I->accept_thread = std::thread([I]() { accept_loop(I); });
-    // worker thread
-    I->worker_thread = std::thread([I]() { worker_loop(I); });
+    I->loop_thread = std::thread([I, this]() { event_loop(I, this); });
 
     if (I->cfg.verbose) {
-        std::cerr << "[SOCKET] listening " << I->cfg.bind_addr << ":" << I->listen_port << "\n";
+        if (unix_sock) std::cerr << "[SOCKET] listening unix:" << I->cfg.unix_path << (I->seqpacket ? " (seqpacket)" : "") << "\n";
+        else std::cerr << "[SOCKET] listening " << I->cfg.bind_addr << ":" << I->listen_port << "\n";
     }
 }
 
@@ -375,53 +1329,89 @@ void SocketRelay::stop() {
     if (!I->running.load()) return;
 
     I->running.store(false);
-    // Wake worker
-    I->queue_cv.notify_all();
+    wake(I);
+    if (I->loop_thread.joinable()) I->loop_thread.join();
 
-    // Close listen socket to break accept
-    if (I->listen_sock != INVALID_SOCK) {
-        close_sock(I->listen_sock);
-        I->listen_sock = INVALID_SOCK;
-    }
+    close_sock(I->listen_sock);
+    I->listen_sock = INVALID_SOCK;
+    close_waker(I);
+#ifndef _WIN32
+    if (I->unix_sock) ::unlink(I->cfg.unix_path.c_str());
+#endif
+}
 
-    // Close client
-    {
-        std::lock_guard<std::mutex> lk(I->client_mtx);
-        if (I->client_sock != INVALID_SOCK) {
-            close_sock(I->client_sock);
-            I->client_sock = INVALID_SOCK;
-            I->client_connected.store(false);
-        }
+bool SocketRelay::notify(const RecordMeta& meta, std::string_view csvLine) {
+    if (!impl_) return false;
+    Impl* I = reinterpret_cast<Impl*>(impl_);
+    if (!I->snap.count && !I->retain && !I->live_count.load(std::memory_order_relaxed)) {
+        return true; // drop while disconnected (by design, not back-pressure)
     }
 
-    if (I->accept_thread.joinable()) I->accept_thread.join();
-    if (I->worker_thread.joinable()) I->worker_thread.join();
-}
+    const bool add_nl = csvLine.empty() || csvLine.back() != '\n';
+    const uint64_t len = csvLine.size() + (add_nl ? 1 : 0);
+    bool need_wake = false;
+    {
+        std::lock_guard<std::mutex> lk(I->clients_mtx);
+        const bool snap_only = I->live.empty() && !I->retain;
+        // stamped with the ring position the line takes (a rejected line is in no stream)
+        I->snap.put(meta.token, meta.type, add_nl ? csvLine : csvLine.substr(0, csvLine.size() - 1),
+            snap_only ? I->head_seq : I->head_seq + 1);
+        if (snap_only) return true;   // only the snapshot while disconnected
+        if (len > I->data.size()) { ++I->rejected; return false; }
 
-void SocketRelay::notify(const std::string& csvLine) {
-    if (!impl_) return;
-    Impl* I = reinterpret_cast<Impl*>(impl_);
-    if (!I->client_connected.load()) {
-        if (I->cfg.verbose) {
-            std::cerr << "[SOCKET] notify: no client connected, dropping line\n";
+        // make room: evict the oldest lines unless a client is sending from them
+        while (I->head_seq - I->tail_seq >= I->index.size() || I->head_bytes + len - I->tail_bytes > I->data.size()) {
+            for (Client* c : I->live) {
+                if (c->pin <= I->tail_seq) {
+                    // the loop sees to it: a zerocopy pin whose completion is not coming (the peer
+                    // stopped reading) would otherwise reject every line for every client
+                    if (!c->pin_blocked) { c->pin_blocked = true; I->pin_wake.store(true); wake(I); }
+                    ++I->rejected;
+                    return false;
+                }
+            }
+            const Impl::Entry& e = I->entry(I->tail_seq);
+            for (Client* c : I->live) {
+                if (c->next_seq != I->tail_seq) continue;
+                // this client has not sent the line yet: it loses it (and with SkipToLatest its backlog)
+                const uint64_t resume = (I->cfg.overflow == SocketRelay::Overflow::DropOldest) ? I->tail_seq + 1 : I->head_seq;
+                for (uint64_t k = I->tail_seq; k < resume; ++k) {
+                    const Impl::Entry& d = I->entry(k);
+                    if (c->filter.match(d.token, d.type)) ++c->dropped;
+                }
+                c->next_seq = resume;
+            }
+            I->tail_bytes = e.end;
+            ++I->tail_seq;
         }
-        return; // drop while disconnected
-    }
 
-    std::unique_lock<std::mutex> lk(I->queue_mtx);
-    if (I->q.size() >= I->cfg.max_queue) {
-        // drop oldest
-        if (I->cfg.verbose) {
-            std::cerr << "[SOCKET] notify: queue full (" << I->q.size() << "), dropping oldest\n";
+        // single copy into the ring (wrapping)
+        const uint64_t mask = I->data.size() - 1;
+        const size_t off = static_cast<size_t>(I->head_bytes & mask);
+        const size_t n1 = std::min(csvLine.size(), I->data.size() - off);
+        std::memcpy(I->data.data() + off, csvLine.data(), n1);
+        if (n1 < csvLine.size()) std::memcpy(I->data.data(), csvLine.data() + n1, csvLine.size() - n1);
+        if (add_nl) I->data[static_cast<size_t>((I->head_bytes + csvLine.size()) & mask)] = '\n';
+        I->head_bytes += len;
+        I->index[I->head_seq & (I->index.size() - 1)] = Impl::Entry{ I->head_bytes, meta.token, meta.type };
+        ++I->head_seq;
+
+        for (Client* c : I->live) {
+            if (!c->filter.match(meta.token, meta.type)) continue;
+            c->lag_hwm = std::max(c->lag_hwm, I->head_seq - c->next_seq);
+            if (c->idle) {                      // the loop is not sending to it
+                c->idle = false;
+                c->behind_since = Clock::now();
+                need_wake = true;
+            }
+            else if (I->head_seq >= c->wake_seq || I->head_bytes >= c->wake_bytes) {   // lingering frame is full
+                c->wake_seq = c->wake_bytes = UINT64_MAX;
+                need_wake = true;
+            }
         }
-        I->q.pop_front();
     }
-    I->q.emplace_back(csvLine);
-    if (I->cfg.verbose) {
-        std::cerr << "[SOCKET] notify: enqueued, qsize=" << I->q.size() << "\n";
-    }
-    lk.unlock();
-    I->queue_cv.notify_one();
+    if (need_wake) wake(I);
+    return true;
 }
 
 
@@ -430,3 +1420,68 @@ uint16_t SocketRelay::listening_port() const {
     Impl* I = reinterpret_cast<Impl*>(impl_);
     return I->listen_port;
 }
+
+size_t SocketRelay::clients() const {
+    if (!impl_) return 0;
+    Impl* I = reinterpret_cast<Impl*>(impl_);
+    return I->live_count.load();
+}
+
+uint64_t SocketRelay::rejected() const {
+    if (!impl_) return 0;
+    Impl* I = reinterpret_cast<Impl*>(impl_);
+    std::lock_guard<std::mutex> lk(I->clients_mtx);
+    return I->rejected;
+}
+
+std::vector<SocketRelay::ClientStats> SocketRelay::stats() const {
+    std::vector<ClientStats> v;
+    if (!impl_) return v;
+    Impl* I = reinterpret_cast<Impl*>(impl_);
+    const auto now = Clock::now();
+    std::lock_guard<std::mutex> lk(I->clients_mtx);
+    for (const Client* c : I->live) {
+        ClientStats s;
+        s.id = c->id;
+        s.peer = c->peer;
+        s.lines = c->lines;
+        s.bytes = c->bytes;
+        s.dropped = c->dropped;
+        s.lag = I->head_seq - c->next_seq;
+        s.lag_bytes = I->head_bytes - I->line_start(c->next_seq);
+        s.lag_hwm = c->lag_hwm;
+        s.sndq = c->sndq;
+        s.zc_sends = c->zc_sends;
+        s.zc_copied = c->zc_copied;
+        s.snap_lines = c->snap_lines;
+        s.lzo = c->lzo;
+        s.connected_ms = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(now - c->since).count());
+        v.push_back(s);
+    }
+    return v;
+}
+
+void SocketRelay::print_stats(std::ostream& os) const {
+    if (!impl_) return;
+    Impl* I = reinterpret_cast<Impl*>(impl_);
+    std::vector<ClientStats> v = stats();
+    std::ostringstream ss;
+    {
+        std::lock_guard<std::mutex> lk(I->clients_mtx);
+        ss << "[SOCKET] ring lines=" << (I->head_seq - I->tail_seq) << "/" << I->index.size()
+            << " bytes=" << (I->head_bytes - I->tail_bytes) << "/" << I->data.size()
+            << " seq=" << I->tail_seq << ".." << I->head_seq << " rejected=" << I->rejected << " evicted=" << I->evictions;
+        if (I->snap.count) ss << " snapshot=" << I->snap.used << "/" << I->snap.count << " snapshot_misses=" << I->snap.misses;
+        ss << "\n";
+    }
+    for (const ClientStats& s : v) {
+        ss << "[SOCKET] client " << s.id << " " << s.peer << " lines=" << s.lines << " bytes=" << s.bytes
+            << " dropped=" << s.dropped << " lag=" << s.lag << " lag_bytes=" << s.lag_bytes << " lag_hwm=" << s.lag_hwm
+            << " sndq=" << s.sndq << " snapshot=" << s.snap_lines;
+        if (s.lzo) ss << " format=lzo";
+        if (s.zc_sends) ss << " zc_sends=" << s.zc_sends << " zc_copied=" << s.zc_copied;
+        ss
+            << " connected_ms=" << s.connected_ms << "\n";
+    }
+    os << ss.str();
+}
@@ -1,42 +1,133 @@
 #pragma once
-// SocketRelay  single-client socket IPC for HermesPortal v1.4.1
+// SocketRelay  multi-client socket IPC for HermesPortal
+// One event-loop thread (epoll on Linux, WSAPoll/poll elsewhere) accepts clients, runs the
+// AUTH handshake and writes to every authenticated client with non-blocking sends.
+// notify() copies each line once into a shared broadcast ring; every client keeps a cursor
+// into it and is sent straight from ring memory (writev). A client that falls more than the
+// ring behind the writer loses its own oldest lines; the others and the caller never wait.
+// A client that stays behind or lets unsent bytes pile up can be evicted (evict_* below).
+//
+// Protocol: the client sends "AUTH <token>\n" and gets "OK\n" (or "ERR auth" / "ERR busy" and
+// a close), then CSV lines. It may then narrow what it gets at any time (not acknowledged):
+//   SUB <token,...|*>    UNSUB <token,...|*>    TYPES <7208,7202,...|*>
+// A new client gets every token and type until its first SUB/UNSUB/TYPES.
+// Every ring line has a sequence number (monotonic from start()). For reconnects:
+//   SEQ                  every following stream line comes as "<seq> <csv>"
+//   RESUME <seq>         "#RESUME <seq>\n" and the stream from line seq on, or when that line
+//                        is no longer retained "#GAP <seq> <oldest>\n" and the stream from the
+//                        oldest line kept; sent with AUTH it replaces the snapshot
+//   FORMAT lzo           sent with AUTH: "OK lzo\n", then LZO-compressed batches instead of
+//                        text (SocketFrames.h; not on seqpacket). Otherwise "ERR format\n"
+// With snapshot_slots > 0 the relay keeps the latest line per (token, type), also while
+// nobody is connected. Right after AUTH and the commands sent along with it, the client gets
+//   #SNAPSHOT <n>\n  <n latest lines its filter selects>  #LIVE <seq>\n
+// and then the stream, starting with ring line seq: no update is missed or repeated.
 // See implementation in src/SocketRelay.cpp
 
 #include <string>
+#include <string_view>
+#include <vector>
+#include <ostream>
 #include <atomic>
 #include <cstdint>
 
+#include "includes/record_meta.h"
+
 class SocketRelay {
 public:
+    // What happens to a client whose cursor falls out of the ring (it lags by more than
+    // max_queue lines or ring_bytes bytes):
+    //   DropOldest:   it continues from the oldest line still in the ring
+    //   SkipToLatest: it drops its whole backlog and continues with the next new line
+    enum class Overflow { DropOldest, SkipToLatest };
+
+    // Listener:
+    //   Tcp:           bind_addr:port
+    //   UnixStream:    AF_UNIX stream socket at unix_path (POSIX)
+    //   UnixSeqpacket: AF_UNIX SOCK_SEQPACKET at unix_path (POSIX); each message holds whole
+    //                  lines, at most batch_bytes unless a single line is longer
+    enum class Transport { Tcp, UnixStream, UnixSeqpacket };
+
     struct Config {
+        Transport transport = Transport::Tcp;
         std::string bind_addr = "127.0.0.1";
         uint16_t port = 0;                      // 0 => ephemeral port auto-selected
-        std::string auth_token;                 // mandatory when using socket output
-        size_t max_queue = 4096;                // messages (drop-oldest)
-        size_t batch_bytes = 16 * 1024;         // batch bytes per send
-        bool replace_client = true;             // replace existing client on new connect
+        std::string unix_path;                  // Unix transports; an existing socket file is replaced
+        std::string auth_token;                 // mandatory unless allow_uid is set (Unix)
+        long allow_uid = -1;                    // Unix: a peer with this uid passes AUTH without the token
+        size_t max_clients = 16;                // further connections get "ERR busy"
+        size_t max_queue = 4096;                // lines kept in the ring (rounded up to a power of two)
+        size_t ring_bytes = 4 << 20;            // ring data bytes (rounded up to a power of two)
+        Overflow overflow = Overflow::DropOldest;
+        size_t batch_bytes = 16 * 1024;         // bytes handed to one writev
+        size_t frame_bytes = 64 * 1024;         // FORMAT lzo: raw bytes per frame (a longer line gets its own)
+        unsigned frame_linger_ms = 10;          // FORMAT lzo: a frame short of frame_bytes waits this long for more
+        unsigned auth_timeout_ms = 3000;        // AUTH line must arrive within this
+        int sndbuf = 0;                         // SO_SNDBUF per client (0 => OS default)
+        bool nodelay = true;                    // TCP_NODELAY per client
+        size_t zerocopy_bytes = 0;              // sends of at least this many bytes use MSG_ZEROCOPY (Linux; 0 => off)
+        size_t evict_queue_bytes = 0;           // disconnect a client holding more unsent bytes (0 => never)
+        unsigned evict_lag_ms = 0;              // disconnect a client behind for longer than this (0 => never)
+        size_t snapshot_slots = 16384;          // (token, type) pairs kept for late joiners (0 => off)
+        size_t snapshot_slot_bytes = 512;       // per pair, 24-byte header included
+        size_t retain_bytes = 0;                // RESUME window: the ring is at least this big, holds retain_bytes/64
+                                                // lines and keeps filling with nobody connected (0 => only while
+                                                // clients are)
+        unsigned stats_interval_ms = 0;         // 0 => per-client stats only via print_stats()
         bool verbose = false;                   // print small logs to stderr
     };
 
+    // Per authenticated client (see stats()).
+    struct ClientStats {
+        uint64_t id = 0;                        // connection number since start
+        std::string peer;                       // "ip:port"
+        uint64_t lines = 0;                     // lines sent
+        uint64_t bytes = 0;                     // bytes sent
+        uint64_t dropped = 0;                   // subscribed lines lost after falling out of the ring
+        uint64_t lag = 0;                       // ring lines the cursor trails the writer by (filtered included)
+        uint64_t lag_bytes = 0;                 // same, in bytes
+        uint64_t lag_hwm = 0;                   // lag high-water mark (lines)
+        uint64_t sndq = 0;                      // bytes in the kernel send queue + torn line (Linux)
+        uint64_t zc_sends = 0;                  // MSG_ZEROCOPY sends
+        uint64_t zc_copied = 0;                 // of those, copied by the kernel anyway
+        uint64_t snap_lines = 0;                // lines in the snapshot sent after AUTH
+        bool lzo = false;                       // FORMAT lzo negotiated (lines: framed so far)
+        uint64_t connected_ms = 0;              // time since AUTH succeeded
+    };
+
     explicit SocketRelay(const Config& cfg);
     ~SocketRelay();
 
-    // start background accept/worker thread (throws on bind error)
+    // start the event-loop thread (throws on bind error)
     void start();
 
-    // stop threads and close sockets (blocks until exit)
+    // stop the event loop and close all sockets (blocks until exit)
     void stop();
 
-    // notify relay of a new CSV line (called from parser path).
-    // Behavior:
-    //  - if client is connected, enqueues line (bounded queue, drop-oldest)
-    //  - if no client connected, does nothing (no buffering)
-    // This call is fast/lock-protected.
-    void notify(const std::string& csvLine);
+    // notify relay of a new CSV line (called from the decode path, any thread).
+    // meta.token / meta.type select the clients it goes to (their SUB/TYPES filters).
+    // The line replaces the (token, type) snapshot entry and is copied once into the broadcast
+    // ring for every authenticated client; with no client connected it only updates the
+    // snapshot. Never waits on a socket.
+    // Returns false when the line was rejected: longer than the ring, or the ring space it
+    // needs is being sent from at that moment.
+    bool notify(const RecordMeta& meta, std::string_view csvLine);
 
-    // get the listening port (0 if not started or error)
+    // get the listening port (0 if not started, error or a Unix transport)
     uint16_t listening_port() const;
 
+    // authenticated clients right now
+    size_t clients() const;
+
+    // lines rejected by notify() since start
+    uint64_t rejected() const;
+
+    std::vector<ClientStats> stats() const;
+    void print_stats(std::ostream& os) const;
+
 private:
     void* impl_; // opaque pointer to implementation
+
+    SocketRelay(const SocketRelay&) = delete;
+    SocketRelay& operator=(const SocketRelay&) = delete;
 };
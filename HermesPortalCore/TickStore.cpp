@@ -0,0 +1,653 @@
+// src/TickStore.cpp
+// Columnar daily tick segments: builder, memory-mapped reader, query tool (see TickStore.h).
+
+#include "TickStore.h"
+#include "includes/hermes_core.h"
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <cstring>
+#include <ctime>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+    using namespace TickStore;
+
+    // ----------------- schemas -----------------
+    // One column: name, storage, decimal places, CSV field of the handler line (-1 = row time)
+    struct ColSpec { const char* name; Kind kind; uint8_t scale; int field; };
+
+    // 7208: Token,Type,LTP,ATP,BDP,BDQ,ASP,ASQ,BQ,SQ,Time,B1P,B1Q..B5P,B5Q,A1P,A1Q..A5P,A5Q
+    // (BDP/BDQ/ASP/ASQ repeat level 1; Time is the row time)
+    static const ColSpec k7208[] = {
+        { "token", Kind::U32, 0, 0 }, { "time", Kind::U32, 0, -1 },
+        { "ltp", Kind::I32, 2, 2 }, { "atp", Kind::I32, 2, 3 },
+        { "buy_qty", Kind::I64, 0, 8 }, { "sell_qty", Kind::I64, 0, 9 },
+        { "bid1_px", Kind::I32, 2, 11 }, { "bid1_qty", Kind::I32, 0, 12 },
+        { "bid2_px", Kind::I32, 2, 13 }, { "bid2_qty", Kind::I32, 0, 14 },
+        { "bid3_px", Kind::I32, 2, 15 }, { "bid3_qty", Kind::I32, 0, 16 },
+        { "bid4_px", Kind::I32, 2, 17 }, { "bid4_qty", Kind::I32, 0, 18 },
+        { "bid5_px", Kind::I32, 2, 19 }, { "bid5_qty", Kind::I32, 0, 20 },
+        { "ask1_px", Kind::I32, 2, 21 }, { "ask1_qty", Kind::I32, 0, 22 },
+        { "ask2_px", Kind::I32, 2, 23 }, { "ask2_qty", Kind::I32, 0, 24 },
+        { "ask3_px", Kind::I32, 2, 25 }, { "ask3_qty", Kind::I32, 0, 26 },
+        { "ask4_px", Kind::I32, 2, 27 }, { "ask4_qty", Kind::I32, 0, 28 },
+        { "ask5_px", Kind::I32, 2, 29 }, { "ask5_qty", Kind::I32, 0, 30 },
+    };
+
+    // 7202: Token,Type,MarketType,OI (time = wall clock at write)
+    static const ColSpec k7202[] = {
+        { "token", Kind::U32, 0, 0 }, { "time", Kind::U32, 0, -1 },
+        { "market", Kind::U32, 0, 2 }, { "oi", Kind::U32, 0, 3 },
+    };
+
+    // CT: token,CT,ltp,atp,bid1,bid1_q,ask1,ask1_q,tot_buy,tot_sell,lttime,volume,open,high,low,close
+    static const ColSpec kCT[] = {
+        { "token", Kind::U32, 0, 0 }, { "time", Kind::U32, 0, -1 },
+        { "ltp", Kind::I32, 2, 2 }, { "atp", Kind::I32, 2, 3 },
+        { "bid1_px", Kind::I32, 2, 4 }, { "bid1_qty", Kind::U32, 0, 5 },
+        { "ask1_px", Kind::I32, 2, 6 }, { "ask1_qty", Kind::U32, 0, 7 },
+        { "buy_qty", Kind::U32, 0, 8 }, { "sell_qty", Kind::U32, 0, 9 },
+        { "trade_hhmmss", Kind::U32, 0, 10 }, { "volume", Kind::U32, 0, 11 },
+        { "open", Kind::I32, 2, 12 }, { "high", Kind::I32, 2, 13 },
+        { "low", Kind::I32, 2, 14 }, { "close", Kind::I32, 2, 15 },
+    };
+
+    // PN: token,PN,ltp,(bid,qty)x5,(ask,qty)x5
+    static const ColSpec kPN[] = {
+        { "token", Kind::U32, 0, 0 }, { "time", Kind::U32, 0, -1 },
+        { "ltp", Kind::I32, 2, 2 },
+        { "bid1_px", Kind::I32, 2, 3 }, { "bid1_qty", Kind::U32, 0, 4 },
+        { "bid2_px", Kind::I32, 2, 5 }, { "bid2_qty", Kind::U32, 0, 6 },
+        { "bid3_px", Kind::I32, 2, 7 }, { "bid3_qty", Kind::U32, 0, 8 },
+        { "bid4_px", Kind::I32, 2, 9 }, { "bid4_qty", Kind::U32, 0, 10 },
+        { "bid5_px", Kind::I32, 2, 11 }, { "bid5_qty", Kind::U32, 0, 12 },
+        { "ask1_px", Kind::I32, 2, 13 }, { "ask1_qty", Kind::U32, 0, 14 },
+        { "ask2_px", Kind::I32, 2, 15 }, { "ask2_qty", Kind::U32, 0, 16 },
+        { "ask3_px", Kind::I32, 2, 17 }, { "ask3_qty", Kind::U32, 0, 18 },
+        { "ask4_px", Kind::I32, 2, 19 }, { "ask4_qty", Kind::U32, 0, 20 },
+        { "ask5_px", Kind::I32, 2, 21 }, { "ask5_qty", Kind::U32, 0, 22 },
+    };
+
+    struct Schema {
+        const ColSpec* cols = nullptr;
+        size_t count = 0;
+    };
+
+    static Schema schema_for(uint16_t type) {
+        if (type == 7208) return { k7208, sizeof(k7208) / sizeof(k7208[0]) };
+        if (type == 7202) return { k7202, sizeof(k7202) / sizeof(k7202[0]) };
+        if (type == ICODE_CT) return { kCT, sizeof(kCT) / sizeof(kCT[0]) };
+        if (type == ICODE_PN) return { kPN, sizeof(kPN) / sizeof(kPN[0]) };
+        return {};
+    }
+
+    static uint8_t width_of(Kind k) { return k == Kind::I64 ? 8 : 4; }
+
+    static uint64_t align64(uint64_t v) { return (v + 63) & ~uint64_t(63); }
+
+    // "-123.45" -> -12345 at scale 2 (extra decimals rounded half away from zero)
+    static bool parse_fixed(std::string_view s, uint8_t scale, int64_t& out) {
+        size_t i = 0;
+        bool neg = false;
+        if (i < s.size() && (s[i] == '-' || s[i] == '+')) { neg = (s[i] == '-'); ++i; }
+        int64_t ip = 0;
+        size_t digits = 0;
+        for (; i < s.size() && s[i] >= '0' && s[i] <= '9'; ++i, ++digits) {
+            if (ip > (INT64_MAX - 9) / 10) return false;
+            ip = ip * 10 + (s[i] - '0');
+        }
+        int64_t frac = 0;
+        uint8_t fd = 0;
+        bool round_up = false;
+        if (i < s.size() && s[i] == '.') {
+            for (++i; i < s.size() && s[i] >= '0' && s[i] <= '9'; ++i, ++digits) {
+                if (fd < scale) { frac = frac * 10 + (s[i] - '0'); ++fd; }
+                else if (fd == scale) { round_up = (s[i] >= '5'); ++fd; }
+            }
+        }
+        if (!digits || i != s.size()) return false;
+        for (uint8_t k = (fd < scale ? fd : scale); k < scale; ++k) frac *= 10;
+        int64_t mul = 1;
+        for (uint8_t k = 0; k < scale; ++k) mul *= 10;
+        if (ip > INT64_MAX / mul - 1) return false;
+        int64_t v = ip * mul + frac + (round_up ? 1 : 0);
+        out = neg ? -v : v;
+        return true;
+    }
+
+    static void put_value(std::ostream& os, int64_t v, uint8_t scale) {
+        if (!scale) { os << v; return; }
+        int64_t mul = 1;
+        for (uint8_t k = 0; k < scale; ++k) mul *= 10;
+        if (v < 0) { os << '-'; v = -v; }
+        std::string frac = std::to_string(v % mul);
+        os << (v / mul) << '.' << std::string(scale - frac.size(), '0') << frac;
+    }
+
+    static int64_t get_value(const uint8_t* col, Kind k, size_t row) {
+        if (k == Kind::I64) { int64_t v; std::memcpy(&v, col + row * 8, 8); return v; }
+        if (k == Kind::I32) { int32_t v; std::memcpy(&v, col + row * 4, 4); return v; }
+        uint32_t v; std::memcpy(&v, col + row * 4, 4); return v;
+    }
+
+    static uint64_t steady_ms() {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+    }
+
+    // ----------------- builder -----------------
+    struct BuilderImpl {
+        uint16_t type = 0;
+        Schema schema;
+        std::vector<std::vector<uint8_t>> cols;     // rows x width bytes each
+        std::vector<uint32_t> token, ts;            // sort keys
+        std::vector<int64_t> scratch;
+        std::vector<std::string_view> fields;
+        uint32_t day = 0;
+        uint64_t opened_ms = 0;
+    };
+
+    // ----------------- read-only mapping -----------------
+    struct Mapping {
+        const uint8_t* base = nullptr;
+        size_t size = 0;
+#ifdef _WIN32
+        HANDLE file = INVALID_HANDLE_VALUE;
+        HANDLE map = nullptr;
+#else
+        int fd = -1;
+#endif
+
+        bool open(const std::string& path) {
+#ifdef _WIN32
+            file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+            if (file == INVALID_HANDLE_VALUE) return false;
+            LARGE_INTEGER cur{};
+            GetFileSizeEx(file, &cur);
+            size = static_cast<size_t>(cur.QuadPart);
+            if (size < sizeof(FileHeader)) { close(); return false; }
+            map = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+            if (!map) { close(); return false; }
+            base = static_cast<const uint8_t*>(MapViewOfFile(map, FILE_MAP_READ, 0, 0, size));
+            if (!base) { close(); return false; }
+            return true;
+#else
+            fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+            if (fd < 0) return false;
+            struct stat st {};
+            if (fstat(fd, &st) != 0) { close(); return false; }
+            size = static_cast<size_t>(st.st_size);
+            if (size < sizeof(FileHeader)) { close(); return false; }
+            void* p = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+            if (p == MAP_FAILED) { close(); return false; }
+            base = static_cast<const uint8_t*>(p);
+            return true;
+#endif
+        }
+
+        void close() {
+#ifdef _WIN32
+            if (base) UnmapViewOfFile(base);
+            if (map) CloseHandle(map);
+            if (file != INVALID_HANDLE_VALUE) CloseHandle(file);
+            map = nullptr; file = INVALID_HANDLE_VALUE;
+#else
+            if (base) munmap(const_cast<uint8_t*>(base), size);
+            if (fd >= 0) ::close(fd);
+            fd = -1;
+#endif
+            base = nullptr; size = 0;
+        }
+    };
+
+    struct SegmentImpl {
+        Mapping m;
+        FileHeader hdr{};
+        std::vector<ColumnDesc> cols;
+        const TokenEntry* tokens = nullptr;
+        const uint32_t* time = nullptr;
+    };
+
+} // namespace anon
+
+namespace TickStore {
+
+    std::string type_name(uint16_t type) {
+        if (type == 7208 || type == 7202) return std::to_string(type);
+        if (type == ICODE_CT) return "CT";
+        if (type == ICODE_PN) return "PN";
+        return std::string();
+    }
+
+    uint32_t day_of(uint32_t unixsec) {
+        std::time_t tt = static_cast<std::time_t>(unixsec);
+        std::tm tm{};
+#ifdef _WIN32
+        localtime_s(&tm, &tt);
+#else
+        localtime_r(&tt, &tm);
+#endif
+        return static_cast<uint32_t>((tm.tm_year + 1900) * 10000 + (tm.tm_mon + 1) * 100 + tm.tm_mday);
+    }
+
+    // ----------------- SegmentBuilder -----------------
+    SegmentBuilder::SegmentBuilder(uint16_t type) {
+        BuilderImpl* I = new BuilderImpl();
+        I->type = type;
+        I->schema = schema_for(type);
+        I->cols.resize(I->schema.count);
+        I->scratch.resize(I->schema.count);
+        impl_ = I;
+    }
+
+    SegmentBuilder::~SegmentBuilder() {
+        delete reinterpret_cast<BuilderImpl*>(impl_);
+        impl_ = nullptr;
+    }
+
+    bool SegmentBuilder::add(uint32_t ts, std::string_view csv) {
+        BuilderImpl* I = reinterpret_cast<BuilderImpl*>(impl_);
+        if (!I->schema.count) return false;
+        while (!csv.empty() && (csv.back() == '\n' || csv.back() == '\r')) csv.remove_suffix(1);
+
+        I->fields.clear();
+        size_t b = 0;
+        while (true) {
+            size_t c = csv.find(',', b);
+            I->fields.push_back(csv.substr(b, c == std::string_view::npos ? std::string_view::npos : c - b));
+            if (c == std::string_view::npos) break;
+            b = c + 1;
+        }
+
+        // parse the whole row first: a malformed field drops the row, not just the value
+        for (size_t i = 0; i < I->schema.count; ++i) {
+            const ColSpec& c = I->schema.cols[i];
+            if (c.field < 0) { I->scratch[i] = ts; continue; }
+            if (static_cast<size_t>(c.field) >= I->fields.size()) return false;
+            int64_t v = 0;
+            if (!parse_fixed(I->fields[c.field], c.scale, v)) return false;
+            if (c.kind == Kind::I32 && (v < INT32_MIN || v > INT32_MAX)) return false;
+            if (c.kind == Kind::U32 && (v < 0 || v > static_cast<int64_t>(UINT32_MAX))) return false;
+            I->scratch[i] = v;
+        }
+
+        if (I->token.empty()) I->opened_ms = steady_ms();
+        for (size_t i = 0; i < I->schema.count; ++i) {
+            std::vector<uint8_t>& col = I->cols[i];
+            const size_t at = col.size();
+            if (I->schema.cols[i].kind == Kind::I64) {
+                col.resize(at + 8);
+                std::memcpy(&col[at], &I->scratch[i], 8);
+            }
+            else {
+                const uint32_t v = static_cast<uint32_t>(I->scratch[i]);
+                col.resize(at + 4);
+                std::memcpy(&col[at], &v, 4);
+            }
+        }
+        I->token.push_back(static_cast<uint32_t>(I->scratch[0]));
+        I->ts.push_back(ts);
+        return true;
+    }
+
+    size_t SegmentBuilder::rows() const { return reinterpret_cast<BuilderImpl*>(impl_)->token.size(); }
+    uint32_t SegmentBuilder::day() const { return reinterpret_cast<BuilderImpl*>(impl_)->day; }
+    uint64_t SegmentBuilder::opened_ms() const { return reinterpret_cast<BuilderImpl*>(impl_)->opened_ms; }
+
+    void SegmentBuilder::set_day(uint32_t day) {
+        BuilderImpl* I = reinterpret_cast<BuilderImpl*>(impl_);
+        if (I->token.empty()) I->day = day;
+    }
+
+    uint64_t SegmentBuilder::write(const std::string& dir, const std::string& name) {
+        BuilderImpl* I = reinterpret_cast<BuilderImpl*>(impl_);
+        const uint32_t rows = static_cast<uint32_t>(I->token.size());
+        if (!rows) return 0;
+
+        // (token, time) order; stable keeps arrival order inside a second
+        std::vector<uint32_t> perm(rows);
+        for (uint32_t i = 0; i < rows; ++i) perm[i] = i;
+        std::stable_sort(perm.begin(), perm.end(), [I](uint32_t a, uint32_t b) {
+            if (I->token[a] != I->token[b]) return I->token[a] < I->token[b];
+            return I->ts[a] < I->ts[b];
+        });
+
+        std::vector<TokenEntry> toks;
+        FileHeader h{};
+        std::memcpy(h.magic, kMagic, sizeof(h.magic));
+        h.version = kVersion;
+        h.type = I->type;
+        h.day = I->day;
+        h.rows = rows;
+        h.min_ts = UINT32_MAX;
+        for (uint32_t r = 0; r < rows; ++r) {
+            const uint32_t tok = I->token[perm[r]], t = I->ts[perm[r]];
+            if (toks.empty() || toks.back().token != tok) {
+                TokenEntry e{};
+                e.token = tok; e.first_row = r; e.min_ts = t;
+                toks.push_back(e);
+            }
+            TokenEntry& e = toks.back();
+            ++e.rows;
+            e.max_ts = t;
+            h.min_ts = std::min(h.min_ts, t);
+            h.max_ts = std::max(h.max_ts, t);
+        }
+
+        const size_t ncol = I->schema.count;
+        h.columns = static_cast<uint32_t>(ncol);
+        h.tokens = static_cast<uint32_t>(toks.size());
+        h.columns_off = sizeof(FileHeader);
+        h.tokens_off = align64(h.columns_off + ncol * sizeof(ColumnDesc));
+        h.create_ns = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count());
+
+        std::vector<ColumnDesc> desc(ncol);
+        uint64_t off = align64(h.tokens_off + toks.size() * sizeof(TokenEntry));
+        for (size_t i = 0; i < ncol; ++i) {
+            const ColSpec& c = I->schema.cols[i];
+            std::strncpy(desc[i].name, c.name, sizeof(desc[i].name) - 1);
+            desc[i].kind = static_cast<uint8_t>(c.kind);
+            desc[i].width = width_of(c.kind);
+            desc[i].scale = c.scale;
+            desc[i].offset = off;
+            off = align64(off + static_cast<uint64_t>(rows) * desc[i].width);
+        }
+
+        std::filesystem::path final_path = std::filesystem::path(dir) / (name + ".col");
+        std::string tmp = final_path.string() + ".tmp";
+        uint64_t written = 0;
+        {
+            std::ofstream ofs(tmp, std::ios::binary | std::ios::trunc);
+            auto put = [&](const void* p, size_t n) {
+                ofs.write(static_cast<const char*>(p), static_cast<std::streamsize>(n));
+                written += n;
+            };
+            auto pad_to = [&](uint64_t pos) {
+                static const char zeros[64] = {};
+                while (written < pos) put(zeros, static_cast<size_t>(std::min<uint64_t>(64, pos - written)));
+            };
+            put(&h, sizeof(h));
+            put(desc.data(), ncol * sizeof(ColumnDesc));
+            pad_to(h.tokens_off);
+            put(toks.data(), toks.size() * sizeof(TokenEntry));
+            std::vector<uint8_t> out;
+            for (size_t i = 0; i < ncol; ++i) {
+                pad_to(desc[i].offset);
+                const size_t w = desc[i].width;
+                const uint8_t* src = I->cols[i].data();
+                out.resize(static_cast<size_t>(rows) * w);
+                for (uint32_t r = 0; r < rows; ++r) std::memcpy(&out[r * w], src + static_cast<size_t>(perm[r]) * w, w);
+                put(out.data(), out.size());
+            }
+            ofs.flush();
+            if (!ofs) written = 0;
+        }
+
+        for (auto& c : I->cols) c.clear();
+        I->token.clear();
+        I->ts.clear();
+        I->opened_ms = 0;
+
+        std::error_code ec;
+        if (written) std::filesystem::rename(tmp, final_path, ec);
+        if (!written || ec) {
+            std::filesystem::remove(tmp, ec);
+            return 0;
+        }
+        return written;
+    }
+
+    // ----------------- Segment -----------------
+    Segment::Segment() { impl_ = new SegmentImpl(); }
+
+    Segment::~Segment() {
+        close();
+        delete reinterpret_cast<SegmentImpl*>(impl_);
+        impl_ = nullptr;
+    }
+
+    bool Segment::open(const std::string& path) {
+        close();
+        SegmentImpl* I = reinterpret_cast<SegmentImpl*>(impl_);
+        if (!I->m.open(path)) return false;
+        const uint8_t* b = I->m.base;
+        const uint64_t size = I->m.size;
+        std::memcpy(&I->hdr, b, sizeof(FileHeader));
+        const FileHeader& h = I->hdr;
+        bool ok = std::memcmp(h.magic, kMagic, sizeof(kMagic)) == 0 && h.version == kVersion &&
+            h.columns_off + static_cast<uint64_t>(h.columns) * sizeof(ColumnDesc) <= size &&
+            h.tokens_off + static_cast<uint64_t>(h.tokens) * sizeof(TokenEntry) <= size &&
+            (h.tokens_off % alignof(TokenEntry)) == 0;
+        if (ok) {
+            I->cols.resize(h.columns);
+            std::memcpy(I->cols.data(), b + h.columns_off, h.columns * sizeof(ColumnDesc));
+            for (ColumnDesc& c : I->cols) {
+                c.name[sizeof(c.name) - 1] = '\0';
+                const Kind k = static_cast<Kind>(c.kind);
+                if ((k != Kind::U32 && k != Kind::I32 && k != Kind::I64) || c.width != width_of(k) ||
+                    (c.offset % 8) || c.offset + static_cast<uint64_t>(h.rows) * c.width > size) { ok = false; break; }
+            }
+        }
+        if (ok) {
+            I->tokens = reinterpret_cast<const TokenEntry*>(b + h.tokens_off);
+            for (uint32_t i = 0; i < h.tokens && ok; ++i) {
+                const TokenEntry& e = I->tokens[i];
+                ok = static_cast<uint64_t>(e.first_row) + e.rows <= h.rows;
+            }
+            const ColumnDesc* t = find_column("time");
+            ok = ok && t && t->kind == static_cast<uint8_t>(Kind::U32);
+            if (ok) I->time = reinterpret_cast<const uint32_t*>(b + t->offset);
+        }
+        if (!ok) close();
+        return ok;
+    }
+
+    void Segment::close() {
+        SegmentImpl* I = reinterpret_cast<SegmentImpl*>(impl_);
+        I->m.close();
+        I->hdr = FileHeader{};
+        I->cols.clear();
+        I->tokens = nullptr;
+        I->time = nullptr;
+    }
+
+    const FileHeader& Segment::header() const { return reinterpret_cast<SegmentImpl*>(impl_)->hdr; }
+    uint32_t Segment::rows() const { return header().rows; }
+    const std::vector<ColumnDesc>& Segment::columns() const { return reinterpret_cast<SegmentImpl*>(impl_)->cols; }
+    const TokenEntry* Segment::tokens() const { return reinterpret_cast<SegmentImpl*>(impl_)->tokens; }
+    const uint8_t* Segment::base() const { return reinterpret_cast<SegmentImpl*>(impl_)->m.base; }
+
+    const ColumnDesc* Segment::find_column(std::string_view name) const {
+        for (const ColumnDesc& c : columns()) if (name == c.name) return &c;
+        return nullptr;
+    }
+
+    const TokenEntry* Segment::find_token(uint32_t token) const {
+        const SegmentImpl* I = reinterpret_cast<SegmentImpl*>(impl_);
+        if (!I->tokens) return nullptr;
+        const TokenEntry* end = I->tokens + I->hdr.tokens;
+        const TokenEntry* it = std::lower_bound(I->tokens, end, token,
+            [](const TokenEntry& e, uint32_t t) { return e.token < t; });
+        return (it != end && it->token == token) ? it : nullptr;
+    }
+
+    bool Segment::range(uint32_t token, uint32_t from, uint32_t to, uint32_t& begin, uint32_t& end) const {
+        const SegmentImpl* I = reinterpret_cast<SegmentImpl*>(impl_);
+        const TokenEntry* e = find_token(token);
+        if (!e || e->max_ts < from || e->min_ts > to) return false;
+        const uint32_t* first = I->time + e->first_row;
+        const uint32_t* last = first + e->rows;
+        const uint32_t* lo = std::lower_bound(first, last, from);
+        const uint32_t* hi = std::upper_bound(lo, last, to);
+        begin = static_cast<uint32_t>(lo - I->time);
+        end = static_cast<uint32_t>(hi - I->time);
+        return begin < end;
+    }
+
+    // ----------------- DayReader -----------------
+    bool DayReader::open(const std::string& base, uint32_t day, const std::string& type) {
+        close();
+        std::filesystem::path dir = std::filesystem::path(base) / "ticks" / std::to_string(day) / type;
+        std::error_code ec;
+        std::vector<std::string> files;
+        for (std::filesystem::directory_iterator it(dir, ec), end; !ec && it != end; it.increment(ec)) {
+            if (it->path().extension() == ".col") files.push_back(it->path().string());
+        }
+        std::sort(files.begin(), files.end());
+        for (const std::string& f : files) {
+            std::unique_ptr<Segment> s(new Segment());
+            if (s->open(f)) segs_.push_back(std::move(s));
+            else std::cerr << "[TICK] skipping unreadable segment " << f << "\n";
+        }
+        return !segs_.empty();
+    }
+
+    uint64_t DayReader::rows() const {
+        uint64_t n = 0;
+        for (const auto& s : segs_) n += s->rows();
+        return n;
+    }
+
+} // namespace TickStore
+
+// ----------------- query tool -----------------
+namespace {
+
+    // unix seconds, or HH:MM:SS on day (local)
+    static bool parse_day_time(const std::string& s, uint32_t day, uint32_t& out) {
+        if (!s.empty() && s.find_first_not_of("0123456789") == std::string::npos) {
+            try { out = static_cast<uint32_t>(std::stoul(s)); }
+            catch (...) { return false; }
+            return true;
+        }
+        int hh = 0, mm = 0, ss = 0;
+        char c1 = 0, c2 = 0;
+        std::istringstream is(s);
+        if (!(is >> hh >> c1 >> mm >> c2 >> ss) || c1 != ':' || c2 != ':') return false;
+        std::tm tm{};
+        tm.tm_year = static_cast<int>(day / 10000) - 1900;
+        tm.tm_mon = static_cast<int>(day / 100 % 100) - 1;
+        tm.tm_mday = static_cast<int>(day % 100);
+        tm.tm_hour = hh; tm.tm_min = mm; tm.tm_sec = ss;
+        tm.tm_isdst = -1;
+        std::time_t tt = std::mktime(&tm);
+        if (tt < 0) return false;
+        out = static_cast<uint32_t>(tt);
+        return true;
+    }
+
+    static void print_rows(const TickStore::Segment& s, uint32_t b, uint32_t e, std::ostream& os) {
+        const auto& cols = s.columns();
+        // column<T> checks the width; take the raw bytes through the matching type
+        std::vector<const uint8_t*> ptr(cols.size());
+        for (size_t i = 0; i < cols.size(); ++i) {
+            ptr[i] = cols[i].width == 8 ? reinterpret_cast<const uint8_t*>(s.column<int64_t>(cols[i].name))
+                : reinterpret_cast<const uint8_t*>(s.column<uint32_t>(cols[i].name));
+        }
+        for (uint32_t r = b; r < e; ++r) {
+            for (size_t i = 0; i < cols.size(); ++i) {
+                if (i) os << ',';
+                put_value(os, get_value(ptr[i], static_cast<TickStore::Kind>(cols[i].kind), r), cols[i].scale);
+            }
+            os << '\n';
+        }
+    }
+
+} // namespace anon
+
+int RunTickQuery(int argc, char* argv[]) {
+    std::string base, type, from_s, to_s;
+    uint32_t day = 0, token = 0;
+    bool have_token = false, csv = false;
+    for (int i = 1; i < argc; ++i) {
+        std::string key = argv[i];
+        std::string val;
+        auto eq = key.find('=');
+        if (eq != std::string::npos) { val = key.substr(eq + 1); key = key.substr(0, eq); }
+        auto next = [&]() { if (val.empty() && i + 1 < argc) val = argv[++i]; return val; };
+        try {
+            if (key == "--tick-query") base = next();
+            else if (key == "--day") day = static_cast<uint32_t>(std::stoul(next()));
+            else if (key == "--type") type = next();
+            else if (key == "--token") { token = static_cast<uint32_t>(std::stoul(next())); have_token = true; }
+            else if (key == "--from") from_s = next();
+            else if (key == "--to") to_s = next();
+            else if (key == "--csv") csv = true;
+            else { std::cerr << "[FATAL] unknown tick-query option " << key << "\n"; return 1; }
+        }
+        catch (...) {
+            std::cerr << "[FATAL] invalid value for " << key << "\n";
+            return 1;
+        }
+    }
+    if (base.empty() || !day || type.empty()) {
+        std::cerr << "[FATAL] --tick-query needs <base> --day <YYYYMMDD> --type <7208|7202|CT|PN>\n";
+        return 1;
+    }
+    uint32_t from = 0, to = UINT32_MAX;
+    if ((!from_s.empty() && !parse_day_time(from_s, day, from)) || (!to_s.empty() && !parse_day_time(to_s, day, to))) {
+        std::cerr << "[FATAL] invalid --from/--to (unix seconds or HH:MM:SS)\n";
+        return 1;
+    }
+
+    auto t0 = std::chrono::steady_clock::now();
+    TickStore::DayReader day_rd;
+    if (!day_rd.open(base, day, type)) {
+        std::cerr << "[FATAL] no segments under " << base << "/ticks/" << day << "/" << type << "\n";
+        return 1;
+    }
+
+    std::cout.unsetf(std::ios::unitbuf);   // main sets unitbuf for interactive logging
+    uint64_t rows = 0;
+    if (csv) {
+        const auto& cols = day_rd.segment(0).columns();
+        for (size_t i = 0; i < cols.size(); ++i) std::cout << (i ? "," : "") << cols[i].name;
+        std::cout << '\n';
+    }
+    for (size_t si = 0; si < day_rd.segments(); ++si) {
+        const TickStore::Segment& s = day_rd.segment(si);
+        uint64_t seg_rows = 0;
+        if (have_token) {
+            uint32_t b = 0, e = 0;
+            if (s.range(token, from, to, b, e)) {
+                seg_rows = e - b;
+                if (csv) print_rows(s, b, e, std::cout);
+            }
+        }
+        else {
+            // every token's window (the token index keeps this a binary search per token)
+            for (uint32_t k = 0; k < s.header().tokens; ++k) {
+                uint32_t b = 0, e = 0;
+                if (!s.range(s.tokens()[k].token, from, to, b, e)) continue;
+                seg_rows += e - b;
+                if (csv) print_rows(s, b, e, std::cout);
+            }
+        }
+        rows += seg_rows;
+        if (!csv) {
+            std::cout << "[TICK] segment " << si << " rows=" << s.rows() << " tokens=" << s.header().tokens
+                << " time=" << s.header().min_ts << ".." << s.header().max_ts << " matched=" << seg_rows << "\n";
+        }
+    }
+    auto t1 = std::chrono::steady_clock::now();
+    std::cout.flush();
+    std::cerr << "[TICK] " << day_rd.segments() << " segment(s), " << day_rd.rows() << " rows, matched " << rows
+        << " in " << std::chrono::duration_cast<std::chrono::milliseconds>(t1 - t0).count() << " ms\n";
+    return 0;
+}
@@ -0,0 +1,169 @@
+#pragma once
+// TickStore: columnar daily tick files for research and backtests (ticks/<YYYYMMDD>/<type>/*.col)
+// FileWriter (--file-format columnar) collects each message type's rows per shard and writes
+// them as immutable segments: fixed-width little-endian columns (token, time, LTP, depth ...),
+// rows sorted by (token, time), plus a token index. A reader maps the segment and hands out
+// plain pointers into the columns; a token's time window is a binary search, not a scan.
+//
+// Segment layout (little endian, every section 64-byte aligned):
+//   [FileHeader 64 bytes][ColumnDesc x columns][TokenEntry x tokens][column 0]...[column n-1]
+//   column = rows x width bytes; prices are I32 in 1/10^scale units (2 => paise)
+// Segments are written to <name>.tmp and renamed, so a reader never sees a partial file.
+// Column names per type: see the schema tables in TickStore.cpp (--tick-query --csv prints them).
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <cstddef>
+
+namespace TickStore {
+
+    constexpr char kMagic[8] = { 'H','P','C','O','L','1','\0','\0' };
+    constexpr uint32_t kVersion = 1;
+
+    enum class Kind : uint8_t { U32 = 1, I32 = 2, I64 = 3 };
+
+    struct FileHeader {
+        char magic[8];
+        uint32_t version;
+        uint32_t type;              // RecordMeta::type
+        uint32_t day;               // YYYYMMDD, local time of the rows
+        uint32_t rows;
+        uint32_t columns;
+        uint32_t tokens;
+        uint64_t columns_off;       // ColumnDesc[columns]
+        uint64_t tokens_off;        // TokenEntry[tokens], sorted by token
+        uint32_t min_ts;            // unix seconds
+        uint32_t max_ts;
+        uint64_t create_ns;
+    };
+
+    struct ColumnDesc {
+        char name[16];              // NUL-padded
+        uint8_t kind;               // Kind
+        uint8_t width;              // bytes per value
+        uint8_t scale;              // decimal places of a fixed-point value (0 = integer)
+        uint8_t reserved[5];
+        uint64_t offset;            // from file start
+    };
+
+    struct TokenEntry {
+        uint32_t token;
+        uint32_t first_row;
+        uint32_t rows;
+        uint32_t min_ts;
+        uint32_t max_ts;
+        uint32_t reserved;
+    };
+
+    static_assert(sizeof(FileHeader) == 64, "TickStore::FileHeader must be 64 bytes");
+    static_assert(sizeof(ColumnDesc) == 32, "TickStore::ColumnDesc must be 32 bytes");
+    static_assert(sizeof(TokenEntry) == 24, "TickStore::TokenEntry must be 24 bytes");
+
+    // Folder name of a message type ("7208", "7202", "CT", "PN"); empty when it has no schema.
+    std::string type_name(uint16_t type);
+
+    // Local calendar day (YYYYMMDD) of unix seconds.
+    uint32_t day_of(uint32_t unixsec);
+
+    // ----------------- writer side -----------------
+    // Rows of one type waiting to become a segment. Not thread-safe (one per FileWriter shard).
+    class SegmentBuilder {
+    public:
+        explicit SegmentBuilder(uint16_t type);
+        ~SegmentBuilder();
+
+        // Parse one handler CSV line (the schema of its type) into a row stamped ts.
+        // false when the line does not match the schema (the row is skipped).
+        bool add(uint32_t ts, std::string_view csv);
+
+        size_t rows() const;
+        uint32_t day() const;
+        void set_day(uint32_t day);         // only while empty
+        uint64_t opened_ms() const;         // steady-clock ms of the first row
+
+        // Sort, write dir/<name>.col (tmp + rename) and clear. Returns bytes written, 0 on error
+        // (the rows are dropped either way).
+        uint64_t write(const std::string& dir, const std::string& name);
+
+    private:
+        void* impl_; // opaque pointer to implementation
+
+        SegmentBuilder(const SegmentBuilder&) = delete;
+        SegmentBuilder& operator=(const SegmentBuilder&) = delete;
+    };
+
+    // ----------------- reader side -----------------
+    // One memory-mapped segment. Column pointers stay valid until close().
+    class Segment {
+    public:
+        Segment();
+        ~Segment();
+
+        bool open(const std::string& path);
+        void close();
+
+        const FileHeader& header() const;
+        uint32_t rows() const;
+        const std::vector<ColumnDesc>& columns() const;
+        const ColumnDesc* find_column(std::string_view name) const;
+
+        // Typed column (nullptr when absent or when T does not match its width).
+        template <class T>
+        const T* column(std::string_view name) const {
+            const ColumnDesc* c = find_column(name);
+            if (!c || c->width != sizeof(T)) return nullptr;
+            return reinterpret_cast<const T*>(base() + c->offset);
+        }
+
+        const TokenEntry* find_token(uint32_t token) const;
+        const TokenEntry* tokens() const;
+
+        // Rows [begin, end) of token with from <= time <= to. false when there are none.
+        bool range(uint32_t token, uint32_t from, uint32_t to, uint32_t& begin, uint32_t& end) const;
+
+    private:
+        const uint8_t* base() const;
+
+        void* impl_; // opaque pointer to implementation
+
+        Segment(const Segment&) = delete;
+        Segment& operator=(const Segment&) = delete;
+    };
+
+    // All segments of one day and type: <base>/ticks/<day>/<type>/*.col, in file-name order.
+    class DayReader {
+    public:
+        // base is FileWriter's base directory; type is a type_name() ("7208", ...)
+        bool open(const std::string& base, uint32_t day, const std::string& type);
+        void close() { segs_.clear(); }
+
+        size_t segments() const { return segs_.size(); }
+        const Segment& segment(size_t i) const { return *segs_[i]; }
+        uint64_t rows() const;
+
+        // fn(segment, begin, end) for each run of token's rows with from <= time <= to, in
+        // segment order. Returns the number of rows visited.
+        template <class Fn>
+        uint64_t scan(uint32_t token, uint32_t from, uint32_t to, Fn&& fn) const {
+            uint64_t n = 0;
+            for (const auto& s : segs_) {
+                uint32_t b = 0, e = 0;
+                if (s->range(token, from, to, b, e)) { fn(*s, b, e); n += e - b; }
+            }
+            return n;
+        }
+
+    private:
+        std::vector<std::unique_ptr<Segment>> segs_;
+    };
+
+} // namespace TickStore
+
+// HermesPortal --tick-query <base> --day <YYYYMMDD> --type <7208|7202|CT|PN>
+//              [--token <n>] [--from <time>] [--to <time>] [--csv]
+//   scans a day of columnar ticks: per-segment summary, or the matching rows as CSV with --csv.
+//   <time> is unix seconds or HH:MM:SS on that day (local). Returns the process exit code.
+int RunTickQuery(int argc, char* argv[]);
@@ -0,0 +1,511 @@
+// src/UringWriter.cpp
+// Raw-syscall io_uring append backend (see UringWriter.h).
+
+#include "UringWriter.h"
+
+#ifdef HERMES_HAVE_IO_URING
+
+#include <linux/io_uring.h>
+#include <sys/syscall.h>
+#include <sys/mman.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <atomic>
+#include <unordered_map>
+#include <cerrno>
+#include <cstring>
+#include <cstdlib>
+
+namespace {
+
+    static int sys_setup(unsigned entries, io_uring_params* p) {
+        return static_cast<int>(::syscall(__NR_io_uring_setup, entries, p));
+    }
+    static int sys_enter(int fd, unsigned to_submit, unsigned min_complete, unsigned flags) {
+        return static_cast<int>(::syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, nullptr, 0));
+    }
+    static int sys_register(int fd, unsigned op, const void* arg, unsigned nr) {
+        return static_cast<int>(::syscall(__NR_io_uring_register, fd, op, arg, nr));
+    }
+
+    template <class T> static inline T load_acq(const T* p) {
+        return reinterpret_cast<const std::atomic<T>*>(p)->load(std::memory_order_acquire);
+    }
+    template <class T> static inline void store_rel(T* p, T v) {
+        reinterpret_cast<std::atomic<T>*>(p)->store(v, std::memory_order_release);
+    }
+
+    static constexpr unsigned kNoBuf = ~0u;
+    static constexpr unsigned kNoOp = ~0u;
+
+    // one in-flight (or queued) write: [off, off+len) of registered buffer `buf`
+    struct Op {
+        int fd = -1;
+        int slot = -1;                          // fixed-file index (-1: by fd)
+        unsigned buf = 0;
+        uint32_t off = 0;
+        uint32_t len = 0;
+        unsigned next = kNoOp;                  // next write of the same fd
+    };
+
+    // A file's writes in append order. Only the head is ever with the kernel: two O_APPEND
+    // writes in flight on one fd may land either way round on io-wq, and a link (IOSQE_IO_LINK)
+    // only orders SQEs that are adjacent in the SQ. The next write goes out when the head
+    // completes, so a blocking completion of the head can never overtake a later write.
+    struct Chain {
+        unsigned head = kNoOp;
+        unsigned tail = kNoOp;
+    };
+
+    struct Impl {
+        UringWriter::Config cfg;
+        int ring_fd = -1;
+
+        // SQ
+        void* sq_ptr = nullptr; size_t sq_sz = 0;
+        unsigned* sq_head = nullptr; unsigned* sq_tail = nullptr; unsigned* sq_mask = nullptr; unsigned* sq_array = nullptr;
+        io_uring_sqe* sqes = nullptr; size_t sqes_sz = 0;
+        unsigned sq_entries = 0;
+        unsigned sq_local_tail = 0;             // SQEs filled but not yet entered
+        unsigned to_submit = 0;
+
+        // CQ
+        void* cq_ptr = nullptr; size_t cq_sz = 0;
+        unsigned* cq_head = nullptr; unsigned* cq_tail = nullptr; unsigned* cq_mask = nullptr;
+        io_uring_cqe* cqes = nullptr;
+
+        // registered buffers, used as a bump arena: many small appends share one buffer,
+        // which returns to the free list once all of its writes completed
+        char* buf_mem = nullptr;
+        std::vector<unsigned> free_bufs;
+        std::vector<unsigned> buf_refs;         // in-flight writes per buffer
+        unsigned cur_buf = kNoBuf;
+        size_t cur_fill = 0;
+
+        std::vector<Op> ops;                    // op pool (user_data = index)
+        std::vector<unsigned> free_ops;
+        bool fixed_files = false;
+        std::vector<int> free_slots;
+        std::unordered_map<int, int> fd_slot;   // fd -> fixed-file index
+        std::unordered_map<int, Chain> chains;  // fd -> its queued writes (head in flight)
+        std::vector<int> reaped;                // fds whose head completed in reap()
+
+        unsigned inflight = 0;
+        size_t failed = 0;
+        UringWriter::Stats st;
+
+        char* buf_at(unsigned i) { return buf_mem + static_cast<size_t>(i) * cfg.buffer_bytes; }
+    };
+
+    static void unmap_all(Impl* I) {
+        if (I->sqes) munmap(I->sqes, I->sqes_sz);
+        if (I->cq_ptr && I->cq_ptr != I->sq_ptr) munmap(I->cq_ptr, I->cq_sz);
+        if (I->sq_ptr) munmap(I->sq_ptr, I->sq_sz);
+        if (I->ring_fd >= 0) ::close(I->ring_fd);
+        std::free(I->buf_mem);
+        I->sqes = nullptr; I->cq_ptr = nullptr; I->sq_ptr = nullptr; I->ring_fd = -1; I->buf_mem = nullptr;
+    }
+
+    static bool write_blocking(int fd, const char* p, size_t left) {
+        while (left) {
+            ssize_t n = ::write(fd, p, left);
+            if (n < 0) { if (errno == EINTR) continue; return false; }
+            p += n; left -= static_cast<size_t>(n);
+        }
+        return true;
+    }
+
+    // blocking completion of what the kernel did not write (op is its fd's only write in flight)
+    static void finish_blocking(Impl* I, const Op& op, size_t done) {
+        if (!write_blocking(op.fd, I->buf_at(op.buf) + op.off + done, op.len - done)) ++I->failed;
+        ++I->st.fallbacks;
+    }
+
+    static void release_op(Impl* I, unsigned o) {
+        const unsigned b = I->ops[o].buf;
+        if (--I->buf_refs[b] == 0 && b != I->cur_buf) I->free_bufs.push_back(b);
+        I->free_ops.push_back(o);
+    }
+
+    // drop the head of fd's chain; true when another write is waiting behind it
+    static bool pop_head(Impl* I, int fd) {
+        auto it = I->chains.find(fd);
+        if (it == I->chains.end()) return false;
+        const unsigned o = it->second.head;
+        it->second.head = I->ops[o].next;
+        release_op(I, o);
+        if (it->second.head != kNoOp) return true;
+        I->chains.erase(it);
+        return false;
+    }
+
+    static void start_chain(Impl* I, int fd);
+
+    // process every available CQE, then send each completed fd's next write; returns how
+    // many were reaped
+    static unsigned reap(Impl* I) {
+        unsigned head = *I->cq_head;
+        const unsigned tail = load_acq(I->cq_tail);
+        unsigned n = 0;
+        std::vector<int> next;
+        next.swap(I->reaped);                   // start_chain() below may reap again
+        next.clear();
+        while (head != tail) {
+            const io_uring_cqe& c = I->cqes[head & *I->cq_mask];
+            const unsigned o = static_cast<unsigned>(c.user_data);
+            const Op& op = I->ops[o];
+            const int fd = op.fd;
+            if (c.res < 0) finish_blocking(I, op, 0);
+            else if (static_cast<uint32_t>(c.res) < op.len) finish_blocking(I, op, static_cast<size_t>(c.res));
+            if (pop_head(I, fd)) next.push_back(fd);
+            ++head; ++n;
+        }
+        store_rel(I->cq_head, head);
+        I->inflight -= n;
+        for (int fd : next) start_chain(I, fd);
+        if (I->reaped.empty()) { next.clear(); next.swap(I->reaped); }
+        return n;
+    }
+
+    static bool enter(Impl* I, unsigned min_complete) {
+        for (;;) {
+            unsigned flags = min_complete ? IORING_ENTER_GETEVENTS : 0u;
+            int r = sys_enter(I->ring_fd, I->to_submit, min_complete, flags);
+            ++I->st.enters;
+            if (r < 0) {
+                if (errno == EINTR) continue;
+                if (errno == EAGAIN || errno == EBUSY) { reap(I); continue; }
+                return false;
+            }
+            I->to_submit -= static_cast<unsigned>(r) < I->to_submit ? static_cast<unsigned>(r) : I->to_submit;
+            return true;
+        }
+    }
+
+    // wait for completions; false when nothing is in flight or the ring failed.
+    // Buffered appends complete on io-wq workers one by one, so waiting for a single CQE would
+    // cost a syscall per write: wait for a quarter of what is in flight instead.
+    static bool wait_one(Impl* I) {
+        if (!I->inflight && !I->to_submit) return false;
+        const unsigned want = static_cast<unsigned>(I->inflight / 4);
+        if (!enter(I, want ? want : 1u)) return false;
+        reap(I);
+        return true;
+    }
+
+    // room in the current arena buffer, moving to a free one when it is full
+    static bool arena_room(Impl* I) {
+        if (I->cur_buf != kNoBuf && I->cur_fill < I->cfg.buffer_bytes) return true;
+        if (I->cur_buf != kNoBuf) {
+            if (I->buf_refs[I->cur_buf] == 0) I->free_bufs.push_back(I->cur_buf);
+            I->cur_buf = kNoBuf;
+        }
+        while (I->free_bufs.empty()) if (!wait_one(I)) return false;
+        I->cur_buf = I->free_bufs.back();
+        I->free_bufs.pop_back();
+        I->cur_fill = 0;
+        return true;
+    }
+
+    static bool get_op(Impl* I, unsigned& o) {
+        while (I->free_ops.empty()) if (!wait_one(I)) return false;
+        o = I->free_ops.back();
+        I->free_ops.pop_back();
+        return true;
+    }
+
+    // submitting what is queued frees SQ room; no chain is split, since none spans SQEs
+    static io_uring_sqe* get_sqe(Impl* I) {
+        if (I->sq_local_tail - load_acq(I->sq_head) >= I->sq_entries) {
+            if (!enter(I, 0)) return nullptr;
+            if (I->sq_local_tail - load_acq(I->sq_head) >= I->sq_entries) return nullptr;
+        }
+        const unsigned idx = I->sq_local_tail & *I->sq_mask;
+        io_uring_sqe* sqe = &I->sqes[idx];
+        std::memset(sqe, 0, sizeof(*sqe));
+        I->sq_array[idx] = idx;
+        ++I->sq_local_tail;
+        ++I->to_submit;
+        return sqe;
+    }
+
+    static int slot_for(Impl* I, int fd) {
+        if (!I->fixed_files) return -1;
+        auto it = I->fd_slot.find(fd);
+        if (it != I->fd_slot.end()) return it->second;
+        if (I->free_slots.empty()) return -1;
+        int slot = I->free_slots.back();
+        io_uring_files_update up{};
+        up.offset = static_cast<__u32>(slot);
+        up.fds = reinterpret_cast<__u64>(&fd);
+        if (sys_register(I->ring_fd, IORING_REGISTER_FILES_UPDATE, &up, 1) < 0) return -1;
+        I->free_slots.pop_back();
+        I->fd_slot.emplace(fd, slot);
+        return slot;
+    }
+
+    // hand op to the kernel; false when the SQ has no room
+    static bool submit_op(Impl* I, unsigned o) {
+        const Op& op = I->ops[o];
+        io_uring_sqe* sqe = get_sqe(I);
+        if (!sqe) return false;
+        sqe->opcode = IORING_OP_WRITE_FIXED;
+        sqe->fd = op.slot >= 0 ? op.slot : op.fd;
+        if (op.slot >= 0) sqe->flags |= IOSQE_FIXED_FILE;
+        sqe->off = static_cast<__u64>(-1);      // current position (O_APPEND: end of file)
+        sqe->addr = reinterpret_cast<__u64>(I->buf_at(op.buf) + op.off);
+        sqe->len = op.len;
+        sqe->buf_index = static_cast<__u16>(op.buf);
+        sqe->user_data = o;
+        store_rel(I->sq_tail, I->sq_local_tail);
+        ++I->inflight;
+        ++I->st.writes;
+        I->st.bytes += op.len;
+        if (I->inflight > I->st.inflight_hwm) I->st.inflight_hwm = I->inflight;
+        return true;
+    }
+
+    // send the head of fd's chain. Nothing of fd is in flight here, so when the SQ has no
+    // room the head is written inline and the next one tried, still in order.
+    static void start_chain(Impl* I, int fd) {
+        for (;;) {
+            auto it = I->chains.find(fd);
+            if (it == I->chains.end()) return;
+            const unsigned o = it->second.head;
+            if (submit_op(I, o)) return;
+            finish_blocking(I, I->ops[o], 0);
+            if (!pop_head(I, fd)) return;
+        }
+    }
+
+    // append op to fd's chain; it goes to the kernel once the writes before it completed
+    static void queue_write(Impl* I, int fd, int slot, unsigned o) {
+        Op& op = I->ops[o];
+        ++I->buf_refs[op.buf];
+        op.fd = fd;
+        op.slot = slot;
+        op.next = kNoOp;
+        auto ins = I->chains.try_emplace(fd, Chain{ o, o });
+        if (!ins.second) {
+            I->ops[ins.first->second.tail].next = o;
+            ins.first->second.tail = o;
+            return;
+        }
+        start_chain(I, fd);
+    }
+
+} // namespace anon
+
+UringWriter::UringWriter() {
+    impl_ = new Impl();
+}
+
+UringWriter::~UringWriter() {
+    close();
+    delete reinterpret_cast<Impl*>(impl_);
+    impl_ = nullptr;
+}
+
+bool UringWriter::supported() {
+    static const bool ok = [] {
+        io_uring_params p{};
+        int fd = sys_setup(4, &p);
+        if (fd < 0) return false;
+        ::close(fd);
+        return true;
+    }();
+    return ok;
+}
+
+bool UringWriter::open(const Config& cfg) {
+    Impl* I = reinterpret_cast<Impl*>(impl_);
+    close();
+    I->cfg = cfg;
+    if (I->cfg.buffers == 0 || I->cfg.buffers > 1024) I->cfg.buffers = 64;
+    if (I->cfg.buffer_bytes < 4096) I->cfg.buffer_bytes = 4096;
+
+    io_uring_params p{};
+    I->ring_fd = sys_setup(cfg.entries ? cfg.entries : 256, &p);
+    if (I->ring_fd < 0) return false;
+
+    I->sq_sz = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+    I->cq_sz = p.cq_off.cqes + p.cq_entries * sizeof(io_uring_cqe);
+    const bool single = (p.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (single) { if (I->cq_sz > I->sq_sz) I->sq_sz = I->cq_sz; I->cq_sz = I->sq_sz; }
+
+    I->sq_ptr = mmap(nullptr, I->sq_sz, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, I->ring_fd, IORING_OFF_SQ_RING);
+    if (I->sq_ptr == MAP_FAILED) { I->sq_ptr = nullptr; unmap_all(I); return false; }
+    if (single) I->cq_ptr = I->sq_ptr;
+    else {
+        I->cq_ptr = mmap(nullptr, I->cq_sz, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, I->ring_fd, IORING_OFF_CQ_RING);
+        if (I->cq_ptr == MAP_FAILED) { I->cq_ptr = nullptr; unmap_all(I); return false; }
+    }
+    I->sqes_sz = p.sq_entries * sizeof(io_uring_sqe);
+    void* sq = mmap(nullptr, I->sqes_sz, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, I->ring_fd, IORING_OFF_SQES);
+    if (sq == MAP_FAILED) { unmap_all(I); return false; }
+    I->sqes = static_cast<io_uring_sqe*>(sq);
+
+    char* sqb = static_cast<char*>(I->sq_ptr);
+    char* cqb = static_cast<char*>(I->cq_ptr);
+    I->sq_head = reinterpret_cast<unsigned*>(sqb + p.sq_off.head);
+    I->sq_tail = reinterpret_cast<unsigned*>(sqb + p.sq_off.tail);
+    I->sq_mask = reinterpret_cast<unsigned*>(sqb + p.sq_off.ring_mask);
+    I->sq_array = reinterpret_cast<unsigned*>(sqb + p.sq_off.array);
+    I->cq_head = reinterpret_cast<unsigned*>(cqb + p.cq_off.head);
+    I->cq_tail = reinterpret_cast<unsigned*>(cqb + p.cq_off.tail);
+    I->cq_mask = reinterpret_cast<unsigned*>(cqb + p.cq_off.ring_mask);
+    I->cqes = reinterpret_cast<io_uring_cqe*>(cqb + p.cq_off.cqes);
+    I->sq_entries = p.sq_entries;
+    I->sq_local_tail = *I->sq_tail;
+    I->to_submit = 0;
+
+    // staging buffers, registered once (WRITE_FIXED skips the per-I/O page pinning)
+    const size_t total = static_cast<size_t>(I->cfg.buffers) * I->cfg.buffer_bytes;
+    I->buf_mem = static_cast<char*>(std::aligned_alloc(4096, (total + 4095) & ~static_cast<size_t>(4095)));
+    if (!I->buf_mem) { unmap_all(I); return false; }
+    std::vector<iovec> iov(I->cfg.buffers);
+    for (unsigned i = 0; i < I->cfg.buffers; ++i) { iov[i].iov_base = I->buf_at(i); iov[i].iov_len = I->cfg.buffer_bytes; }
+    if (sys_register(I->ring_fd, IORING_REGISTER_BUFFERS, iov.data(), I->cfg.buffers) < 0) { unmap_all(I); return false; }
+
+    // sparse fixed-file table; without it writes go by plain fd
+    std::vector<int> fds(cfg.max_files ? cfg.max_files : 1, -1);
+    I->fixed_files = sys_register(I->ring_fd, IORING_REGISTER_FILES, fds.data(), static_cast<unsigned>(fds.size())) == 0;
+    I->free_slots.clear();
+    if (I->fixed_files) for (int i = static_cast<int>(fds.size()) - 1; i >= 0; --i) I->free_slots.push_back(i);
+
+    I->free_bufs.clear();
+    for (unsigned i = I->cfg.buffers; i > 0; --i) I->free_bufs.push_back(i - 1);
+    I->buf_refs.assign(I->cfg.buffers, 0);
+    I->cur_buf = kNoBuf;
+    I->cur_fill = 0;
+    // no more writes in flight than the CQ can hold
+    I->ops.assign(p.cq_entries, Op{});
+    I->free_ops.clear();
+    for (unsigned i = p.cq_entries; i > 0; --i) I->free_ops.push_back(i - 1);
+    I->chains.clear();
+    I->inflight = 0;
+    I->failed = 0;
+    I->st = Stats{};
+    return true;
+}
+
+void UringWriter::close() {
+    Impl* I = reinterpret_cast<Impl*>(impl_);
+    if (!I || I->ring_fd < 0) return;
+    flush();
+    unmap_all(I);
+    I->fd_slot.clear();
+    I->chains.clear();
+    I->free_slots.clear();
+    I->fixed_files = false;
+}
+
+bool UringWriter::is_open() const {
+    Impl* I = reinterpret_cast<Impl*>(impl_);
+    return I->ring_fd >= 0;
+}
+
+bool UringWriter::append(int fd, const std::vector<std::string_view>& parts) {
+    Impl* I = reinterpret_cast<Impl*>(impl_);
+    if (I->ring_fd < 0 || parts.empty()) return false;
+    const int slot = slot_for(I, fd);
+
+    size_t total = 0;
+    for (const auto& part : parts) total += part.size();
+    if (!total) return true;
+
+    // copy the parts into the buffer arena; a file's bytes become one write per buffer they
+    // span, queued on fd's chain behind its earlier appends
+    size_t staged = 0;
+    bool queued = false;
+    unsigned o = 0;
+    bool have = false;
+    for (size_t pi = 0; pi < parts.size(); ++pi) {
+        const char* d = parts[pi].data();
+        size_t left = parts[pi].size();
+        while (left) {
+            if (!have) {
+                if (!arena_room(I) || !get_op(I, o)) {
+                    if (!queued) return false;
+                    // ring unusable mid-file: let every queued chunk land, then finish inline
+                    I->failed += flush();
+                    bool ok = write_blocking(fd, d, left);
+                    for (size_t pj = pi + 1; ok && pj < parts.size(); ++pj)
+                        ok = write_blocking(fd, parts[pj].data(), parts[pj].size());
+                    if (!ok) ++I->failed;
+                    ++I->st.fallbacks;
+                    return true;
+                }
+                Op& op = I->ops[o];
+                op.buf = I->cur_buf;
+                op.off = static_cast<uint32_t>(I->cur_fill);
+                op.len = 0;
+                have = true;
+            }
+            Op& op = I->ops[o];
+            size_t n = I->cfg.buffer_bytes - I->cur_fill;
+            if (n > left) n = left;
+            std::memcpy(I->buf_at(op.buf) + I->cur_fill, d, n);
+            I->cur_fill += n; op.len += static_cast<uint32_t>(n);
+            d += n; left -= n; staged += n;
+            if (I->cur_fill == I->cfg.buffer_bytes || staged == total) {
+                queue_write(I, fd, slot, o);
+                have = false;
+                queued = true;
+            }
+        }
+    }
+    return true;
+}
+
+size_t UringWriter::flush() {
+    Impl* I = reinterpret_cast<Impl*>(impl_);
+    if (I->ring_fd < 0) return 0;
+    while (I->to_submit || I->inflight) {
+        if (!enter(I, I->inflight ? 1u : 0u)) break;
+        reap(I);
+    }
+    // everything landed: the arena starts over at the head of the current buffer
+    if (!I->inflight && I->cur_buf != kNoBuf && I->buf_refs[I->cur_buf] == 0) I->cur_fill = 0;
+    size_t f = I->failed;
+    I->failed = 0;
+    return f;
+}
+
+void UringWriter::forget_fd(int fd) {
+    Impl* I = reinterpret_cast<Impl*>(impl_);
+    if (I->ring_fd < 0) return;
+    // writes still waiting on fd's chain name it: let them land before it is closed, and
+    // hand the queued SQEs to the kernel
+    while (I->chains.count(fd)) if (!wait_one(I)) break;
+    if (I->to_submit) enter(I, 0);
+    auto it = I->fd_slot.find(fd);
+    if (it == I->fd_slot.end()) return;
+    int none = -1;
+    io_uring_files_update up{};
+    up.offset = static_cast<__u32>(it->second);
+    up.fds = reinterpret_cast<__u64>(&none);
+    sys_register(I->ring_fd, IORING_REGISTER_FILES_UPDATE, &up, 1);
+    I->free_slots.push_back(it->second);
+    I->fd_slot.erase(it);
+}
+
+UringWriter::Stats UringWriter::stats() const {
+    Impl* I = reinterpret_cast<Impl*>(impl_);
+    return I->st;
+}
+
+#else // !HERMES_HAVE_IO_URING
+
+UringWriter::UringWriter() : impl_(nullptr) {}
+UringWriter::~UringWriter() {}
+bool UringWriter::supported() { return false; }
+bool UringWriter::open(const Config&) { return false; }
+void UringWriter::close() {}
+bool UringWriter::is_open() const { return false; }
+bool UringWriter::append(int, const std::vector<std::string_view>&) { return false; }
+size_t UringWriter::flush() { return 0; }
+void UringWriter::forget_fd(int) {}
+UringWriter::Stats UringWriter::stats() const { return Stats{}; }
+
+#endif
@@ -0,0 +1,65 @@
+#pragma once
+// UringWriter: optional Linux io_uring backend for FileWriter historical appends
+// Lines for each file are gathered into registered (fixed) buffers and submitted as
+// WRITE_FIXED against registered (fixed) files, so one io_uring_enter keeps many appends in
+// flight across files. A file has one write in flight at a time; its later appends wait on
+// a per-fd chain and go out as the one before completes, so they land in append order.
+// Talks to the kernel through the raw syscalls (no liburing dependency). On other platforms,
+// or when the kernel refuses io_uring, open() fails and FileWriter keeps its blocking path.
+
+#include <string_view>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#define HERMES_HAVE_IO_URING 1
+#endif
+#endif
+
+class UringWriter {
+public:
+    struct Config {
+        unsigned entries = 256;                 // SQ entries (power of two)
+        unsigned buffers = 64;                  // registered staging buffers
+        size_t buffer_bytes = 64u << 10;        // bytes per staging buffer
+        unsigned max_files = 512;               // fixed-file table size
+    };
+
+    struct Stats {
+        uint64_t writes = 0;                    // SQEs submitted
+        uint64_t bytes = 0;
+        uint64_t enters = 0;                    // io_uring_enter calls
+        uint64_t fallbacks = 0;                 // short/failed writes completed with write(2)
+        uint64_t inflight_hwm = 0;
+    };
+
+    UringWriter();
+    ~UringWriter();
+
+    // true when this build and the running kernel support io_uring
+    static bool supported();
+
+    bool open(const Config& cfg);
+    void close();                               // waits for in-flight writes
+    bool is_open() const;
+
+    // Queue an append of parts to fd (an O_APPEND descriptor). Returns false when nothing
+    // was queued and the caller should use its blocking path.
+    bool append(int fd, const std::vector<std::string_view>& parts);
+
+    // Submit everything queued and wait until all writes completed. Returns failed writes.
+    size_t flush();
+
+    // fd is about to be closed: submit queued SQEs and release its fixed-file slot
+    void forget_fd(int fd);
+
+    Stats stats() const;
+
+private:
+    void* impl_; // opaque pointer to implementation
+
+    UringWriter(const UringWriter&) = delete;
+    UringWriter& operator=(const UringWriter&) = delete;
+};
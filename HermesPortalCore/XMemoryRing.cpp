@@ -8,8 +8,16 @@
 #endif
 #define WIN32_LEAN_AND_MEAN
 #include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
 #include <atomic>
 #include <chrono>
+#include <iostream>
+#include <sstream>
 #include "XMemoryRing.hpp"
 
 namespace xmr {
@@ -30,29 +38,36 @@ namespace xmr {
             system_clock::now().time_since_epoch()).count());
     }
 
-    // --------- header field access (volatile loads/stores) ---------
-    uint64_t Writer::load64(size_t off) const {
-        return *reinterpret_cast<volatile const uint64_t*>((uint8_t*)base_ + off);
-    }
-    void Writer::store64(size_t off, uint64_t v) const {
-        *reinterpret_cast<volatile uint64_t*>((uint8_t*)base_ + off) = v;
-    }
-    uint32_t Writer::load32(size_t off) const {
-        return *reinterpret_cast<volatile const uint32_t*>((uint8_t*)base_ + off);
-    }
-    void Writer::store32(size_t off, uint32_t v) const {
-        *reinterpret_cast<volatile uint32_t*>((uint8_t*)base_ + off) = v;
+    // --------- header field access ---------
+    // The header lives in memory shared with another process, so fields are accessed as
+    // lock-free atomics laid over it (std::atomic_ref in C++20 terms).
+    static_assert(sizeof(std::atomic<uint64_t>) == sizeof(uint64_t) && std::atomic<uint64_t>::is_always_lock_free,
+        "XMemoryRing needs lock-free 64-bit atomics");
+    static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t) && std::atomic<uint32_t>::is_always_lock_free,
+        "XMemoryRing needs lock-free 32-bit atomics");
+
+    static inline std::atomic<uint64_t>& at64(void* base, size_t off) {
+        return *reinterpret_cast<std::atomic<uint64_t>*>(static_cast<uint8_t*>(base) + off);
     }
-    uint64_t Reader::load64(size_t off) const {
-        return *reinterpret_cast<volatile const uint64_t*>((uint8_t*)base_ + off);
+    static inline std::atomic<uint32_t>& at32(void* base, size_t off) {
+        return *reinterpret_cast<std::atomic<uint32_t>*>(static_cast<uint8_t*>(base) + off);
     }
-    void Reader::store64(size_t off, uint64_t v) const {
-        *reinterpret_cast<volatile uint64_t*>((uint8_t*)base_ + off) = v;
+
+    uint64_t Writer::load64(size_t off, std::memory_order mo) const { return at64(base_, off).load(mo); }
+    void Writer::store64(size_t off, uint64_t v, std::memory_order mo) const { at64(base_, off).store(v, mo); }
+    bool Writer::cas64(size_t off, uint64_t& expected, uint64_t v) const {
+        return at64(base_, off).compare_exchange_strong(expected, v, std::memory_order_acq_rel, std::memory_order_acquire);
     }
-    uint32_t Reader::load32(size_t off) const {
-        return *reinterpret_cast<volatile const uint32_t*>((uint8_t*)base_ + off);
+    uint32_t Writer::load32(size_t off) const { return at32(base_, off).load(std::memory_order_relaxed); }
+    void Writer::store32(size_t off, uint32_t v) const { at32(base_, off).store(v, std::memory_order_relaxed); }
+    uint64_t Reader::load64(size_t off, std::memory_order mo) const { return at64(base_, off).load(mo); }
+    void Reader::store64(size_t off, uint64_t v, std::memory_order mo) const { at64(base_, off).store(v, mo); }
+    bool Reader::cas64(size_t off, uint64_t& expected, uint64_t v) const {
+        return at64(base_, off).compare_exchange_strong(expected, v, std::memory_order_acq_rel, std::memory_order_acquire);
     }
+    uint32_t Reader::load32(size_t off) const { return at32(base_, off).load(std::memory_order_relaxed); }
 
+#ifdef _WIN32
     // --------- Windows helpers ---------
     std::wstring Writer::utf8_to_wide(const std::string& s) {
         if (s.empty()) return std::wstring();
@@ -78,11 +93,21 @@ namespace xmr {
         if (pair.rfind(L"Local:", 0) == 0 || pair.rfind(L"Local\\", 0) == 0) return pair;
         return L"Local\\" + pair;
     }
+#else
+    // --------- POSIX helpers ---------
+    // "/<name>.<token>" (lives in /dev/shm on Linux); '/' inside the pair is not allowed there
+    static std::string compose_shm_name(const std::string& name, const std::string& token) {
+        std::string pair = name + "." + token;
+        if (!pair.empty() && pair[0] == '/') pair.erase(0, 1);
+        std::replace(pair.begin(), pair.end(), '/', '_');
+        return "/" + pair;
+    }
+#endif
 
     // --------- Writer header ops ---------
     bool Writer::validate_header(uint64_t& outCap) const {
         if (!region_valid(base_)) return false;
-        if (load64(oMagic) != kMagic64) return false;
+        if (load64(oMagic, std::memory_order_acquire) != kMagic64) return false;
         if (load32(oABIVer) != kAbiVersion) return false;
         uint64_t c = load64(oCapacity);
         if (!c) return false;
@@ -90,11 +115,18 @@ namespace xmr {
         return true;
     }
     void Writer::init_header(uint64_t cap) const {
-        store64(oMagic, kMagic64);
+        // a reused region may hold another capacity's head/tail: start the ring over
+        store64(oMagic, 0);
+        std::memset(static_cast<uint8_t*>(base_) + oFlags, 0, oHdrEnd - oFlags);
         store32(oABIVer, kAbiVersion);
-        store32(oFlags, 0);
         store64(oCapacity, cap);
         store64(oHeartbeat, now_nanos());
+        store64(oMagic, kMagic64, std::memory_order_release);
+    }
+    void Writer::publish_counters() const {
+        store64(oDrops, drops_.load(std::memory_order_relaxed));
+        store64(oOver, over_.load(std::memory_order_relaxed));
+        store64(oBWrite, bwrite_.load(std::memory_order_relaxed));
     }
 
     // --------- Writer open/close ---------
@@ -104,12 +136,13 @@ namespace xmr {
             throw std::runtime_error("XMemoryRing: capacity too small (min 64 KiB)");
 
         cfg_ = cfg;
+        size_ = static_cast<size_t>(oHdrEnd + cfg.capacity_bytes);
 
+#ifdef _WIN32
         std::wstring nameW = !cfg.nameW.empty() ? cfg.nameW : utf8_to_wide(cfg.name);
         std::wstring tokenW = !cfg.tokenW.empty() ? cfg.tokenW : utf8_to_wide(cfg.token);
         if (nameW.empty() || tokenW.empty()) throw std::runtime_error("XMemoryRing: Name/Token required");
         map_name_w_ = compose_map_name_w(nameW, tokenW);
-        size_ = static_cast<size_t>(oHdrEnd + cfg.capacity_bytes);
 
         HANDLE h = CreateFileMappingW(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE,
             (DWORD)((uint64_t)size_ >> 32),
@@ -129,6 +162,38 @@ namespace xmr {
         }
         hmap_ = h;
         base_ = v;
+#else
+        if (cfg.name.empty() || cfg.token.empty()) throw std::runtime_error("XMemoryRing: Name/Token required");
+        shm_name_ = compose_shm_name(cfg.name, cfg.token);
+
+        // like a named Windows mapping: create, or attach to the one a previous writer left
+        int fd = shm_open(shm_name_.c_str(), O_CREAT | O_RDWR, 0600);
+        if (fd < 0) {
+            int e = errno;
+            if (cfg.on_event) cfg.on_event(EventType::Error, "shm_open failed");
+            throw std::system_error(e, std::generic_category(), "shm_open " + shm_name_);
+        }
+        struct stat st {};
+        if (fstat(fd, &st) != 0 || static_cast<uint64_t>(st.st_size) != size_) {
+            // a leftover of another size starts from zeroes, not from its old head/tail
+            if (ftruncate(fd, 0) != 0 || ftruncate(fd, static_cast<off_t>(size_)) != 0) {
+                int e = errno;
+                ::close(fd);
+                shm_unlink(shm_name_.c_str());
+                if (cfg.on_event) cfg.on_event(EventType::Error, "ftruncate failed");
+                throw std::system_error(e, std::generic_category(), "ftruncate " + shm_name_);
+            }
+        }
+        void* v = mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (v == MAP_FAILED) {
+            int e = errno;
+            ::close(fd);
+            if (cfg.on_event) cfg.on_event(EventType::Error, "mmap failed");
+            throw std::system_error(e, std::generic_category(), "mmap " + shm_name_);
+        }
+        fd_ = fd;
+        base_ = v;
+#endif
 
         uint64_t cap = 0;
         if (!validate_header(cap) || cap != cfg.capacity_bytes) {
@@ -142,6 +207,12 @@ namespace xmr {
 
         cap_ = cap;
         data_ = reinterpret_cast<uint8_t*>(base_) + oHdrEnd;
+        // reattached to a live ring (a reader kept it): continue from its head and counters
+        head_ = load64(oHead, std::memory_order_acquire);
+        tail_cache_ = load64(oTail, std::memory_order_acquire);
+        drops_.store(load64(oDrops), std::memory_order_relaxed);
+        over_.store(load64(oOver), std::memory_order_relaxed);
+        bwrite_.store(load64(oBWrite), std::memory_order_relaxed);
 
         start_hb(cfg.heartbeat_interval.count() ? cfg.heartbeat_interval : std::chrono::nanoseconds(500'000'000));
 
@@ -150,9 +221,18 @@ namespace xmr {
 
     void Writer::close() noexcept {
         stop_hb();
+        if (base_) publish_counters();
+#ifdef _WIN32
         if (base_) { UnmapViewOfFile(base_); base_ = nullptr; }
         if (hmap_) { CloseHandle(hmap_); hmap_ = nullptr; }
         map_name_w_.clear();
+#else
+        // the name goes away with the writer (as the Windows mapping does with its last handle);
+        // an attached reader keeps its mapping and sees the heartbeat stop
+        if (base_) { munmap(base_, size_); base_ = nullptr; }
+        if (fd_ >= 0) { ::close(fd_); fd_ = -1; }
+        if (!shm_name_.empty()) { shm_unlink(shm_name_.c_str()); shm_name_.clear(); }
+#endif
         data_ = nullptr; cap_ = 0; size_ = 0;
         if (cfg_.on_event) cfg_.on_event(EventType::Closed, "");
     }
@@ -166,8 +246,18 @@ namespace xmr {
         data_ = o.data_; o.data_ = nullptr;
         cap_ = o.cap_;  o.cap_ = 0;
         size_ = o.size_; o.size_ = 0;
+        head_ = o.head_;
+        tail_cache_ = o.tail_cache_;
+        drops_.store(o.drops_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        over_.store(o.over_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        bwrite_.store(o.bwrite_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+#ifdef _WIN32
         hmap_ = o.hmap_; o.hmap_ = nullptr;
         map_name_w_ = std::move(o.map_name_w_);
+#else
+        fd_ = o.fd_; o.fd_ = -1;
+        shm_name_ = std::move(o.shm_name_); o.shm_name_.clear();
+#endif
         hb_stop_.store(o.hb_stop_.load());
         cfg_ = std::move(o.cfg_);
         if (o.hb_.joinable()) hb_ = std::move(o.hb_);
@@ -180,6 +270,7 @@ namespace xmr {
         hb_ = std::thread([this, iv]() {
             auto dur = iv.count() ? iv : std::chrono::nanoseconds(500'000'000);
             while (!hb_stop_.load(std::memory_order_relaxed)) {
+                publish_counters();
                 store64(oHeartbeat, now_nanos());
                 std::this_thread::sleep_for(dur);
             }
@@ -196,6 +287,52 @@ namespace xmr {
         return s ? write(reinterpret_cast<const uint8_t*>(s), std::strlen(s)) : false;
     }
 
+    // ring[at..at+n), wrapping at the end of the data area
+    void Writer::copy_in(uint64_t at, const uint8_t* src, size_t n) {
+        size_t pos = static_cast<size_t>(at % cap_);
+        size_t first = (std::min)(n, static_cast<size_t>(cap_ - pos));
+        std::memcpy(&data_[pos], src, first);
+        if (first < n) std::memcpy(&data_[0], src + first, n - first);
+    }
+
+    // First frame boundary at or after min_end, scanning whole frames from 'from' (a boundary).
+    // The ring holds whole frames only, so head is always a boundary and bounds the scan.
+    uint64_t Writer::frame_end(uint64_t from, uint64_t min_end) const {
+        if (cfg_.frame_mode == FrameMode::LengthPrefix) {
+            uint64_t at = from;
+            while (at < min_end && at < head_) {
+                uint32_t le = 0;
+                for (size_t k = 0; k < sizeof(le); ++k)
+                    reinterpret_cast<uint8_t*>(&le)[k] = data_[(at + k) % cap_];
+                at += sizeof(uint32_t) + le;
+            }
+            return (std::min)(at, head_);
+        }
+        // newline: the byte before a boundary is '\n'
+        uint64_t at = min_end - 1;
+        while (at < head_) {
+            size_t pos = static_cast<size_t>(at % cap_);
+            size_t span = static_cast<size_t>((std::min)(head_ - at, cap_ - pos));
+            const uint8_t* nl = static_cast<const uint8_t*>(std::memchr(&data_[pos], '\n', span));
+            if (nl) return at + static_cast<uint64_t>(nl - &data_[pos]) + 1;
+            at += span;
+        }
+        return head_;
+    }
+
+    // Free 'need' bytes under DropOldest by moving the tail past whole frames. The reader may
+    // advance the tail concurrently, so both sides move it by CAS; a reader whose CAS fails
+    // discards what it copied (the writer may be overwriting it).
+    void Writer::make_room(uint64_t need) {
+        uint64_t tail = tail_cache_;
+        for (;;) {
+            if (cap_ - (head_ - tail) >= need) break;           // the reader caught up
+            uint64_t to = frame_end(tail, head_ + need - cap_);
+            if (cas64(oTail, tail, to)) { tail = to; break; }    // failure reloads tail
+        }
+        tail_cache_ = tail;
+    }
+
     bool Writer::write(const uint8_t* data, size_t len) {
         if (!base_) return false;
         if (len == 0) { store64(oHeartbeat, now_nanos()); return true; }
@@ -205,79 +342,64 @@ namespace xmr {
         size_t n = len;
         if (newline_mode && data[len - 1] != '\n') n++;
         size_t need = newline_mode ? n : n + sizeof(uint32_t);
-        if (need > cap_) { store64(oOver, load64(oOver) + 1); return false; }
-
-        uint64_t head = load64(oHead);
-        uint64_t tail = load64(oTail);
-        uint64_t used = head - tail;
-
-        if (cap_ - used < need) {
-            if (cfg_.drop_policy == DropPolicy::DropNewest) {
-                store64(oDrops, load64(oDrops) + 1);
-                return false;
-            }
-            else {
-                // drop-oldest: advance tail enough
-                uint64_t advance = need - (cap_ - used);
-                store64(oTail, tail + advance);
-                store64(oDrops, load64(oDrops) + 1);
+        if (need > cap_) { over_.store(over_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed); return false; }
+
+        // tail is the reader's line: only look at it when the cached free space is short
+        if (cap_ - (head_ - tail_cache_) < need) {
+            tail_cache_ = load64(oTail, std::memory_order_acquire);   // the reader is done with those bytes
+            if (cap_ - (head_ - tail_cache_) < need) {
+                drops_.store(drops_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+                if (cfg_.drop_policy == DropPolicy::DropNewest) return false;
+                make_room(need);
             }
         }
 
-        uint64_t pos = head % cap_;
-        size_t first = static_cast<size_t>(cap_ - pos);
-        if (first > need) first = need;
-
+        uint64_t at = head_;
         if (cfg_.frame_mode == FrameMode::LengthPrefix) {
             uint32_t le = (uint32_t)len;
-            std::memcpy(&data_[pos], &le, (std::min)(first, sizeof(uint32_t)));
-            if (first < sizeof(uint32_t)) {
-                std::memcpy(&data_[0], ((uint8_t*)&le) + first, sizeof(uint32_t) - first);
-                size_t rem = need - sizeof(uint32_t);
-                std::memcpy(&data_[sizeof(uint32_t) - first], data, (std::min)(len, rem));
-            }
-            else {
-                std::memcpy(&data_[(pos + sizeof(uint32_t)) % cap_], data, len);
-            }
+            copy_in(at, reinterpret_cast<const uint8_t*>(&le), sizeof(le));
+            copy_in(at + sizeof(le), data, len);
         }
         else {
-            if (first) {
-                std::memcpy(&data_[pos], data, (std::min)(len, first));
-                if (n > len && first == n) data_[pos + first - 1] = '\n';
-            }
-            if (first < n) {
-                size_t rem = n - first;
-                std::memcpy(&data_[0], data + first, (std::min)(len - first, rem));
-                if (n > len) data_[rem - 1] = '\n';
-            }
+            copy_in(at, data, len);
+            if (n > len) data_[(at + len) % cap_] = '\n';
         }
 
-        store64(oHead, head + need);
-        store64(oBWrite, load64(oBWrite) + need);
-        store64(oHeartbeat, now_nanos());
+        head_ = at + need;
+        store64(oHead, head_, std::memory_order_release);          // publishes the frame bytes
+        bwrite_.store(bwrite_.load(std::memory_order_relaxed) + need, std::memory_order_relaxed);
         return true;
     }
 
-    void Writer::heartbeat() { if (base_) store64(oHeartbeat, now_nanos()); }
+    void Writer::heartbeat() {
+        if (!base_) return;
+        publish_counters();
+        store64(oHeartbeat, now_nanos());
+    }
     WriterStats Writer::stats() const {
         WriterStats s{};
         if (!base_) return s;
-        s.drops_newest = load64(oDrops);
-        s.drops_oldest = 0;
-        s.oversize = load64(oOver);
-        s.bytes_written = load64(oBWrite);
+        const uint64_t drops = drops_.load(std::memory_order_relaxed);
+        if (cfg_.drop_policy == DropPolicy::DropNewest) s.drops_newest = drops;
+        else s.drops_oldest = drops;
+        s.oversize = over_.load(std::memory_order_relaxed);
+        s.bytes_written = bwrite_.load(std::memory_order_relaxed);
         return s;
     }
     std::string Writer::mapping_name() const {
+#ifdef _WIN32
         std::string out; out.reserve(map_name_w_.size());
         for (wchar_t c : map_name_w_) out.push_back(static_cast<char>(c & 0x7F));
         return out;
+#else
+        return shm_name_;
+#endif
     }
 
     // --------- Reader ops ---------
     bool Reader::validate_header(uint64_t& outCap) const {
         if (!region_valid(base_)) return false;
-        if (load64(oMagic) != kMagic64) return false;
+        if (load64(oMagic, std::memory_order_acquire) != kMagic64) return false;
         if (load32(oABIVer) != kAbiVersion) return false;
         uint64_t c = load64(oCapacity);
         if (!c) return false;
@@ -289,6 +411,7 @@ namespace xmr {
         if (is_open()) close();
         cfg_ = cfg;
 
+#ifdef _WIN32
         std::wstring nameW = !cfg.nameW.empty() ? cfg.nameW : utf8_to_wide(cfg.name);
         std::wstring tokenW = !cfg.tokenW.empty() ? cfg.tokenW : utf8_to_wide(cfg.token);
         if (nameW.empty() || tokenW.empty()) throw std::runtime_error("XMemoryRing: Name/Token required");
@@ -299,17 +422,46 @@ namespace xmr {
         void* v = MapViewOfFile(h, FILE_MAP_ALL_ACCESS, 0, 0, 0);
         if (!v) { DWORD e = GetLastError(); CloseHandle(h); throw std::system_error((int)e, std::system_category(), "MapViewOfFile"); }
         hmap_ = h; base_ = v;
+#else
+        if (cfg.name.empty() || cfg.token.empty()) throw std::runtime_error("XMemoryRing: Name/Token required");
+        std::string shm_name = compose_shm_name(cfg.name, cfg.token);
+
+        // read-write: the reader publishes its tail in the header
+        int fd = shm_open(shm_name.c_str(), O_RDWR, 0);
+        if (fd < 0) { int e = errno; throw std::system_error(e, std::generic_category(), "shm_open " + shm_name); }
+        struct stat st {};
+        if (fstat(fd, &st) != 0 || static_cast<uint64_t>(st.st_size) < oHdrEnd + kMinCapacity) {
+            ::close(fd);
+            throw std::runtime_error("XMemoryRing: " + shm_name + " is not a ring");
+        }
+        void* v = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (v == MAP_FAILED) { int e = errno; ::close(fd); throw std::system_error(e, std::generic_category(), "mmap " + shm_name); }
+        fd_ = fd; base_ = v;
+        size_ = static_cast<size_t>(st.st_size);
+        shm_name_ = std::move(shm_name);
+#endif
 
         uint64_t cap = 0;
         if (!validate_header(cap)) { close(); throw std::runtime_error("XMemoryRing: header validation failed"); }
+#ifndef _WIN32
+        if (oHdrEnd + cap > size_) { close(); throw std::runtime_error("XMemoryRing: capacity exceeds the mapping"); }
+#endif
         cap_ = cap;
         data_ = reinterpret_cast<uint8_t*>(base_) + oHdrEnd;
+        head_cache_ = 0;
     }
 
     void Reader::close() noexcept {
+        if (base_) publish_counters();
+#ifdef _WIN32
         if (base_) { UnmapViewOfFile(base_); base_ = nullptr; }
         if (hmap_) { CloseHandle(hmap_); hmap_ = nullptr; }
         map_name_w_.clear();
+#else
+        if (base_) { munmap(base_, size_); base_ = nullptr; }
+        if (fd_ >= 0) { ::close(fd_); fd_ = -1; }
+        shm_name_.clear(); size_ = 0;
+#endif
         data_ = nullptr; cap_ = 0;
     }
 
@@ -321,76 +473,95 @@ namespace xmr {
         base_ = o.base_; o.base_ = nullptr;
         data_ = o.data_; o.data_ = nullptr;
         cap_ = o.cap_;  o.cap_ = 0;
+        head_cache_ = o.head_cache_;
+#ifdef _WIN32
         hmap_ = o.hmap_; o.hmap_ = nullptr;
         map_name_w_ = std::move(o.map_name_w_);
+#else
+        size_ = o.size_; o.size_ = 0;
+        fd_ = o.fd_; o.fd_ = -1;
+        shm_name_ = std::move(o.shm_name_); o.shm_name_.clear();
+#endif
         rs_ = o.rs_;
         cfg_ = std::move(o.cfg_);
         return *this;
     }
 
+    void Reader::publish_counters() const {
+        store64(oSleepC, rs_.sleeps);
+        store64(oBRead, rs_.bytes_read);
+    }
+    void Reader::copy_out(uint64_t at, size_t n, std::string& out) const {
+        out.resize(n);
+        if (!n) return;
+        size_t pos = static_cast<size_t>(at % cap_);
+        size_t first = (std::min)(n, static_cast<size_t>(cap_ - pos));
+        std::memcpy(&out[0], &data_[pos], first);
+        if (first < n) std::memcpy(&out[first], &data_[0], n - first);
+    }
+
     bool Reader::read(std::string& out) {
         for (;;) {
             if (read_nonblocking(out)) return true;
+            publish_counters();
             std::this_thread::sleep_for(cfg_.idle_sleep_us);
             rs_.sleeps++;
         }
     }
     bool Reader::read_nonblocking(std::string& out) {
         if (!base_) return false;
-        uint64_t head = load64(oHead);
-        uint64_t tail = load64(oTail);
-        if (tail == head) return false;
-
-        uint64_t used = head - tail;
-        uint64_t pos = tail % cap_;
-
-        if (cfg_.frame_mode == FrameMode::LengthPrefix) {
-            if (used < sizeof(uint32_t)) return false;
-            uint32_t le = 0;
-            std::memcpy(&le, &data_[pos], (std::min)((uint64_t)sizeof(uint32_t), used));
-            if (used < sizeof(uint32_t) + le) return false;
-            out.resize(le);
-            std::memcpy(&out[0], &data_[(pos + sizeof(uint32_t)) % cap_], le);
-            store64(oTail, tail + sizeof(uint32_t) + le);
-            store64(oBRead, load64(oBRead) + sizeof(uint32_t) + le);
-            rs_.bytes_read += sizeof(uint32_t) + le;
-            return true;
-        }
-        else {
-            size_t first = static_cast<size_t>(cap_ - pos);
-            if (first > used) first = (size_t)used;
-            const uint8_t* p1 = &data_[pos];
-            const uint8_t* nl = (const uint8_t*)memchr(p1, '\n', first);
-            if (nl) {
-                size_t n = (size_t)(nl - p1) + 1;
-                out.assign(reinterpret_cast<const char*>(p1), n);
-                store64(oTail, tail + n);
-                store64(oBRead, load64(oBRead) + n);
-                rs_.bytes_read += n;
-                return true;
+        for (;;) {
+            uint64_t tail = load64(oTail, std::memory_order_acquire);
+            // head is the writer's line: only reload it once the cached frames are consumed
+            if (tail >= head_cache_) {
+                head_cache_ = load64(oHead, std::memory_order_acquire);   // frame bytes are visible
+                if (tail >= head_cache_) return false;
+            }
+            uint64_t used = head_cache_ - tail;
+            size_t n = 0;
+
+            if (cfg_.frame_mode == FrameMode::LengthPrefix) {
+                uint32_t le = 0;
+                if (used >= sizeof(le)) {
+                    for (size_t k = 0; k < sizeof(le); ++k)
+                        reinterpret_cast<uint8_t*>(&le)[k] = data_[(tail + k) % cap_];
+                }
+                // frames are published whole: anything short was overwritten under a drop
+                if (used < sizeof(le) || used - sizeof(le) < le) {
+                    if (load64(oTail, std::memory_order_acquire) != tail) continue;
+                    return false;
+                }
+                copy_out(tail + sizeof(le), le, out);
+                n = sizeof(le) + le;
             }
-            size_t second = (size_t)(used - first);
-            if (second) {
-                const uint8_t* p2 = &data_[0];
-                const uint8_t* nl2 = (const uint8_t*)memchr(p2, '\n', second);
-                if (nl2) {
-                    size_t n2 = (size_t)(nl2 - p2) + 1;
-                    out.reserve(first + n2);
-                    out.assign(reinterpret_cast<const char*>(p1), first);
-                    out.append(reinterpret_cast<const char*>(p2), n2);
-                    store64(oTail, tail + first + n2);
-                    store64(oBRead, load64(oBRead) + first + n2);
-                    rs_.bytes_read += first + n2;
-                    return true;
+            else {
+                size_t pos = static_cast<size_t>(tail % cap_);
+                size_t first = static_cast<size_t>((std::min)(used, cap_ - pos));
+                const uint8_t* nl = static_cast<const uint8_t*>(std::memchr(&data_[pos], '\n', first));
+                if (nl) n = static_cast<size_t>(nl - &data_[pos]) + 1;
+                else if (used > first) {
+                    nl = static_cast<const uint8_t*>(std::memchr(&data_[0], '\n', static_cast<size_t>(used - first)));
+                    if (nl) n = first + static_cast<size_t>(nl - &data_[0]) + 1;
+                }
+                if (!n) {
+                    if (load64(oTail, std::memory_order_acquire) != tail) continue;
+                    return false;
                 }
+                copy_out(tail, n, out);
             }
+
+            // the writer moves the tail only to drop frames; if it did, what was copied may be torn
+            uint64_t expected = tail;
+            if (!cas64(oTail, expected, tail + n)) continue;
+            rs_.bytes_read += n;
+            return true;
         }
-        return false;
     }
     bool Reader::read_timeout(std::string& out, std::chrono::milliseconds timeout) {
         auto deadline = std::chrono::steady_clock::now() + timeout;
         while (std::chrono::steady_clock::now() < deadline) {
             if (read_nonblocking(out)) return true;
+            publish_counters();
             std::this_thread::sleep_for(cfg_.idle_sleep_us);
             rs_.sleeps++;
         }
@@ -414,9 +585,76 @@ namespace xmr {
     }
     ReaderStats Reader::stats() const { return rs_; }
     std::string Reader::mapping_name() const {
+#ifdef _WIN32
         std::string out; out.reserve(map_name_w_.size());
         for (wchar_t c : map_name_w_) out.push_back(static_cast<char>(c & 0x7F));
         return out;
+#else
+        return shm_name_;
+#endif
     }
 } // namespace xmr
-#endif
\ No newline at end of file
+
+// ---------------- --shm-read ----------------
+int RunShmRead(int argc, char* argv[]) {
+    std::string name, token;
+    bool quiet = false;
+    double secs = 0;
+    for (int i = 1; i < argc; ++i) {
+        std::string key = argv[i];
+        std::string val;
+        auto eq = key.find('=');
+        if (eq != std::string::npos) { val = key.substr(eq + 1); key = key.substr(0, eq); }
+        auto next = [&]() { if (val.empty() && i + 1 < argc) val = argv[++i]; return val; };
+        if (key == "--shm-read") name = next();
+        else if (key == "--token") token = next();
+        else if (key == "--quiet") quiet = true;
+        else if (key == "--secs") {
+            try { secs = std::stod(next()); }
+            catch (...) { std::cerr << "[FATAL] invalid value for --secs: " << val << "\n"; return 1; }
+        }
+        else { std::cerr << "[FATAL] unknown shm-read option " << key << "\n"; return 1; }
+    }
+    if (name.empty() || token.empty()) {
+        std::cerr << "[FATAL] --shm-read needs <ring-name> and --token <auth>\n";
+        return 1;
+    }
+
+    xmr::Reader r;
+    xmr::Config cfg;
+    cfg.name = name;
+    cfg.token = token;
+    cfg.frame_mode = xmr::FrameMode::Newline;
+    cfg.heartbeat_interval = std::chrono::nanoseconds(500'000'000);
+    try { r.open(cfg); }
+    catch (const std::exception& e) {
+        std::cerr << "[FATAL] cannot open ring: " << e.what() << "\n";
+        return 1;
+    }
+
+    std::cout.unsetf(std::ios::unitbuf);   // main sets unitbuf for interactive logging
+    uint64_t lines = 0;
+    bool writer_gone = false;
+    std::string line;
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(static_cast<long long>(secs * 1000));
+    while (secs <= 0 || std::chrono::steady_clock::now() < deadline) {
+        if (!r.read_timeout(line, std::chrono::milliseconds(100))) {
+            // writer closed or died: its heartbeat stops (nothing is left to read by now)
+            if (!r.alive()) { writer_gone = true; break; }
+            continue;
+        }
+        ++lines;
+        if (!quiet) std::cout << line;
+    }
+    std::cout.flush();
+
+    const xmr::ReaderStats st = r.stats();
+    std::ostringstream ss;
+    ss << "[READ] " << r.mapping_name() << " lines=" << lines << " bytes=" << st.bytes_read
+        << " sleeps=" << st.sleeps
+        << " heartbeat_age_ms=" << std::chrono::duration_cast<std::chrono::milliseconds>(r.heartbeat_age()).count();
+    if (writer_gone) ss << " (writer gone)";
+    std::cerr << ss.str() << "\n";
+    r.close();
+    return 0;
+}
@@ -13,22 +13,31 @@ namespace xmr {
 
     // ---- ABI ----
     static constexpr uint64_t kMagic64 = 0x4845524D53524E47ULL; // "HERMSRNG"
-    static constexpr uint32_t kAbiVersion = 2;
+    static constexpr uint32_t kAbiVersion = 3;
 
+    // Each group below has its own 128-byte block (a cache line plus the neighbour the adjacent
+    // line prefetcher pulls in), so writer and reader never store to the same line on the hot
+    // path. head/tail are published with release stores and read with acquire loads.
+
+    // identity (read-mostly) + heartbeat (writer's heartbeat thread only)
     static constexpr size_t oMagic = 0;
     static constexpr size_t oABIVer = 8;
     static constexpr size_t oFlags = 12;
     static constexpr size_t oCapacity = 16;
     static constexpr size_t oHeartbeat = 24;
 
+    // writer-owned
     static constexpr size_t oHead = 128;
-    static constexpr size_t oTail = oHead + 64;
-    static constexpr size_t oDrops = oTail + 64;
+    // reader-owned (the writer moves it only to drop the oldest frames, by CAS)
+    static constexpr size_t oTail = oHead + 128;
+    // writer counters, published lazily from the heartbeat thread
+    static constexpr size_t oDrops = oTail + 128;
     static constexpr size_t oOver = oDrops + 8;
-    static constexpr size_t oSleepC = oOver + 8;
-    static constexpr size_t oBWrite = oSleepC + 8;
-    static constexpr size_t oBRead = oBWrite + 8;
-    static constexpr size_t oHdrEnd = oBRead + 8 + 56; // 352
+    static constexpr size_t oBWrite = oOver + 8;
+    // reader counters, published when the reader goes idle
+    static constexpr size_t oSleepC = oDrops + 128;
+    static constexpr size_t oBRead = oSleepC + 8;
+    static constexpr size_t oHdrEnd = oSleepC + 128;   // 640
 
     // ---- enums ----
     enum class DropPolicy { DropNewest, DropOldest };
@@ -95,8 +104,14 @@ namespace xmr {
         void init_header(uint64_t cap) const;
         void start_hb(std::chrono::nanoseconds iv);
         void stop_hb();
-
-        uint64_t load64(size_t off) const; void store64(size_t off, uint64_t v) const;
+        void publish_counters() const;
+        void make_room(uint64_t need);
+        uint64_t frame_end(uint64_t from, uint64_t min_end) const;
+        void copy_in(uint64_t at, const uint8_t* src, size_t n);
+
+        uint64_t load64(size_t off, std::memory_order mo = std::memory_order_relaxed) const;
+        void store64(size_t off, uint64_t v, std::memory_order mo = std::memory_order_relaxed) const;
+        bool cas64(size_t off, uint64_t& expected, uint64_t v) const;
         uint32_t load32(size_t off) const; void store32(size_t off, uint32_t v) const;
 
     private:
@@ -105,9 +120,19 @@ namespace xmr {
         uint64_t cap_ = 0;
         size_t   size_ = 0;
 
+        // writer thread only: head it last published, tail as last seen (refreshed only when
+        // the cached free space is short)
+        uint64_t head_ = 0;
+        uint64_t tail_cache_ = 0;
+        // private counters (writer thread stores, heartbeat thread / stats() load)
+        std::atomic<uint64_t> drops_{ 0 }, over_{ 0 }, bwrite_{ 0 };
+
 #ifdef _WIN32
         void* hmap_ = nullptr;
         std::wstring map_name_w_;
+#else
+        int fd_ = -1;
+        std::string shm_name_;
 #endif
 
         std::thread hb_;
@@ -144,18 +169,27 @@ namespace xmr {
         static std::wstring compose_map_name_w(const std::wstring& name, const std::wstring& token);
 #endif
         bool validate_header(uint64_t& outCap) const;
+        void publish_counters() const;
+        void copy_out(uint64_t at, size_t n, std::string& out) const;
 
-        uint64_t load64(size_t off) const; void store64(size_t off, uint64_t v) const;
+        uint64_t load64(size_t off, std::memory_order mo = std::memory_order_relaxed) const;
+        void store64(size_t off, uint64_t v, std::memory_order mo = std::memory_order_relaxed) const;
+        bool cas64(size_t off, uint64_t& expected, uint64_t v) const;
         uint32_t load32(size_t off) const;
 
     private:
         void* base_ = nullptr;
         uint8_t* data_ = nullptr;
         uint64_t cap_ = 0;
+        size_t   size_ = 0;            // mapped bytes (POSIX)
+        uint64_t head_cache_ = 0;      // writer head as last seen (reloaded once caught up)
 
 #ifdef _WIN32
         void* hmap_ = nullptr;
         std::wstring map_name_w_;
+#else
+        int fd_ = -1;
+        std::string shm_name_;
 #endif
 
         mutable ReaderStats rs_{};
@@ -163,3 +197,9 @@ namespace xmr {
     };
 
 } // namespace xmr
+
+// HermesPortal --shm-read <ring-name> --token <auth> [--secs <n>] [--quiet]
+//   reference reader for --out shm from another process: lines on stdout, totals on stderr.
+//   Consumes the ring (advances its tail); stops when the writer's heartbeat goes stale.
+//   Returns the process exit code.
+int RunShmRead(int argc, char* argv[]);
@@ -14,6 +14,11 @@
 #include <cstring>
 #include <algorithm>
 #include <functional>
+#include <string_view>
+#include <charconv>
+#include <system_error>
+
+#include "record_meta.h"
 
 #ifdef _WIN32
 #define WIN32_LEAN_AND_MEAN
@@ -48,24 +53,88 @@ constexpr uint16_t ICODE_PN = MAKE_ICODE('P', 'N'); // 20-depth (Level 3)
 // ------------- Common message view ----------
 struct MessageView { const char* buf; int len; };
 
-// ------------- Console/Pluggable sink -------------
+// ------------- Fixed-buffer line builder -------------
+// Handlers format into this instead of an ostringstream: no allocation per line,
+// and fixed() prints exactly what floatToString(v, precision) prints.
+class LineBuilder {
+public:
+    LineBuilder& str(std::string_view s) { put(s.data(), s.size()); return *this; }
+    LineBuilder& ch(char c) { put(&c, 1); return *this; }
+    LineBuilder& u64(uint64_t v) { auto r = std::to_chars(buf_ + n_, buf_ + kCap, v); adv(r); return *this; }
+    LineBuilder& i64(int64_t v) { auto r = std::to_chars(buf_ + n_, buf_ + kCap, v); adv(r); return *this; }
+    LineBuilder& fixed(float v, int precision = 2) {
+        auto r = std::to_chars(buf_ + n_, buf_ + kCap, static_cast<double>(v), std::chars_format::fixed, precision);
+        adv(r); return *this;
+    }
+    std::string_view view() const { return std::string_view(buf_, n_); }
+    bool truncated() const { return truncated_; }
+private:
+    static constexpr size_t kCap = 1024;
+    void put(const char* p, size_t n) {
+        if (n > kCap - n_) { n = kCap - n_; truncated_ = true; }
+        std::memcpy(buf_ + n_, p, n); n_ += n;
+    }
+    void adv(const std::to_chars_result& r) {
+        if (r.ec == std::errc()) n_ = static_cast<size_t>(r.ptr - buf_);
+        else truncated_ = true;
+    }
+    char buf_[kCap];
+    size_t n_ = 0;
+    bool truncated_ = false;
+};
+
+// ------------- Sink registry -------------
+// Output fan-out: every line goes to each registered sink in turn (console, shm, file,
+// socket, mcast may be combined: --out shm,file,socket). Dispatch is a switch over concrete
+// sink types (see Sinks.cpp), so the hot path has no type-erased calls or allocations.
+// Each sink applies its own back-pressure policy; rejected lines are counted per sink.
+class FileWriter;
+class SocketRelay;
+class McastPublisher;
+class AsyncConsole;
+namespace xmr { class Writer; }
+
+enum class SinkKind : uint8_t { Console, Shm, File, Socket, Mcast };
+enum class BackPressure : uint8_t { DropNewest, DropOldest, Block };
+
+// One ConsoleSink per decode lane (lane 0 = receive thread; DecodePool workers get 1..N).
+// Registry calls are setup-time only (before the first packet / after the last one).
 class ConsoleSink {
 public:
-    // If set, all lines go to this writer (e.g., SHM). Should return true on success.
-    static inline void setExternal(std::function<bool(const std::string&)> fn) { s_extWriter = std::move(fn); }
+    static constexpr size_t kMaxSinks = 8;
+
+    explicit ConsoleSink(unsigned lane = 0) : lane_(lane) {}
+    unsigned lane() const { return lane_; }
+
+    // registry (impl in Sinks.cpp). A full sink applies the overflow policy of its own config
+    // (xmr::Config::drop_policy, FileWriter::set_overflow_policy, SocketRelay::Config::overflow);
+    // the registry only counts the lines it rejected.
+    static bool addConsole(AsyncConsole& con);     // buffered; drained by its own thread
+    static bool addShm(xmr::Writer& w);
+    static bool addFile(FileWriter& fw);
+    static bool addSocket(SocketRelay& relay);
+    static bool addMcast(McastPublisher& pub);      // drops when its datagram slots are full
+    static void clearSinks();
+    static size_t sinkCount();
+    static void printSinks(std::ostream& os);       // "console shm file socket mcast"
+    static void printSinkStats(std::ostream& os);   // per-sink rejected line counts
+
+    static const char* policyName(BackPressure p);
+    static bool parsePolicy(const std::string& s, BackPressure& out);
+
     static inline void setConsoleMirror(bool on) { s_consoleMirror = on; }
     static inline bool getConsoleMirror() { return s_consoleMirror; }
+    // With several lanes active, single-producer sinks (shm) are serialized.
+    static inline void setSerialized(bool on) { s_serialized = on; }
+    static inline bool serialized() { return s_serialized; }
+
+    // Fan one formatted line out to every registered sink.
+    void sendLine(std::string_view line, const RecordMeta& meta);
 
-    inline void sendLine(const std::string& line) {
-        if (s_extWriter) {
-            (void)s_extWriter(line);    // ignore failure; DROP-NEWEST expected policy
-            return;
-        }
-        if (s_consoleMirror) std::cout << line << "\n";
-    }
 private:
-    inline static bool s_consoleMirror = true; // C++17 inline var
-    inline static std::function<bool(const std::string&)> s_extWriter{}; // null => console
+    unsigned lane_ = 0;
+    inline static bool s_consoleMirror = false; // C++17 inline var; true while a console sink is registered
+    inline static bool s_serialized = false;    // set before decode workers start
 };
 
 // ------------- Strike filter ----------------
@@ -96,6 +165,9 @@ class IMessageHandler {
 public:
     virtual ~IMessageHandler() = default;
     virtual const std::vector<uint16_t>& transcodes() const = 0;
+    // Fixed per-record size for FO broadcast messages (count at BASE+40, records from
+    // BASE+42, token first). Lets DecodePool split a sub-packet per token; 0 => single record.
+    virtual int recordBytes() const { return 0; }
     virtual void handle(const MessageView& mv,
         ConsoleSink& out,
         InstrumentDirectory* instDir,
@@ -121,18 +193,31 @@ namespace Lzo {
     bool Init();
     bool Decompress(const unsigned char* in, std::size_t inLen,
         unsigned char* out, std::size_t outCap, std::size_t& outLen);
+
+    // LZO1X-1 (historical block files, see HistBlocks.h)
+    std::size_t CompressWorkMem();
+    std::size_t CompressBound(std::size_t inLen);
+    bool Compress1X(const unsigned char* in, std::size_t inLen,
+        unsigned char* out, std::size_t outCap, std::size_t& outLen, void* workMem);
+    bool Decompress1X(const unsigned char* in, std::size_t inLen,
+        unsigned char* out, std::size_t outCap, std::size_t& outLen);
 }
 
 // ------------- PacketParser (decl; impl in parser.cpp) ---
+class DecodePool;
+
 class PacketParser {
 public:
     explicit PacketParser(PacketDispatcher& d) : disp_(d) {}
+    // When set, decompressed messages are handed to the pool instead of being handled inline.
+    void setDecodePool(DecodePool* pool) { pool_ = pool; }
     void parse(const char* buf, int len, ConsoleSink& out,
         InstrumentDirectory* instDir, const StrikeList& strikes);
     void parseCM(const uint8_t* buf, size_t len, ConsoleSink& out,
         InstrumentDirectory* instDir, const StrikeList& strikes);
 private:
     PacketDispatcher& disp_;
+    DecodePool* pool_ = nullptr;
     // working buffer for CM decompression
     std::vector<unsigned char> cm_decomp_buf_;
 };
@@ -145,6 +230,8 @@ class Handler7208 : public IMessageHandler {
 public:
     Handler7208() : codes_{ 7208 } {}
     const std::vector<uint16_t>& transcodes() const override { return codes_; }
+    static constexpr int kRecordBytes = 214;
+    int recordBytes() const override { return kRecordBytes; }
     void handle(const MessageView& mv, ConsoleSink& out,
         InstrumentDirectory* instDir, const StrikeList& strikes) override;
 private:
@@ -155,6 +242,8 @@ class Handler7202 : public IMessageHandler {
 public:
     Handler7202() : codes_{ 7202 } {}
     const std::vector<uint16_t>& transcodes() const override { return codes_; }
+    static constexpr int kRecordBytes = 26;
+    int recordBytes() const override { return kRecordBytes; }
     void handle(const MessageView& mv, ConsoleSink& out,
         InstrumentDirectory* instDir, const StrikeList& strikes) override;
 private:
@@ -0,0 +1,12 @@
+#pragma once
+// RecordMeta: what a formatted output line is, as known by the handler that built it.
+// Travels next to the CSV payload to every sink so nobody has to re-split the line.
+
+#include <cstdint>
+
+struct RecordMeta {
+    uint32_t token = 0;
+    uint16_t type = 0;      // 7208 / 7202 / ICODE_CT / ICODE_PN
+    uint16_t market = 0;    // 7202: market type (CSV field 2); 0 otherwise
+    uint32_t exch_time = 0; // 7208: exchange time as unix seconds (CSV field 10); 0 otherwise
+};